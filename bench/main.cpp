@@ -0,0 +1,351 @@
+// Замеры вычислительных ядер лабораторных: кривая Безье, генерация сфер, матрицы камеры,
+// преобразования вершин, нормали, BVH для выбора мышью и сжатие мешей. Каждый замер калибрует число повторов под минимальное
+// время выборки, снимает несколько выборок и печатает медиану и разброс времени на операцию.
+//
+//   ./bench.out [--filter подстрока] [--format text|json|csv] [--out файл]
+//               [--samples n] [--min-time мс]
+//
+// JSON и CSV предназначены для сравнения прогонов: в них записаны коммит, сборка и компилятор.
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <functional>
+#include <string>
+#include <vector>
+#include "../common/args.hpp"
+#include "../common/bezier.hpp"
+#include "../common/bvh.hpp"
+#include "../common/mesh_codec.hpp"
+#include "../common/normals.hpp"
+#include "../common/sphere.hpp"
+#include "../common/transforms.hpp"
+
+#ifndef BENCH_BUILD
+#define BENCH_BUILD "custom"
+#endif
+#ifndef BENCH_COMMIT
+#define BENCH_COMMIT "unknown"
+#endif
+
+using Clock = std::chrono::steady_clock;
+
+// Не даёт компилятору выбросить вычисление, результат которого никто не читает
+template <typename T>
+inline void doNotOptimize(const T& value) {
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+struct Benchmark {
+    std::string name;
+    size_t itemsPerOp; // вершин, точек или матриц за одну операцию
+    std::function<void()> op;
+};
+
+struct BenchmarkResult {
+    std::string name;
+    size_t itemsPerOp = 1;
+    size_t iterations = 0; // операций в одной выборке
+    int samples = 0;
+    double medianNs = 0.0; // время одной операции
+    double minNs = 0.0;
+    double meanNs = 0.0;
+    double stddevNs = 0.0;
+};
+
+struct BenchOptions {
+    std::string filter;
+    std::string format = "text";
+    std::string outPath;
+    int samples = 15;
+    double minSampleMs = 20.0;
+};
+
+double runIterations(const Benchmark& benchmark, size_t iterations) {
+    auto start = Clock::now();
+    for (size_t i = 0; i < iterations; ++i)
+        benchmark.op();
+    return std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+}
+
+BenchmarkResult runBenchmark(const Benchmark& benchmark, const BenchOptions& options) {
+    // Калибровка: удваиваем повторы, пока выборка не станет длиннее минимального времени
+    double minSampleNs = options.minSampleMs * 1.0e6;
+    size_t iterations = 1;
+    for (;;) {
+        double elapsed = runIterations(benchmark, iterations);
+        if (elapsed >= minSampleNs)
+            break;
+        double scale = elapsed > 0.0 ? minSampleNs / elapsed : 2.0;
+        iterations = std::max(iterations + 1, (size_t)(iterations * std::min(scale * 1.2, 10.0)));
+    }
+
+    std::vector<double> perOp;
+    for (int sample = 0; sample < options.samples; ++sample)
+        perOp.push_back(runIterations(benchmark, iterations) / iterations);
+    std::sort(perOp.begin(), perOp.end());
+
+    BenchmarkResult result;
+    result.name = benchmark.name;
+    result.itemsPerOp = benchmark.itemsPerOp;
+    result.iterations = iterations;
+    result.samples = options.samples;
+    result.medianNs = perOp[perOp.size() / 2];
+    result.minNs = perOp.front();
+    for (double ns : perOp)
+        result.meanNs += ns;
+    result.meanNs /= perOp.size();
+    for (double ns : perOp)
+        result.stddevNs += (ns - result.meanNs) * (ns - result.meanNs);
+    result.stddevNs = std::sqrt(result.stddevNs / perOp.size());
+    return result;
+}
+
+// Входные данные создаются один раз и живут до конца программы
+struct BenchData {
+    std::vector<glm::vec2> controlPoints;
+    std::vector<glm::vec2> curve;
+
+    std::vector<glm::vec3> eyes;
+    std::vector<glm::mat4> matrices;
+
+    std::vector<GLfloat> sphereVertices; // позиция и нормаль, как в generateSphere
+    std::vector<GLuint> sphereIndices;
+    std::vector<glm::vec3> transformed;
+    std::vector<GLfloat> normals;
+    std::vector<glm::vec3> faceNormals;
+
+    std::vector<Aabb> triangleBoxes;
+    std::vector<Aabb> scaledBoxes; // те же треугольники, растянутые вдвое: вход для refit
+    Bvh bvh;
+    std::vector<Ray> rays;
+
+    MeshData sphereMesh; // та же сфера для сжатия
+    std::vector<uint8_t> packedMesh;
+    MeshData unpackedMesh;
+};
+
+std::vector<Benchmark> makeBenchmarks(BenchData& data) {
+    data.controlPoints = { { 100, 100 }, { 200, 500 }, { 600, 500 }, { 700, 100 } };
+    data.curve.resize(100);
+
+    // Разные входы на каждый вызов, чтобы результат нельзя было вынести из цикла
+    const size_t matrixBatch = 1024;
+    for (size_t i = 0; i < matrixBatch; ++i) {
+        float angle = i * 0.01f;
+        data.eyes.push_back(glm::vec3(5.0f * std::cos(angle), 1.0f + 0.001f * i, 5.0f * std::sin(angle)));
+    }
+    data.matrices.resize(matrixBatch);
+
+    generateSphere(data.sphereVertices, data.sphereIndices, 1.0f, 288, 144);
+    size_t vertexCount = data.sphereVertices.size() / 6;
+    data.transformed.resize(vertexCount);
+    data.normals.resize(vertexCount * 3);
+
+    glm::mat4 model = translateMatrix(glm::vec3(0.5f, -1.0f, 2.0f)) * scaleMatrix(1.5f, 1.5f, 0.75f);
+    glm::mat3 normalTransform = normalMatrix(model);
+
+    std::vector<Benchmark> benchmarks;
+    benchmarks.push_back({ "bezier/curve100", data.curve.size(), [&data]() {
+        const std::vector<glm::vec2>& p = data.controlPoints;
+        for (size_t i = 0; i < data.curve.size(); ++i) {
+            float t = (float)i / (data.curve.size() - 1);
+            data.curve[i] = calculateBezierPoint(t, p[0], p[1], p[2], p[3]);
+        }
+        doNotOptimize(data.curve.data());
+    } });
+
+    // 36x18 — сфера лабораторной 2 по умолчанию, 288x144 — наибольшая детализация
+    for (int detail : { 0, 3 }) {
+        int sectors = 36 << detail;
+        int stacks = 18 << detail;
+        std::string name = "sphere/generateSphere/" + std::to_string(sectors) + "x" + std::to_string(stacks);
+        benchmarks.push_back({ name, (size_t)(sectors + 1) * (stacks + 1), [sectors, stacks]() {
+            std::vector<GLfloat> vertices;
+            std::vector<GLuint> indices;
+            generateSphere(vertices, indices, 1.0f, sectors, stacks);
+            doNotOptimize(vertices.data());
+            doNotOptimize(indices.data());
+        } });
+    }
+    for (int segments : { 50, 400 }) {
+        benchmarks.push_back({ "sphere/generateSphereVertices/" + std::to_string(segments), (size_t)(segments + 1) * (segments + 1), [segments]() {
+            std::vector<float> vertices = generateSphereVertices(1.0f, segments);
+            doNotOptimize(vertices.data());
+        } });
+    }
+
+    benchmarks.push_back({ "camera/lookAt", matrixBatch, [&data]() {
+        for (size_t i = 0; i < data.eyes.size(); ++i)
+            data.matrices[i] = lookAt(data.eyes[i], glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+        doNotOptimize(data.matrices.data());
+    } });
+    benchmarks.push_back({ "camera/perspective", matrixBatch, [&data]() {
+        for (size_t i = 0; i < data.eyes.size(); ++i)
+            data.matrices[i] = perspective(glm::radians(45.0f), 1.0f + data.eyes[i].y * 0.1f, 0.1f, 100.0f);
+        doNotOptimize(data.matrices.data());
+    } });
+
+    benchmarks.push_back({ "transform/positions", vertexCount, [&data, model, vertexCount]() {
+        for (size_t v = 0; v < vertexCount; ++v)
+            data.transformed[v] = transformPosition(model, &data.sphereVertices[v * 6]);
+        doNotOptimize(data.transformed.data());
+    } });
+    benchmarks.push_back({ "transform/normals", vertexCount, [&data, normalTransform, vertexCount]() {
+        for (size_t v = 0; v < vertexCount; ++v)
+            data.transformed[v] = transformNormal(normalTransform, &data.sphereVertices[v * 6 + 3]);
+        doNotOptimize(data.transformed.data());
+    } });
+
+    benchmarks.push_back({ "normals/face", data.sphereIndices.size() / 3, [&data]() {
+        computeFaceNormals(data.sphereVertices.data(), 6, data.sphereIndices, data.faceNormals);
+        doNotOptimize(data.faceNormals.data());
+    } });
+    benchmarks.push_back({ "normals/vertex/area", vertexCount, [&data, vertexCount]() {
+        computeVertexNormals(data.sphereVertices.data(), 6, vertexCount, data.sphereIndices, NormalWeighting::Area, data.normals.data(), 3);
+        doNotOptimize(data.normals.data());
+    } });
+    benchmarks.push_back({ "normals/vertex/angle", vertexCount, [&data, vertexCount]() {
+        computeVertexNormals(data.sphereVertices.data(), 6, vertexCount, data.sphereIndices, NormalWeighting::Angle, data.normals.data(), 3);
+        doNotOptimize(data.normals.data());
+    } });
+
+    // Лучи из точки перед сферой веером, примерно половина попадает
+    triangleBounds(data.sphereVertices.data(), 6, data.sphereIndices, data.triangleBoxes);
+    for (const Aabb& box : data.triangleBoxes)
+        data.scaledBoxes.push_back({ box.min * 2.0f, box.max * 2.0f });
+    buildBvh(data.bvh, data.triangleBoxes);
+    const size_t rayBatch = 1024;
+    for (size_t i = 0; i < rayBatch; ++i) {
+        float angle = i * 0.37f;
+        float spread = 0.3f * (float)i / rayBatch;
+        data.rays.push_back({ glm::vec3(0.1f, 0.2f, 5.0f), glm::vec3(spread * std::cos(angle), spread * std::sin(angle), -1.0f) });
+    }
+
+    benchmarks.push_back({ "bvh/build/triangles", data.triangleBoxes.size(), [&data]() {
+        Bvh bvh;
+        buildBvh(bvh, data.triangleBoxes);
+        doNotOptimize(bvh.nodes.data());
+    } });
+    benchmarks.push_back({ "bvh/refit/triangles", data.triangleBoxes.size(), [&data]() {
+        refitBvh(data.bvh, data.scaledBoxes);
+        refitBvh(data.bvh, data.triangleBoxes);
+        doNotOptimize(data.bvh.nodes.data());
+    } });
+    benchmarks.push_back({ "bvh/raycast/triangles", rayBatch, [&data]() {
+        const GLfloat* positions = data.sphereVertices.data();
+        const GLuint* indices = data.sphereIndices.data();
+        auto corner = [positions](GLuint vertex) {
+            return glm::vec3(positions[vertex * 6], positions[vertex * 6 + 1], positions[vertex * 6 + 2]);
+        };
+        for (const Ray& ray : data.rays) {
+            RayHit hit = raycastBvh(data.bvh, ray, [&](uint32_t t, float) {
+                return intersectTriangle(ray, corner(indices[t * 3]), corner(indices[t * 3 + 1]), corner(indices[t * 3 + 2]));
+            });
+            doNotOptimize(hit);
+        }
+    } });
+
+    data.sphereMesh.vertices = data.sphereVertices;
+    data.sphereMesh.indices = data.sphereIndices;
+    data.sphereMesh.boundsMin = glm::vec3(-1.0f);
+    data.sphereMesh.boundsMax = glm::vec3(1.0f);
+    encodeMesh(data.sphereMesh, data.packedMesh);
+
+    benchmarks.push_back({ "mesh/encode/sphere", vertexCount, [&data]() {
+        std::vector<uint8_t> packed;
+        encodeMesh(data.sphereMesh, packed);
+        doNotOptimize(packed.data());
+    } });
+    // Буфер результата переиспользуется, как при повторной загрузке модели
+    benchmarks.push_back({ "mesh/decode/sphere", vertexCount, [&data]() {
+        decodeMesh(data.packedMesh.data(), data.packedMesh.size(), data.unpackedMesh);
+        doNotOptimize(data.unpackedMesh.vertices.data());
+    } });
+
+    return benchmarks;
+}
+
+std::string timestamp() {
+    char buffer[32];
+    std::time_t now = std::time(nullptr);
+    std::strftime(buffer, sizeof(buffer), "%Y-%m-%dT%H:%M:%SZ", std::gmtime(&now));
+    return buffer;
+}
+
+void writeText(FILE* out, const std::vector<BenchmarkResult>& results) {
+    std::fprintf(out, "%-36s %12s %12s %8s %14s\n", "benchmark", "median ns", "min ns", "cv %", "items/s");
+    for (const BenchmarkResult& r : results) {
+        double cv = r.meanNs > 0.0 ? r.stddevNs / r.meanNs * 100.0 : 0.0;
+        std::fprintf(out, "%-36s %12.1f %12.1f %8.2f %14.4g\n", r.name.c_str(), r.medianNs, r.minNs, cv, r.itemsPerOp / r.medianNs * 1.0e9);
+    }
+}
+
+void writeJson(FILE* out, const std::vector<BenchmarkResult>& results) {
+    std::fprintf(out, "{\n  \"commit\": \"%s\",\n  \"build\": \"%s\",\n  \"compiler\": \"%s\",\n  \"timestamp\": \"%s\",\n  \"benchmarks\": [\n",
+                 BENCH_COMMIT, BENCH_BUILD, __VERSION__, timestamp().c_str());
+    for (size_t i = 0; i < results.size(); ++i) {
+        const BenchmarkResult& r = results[i];
+        std::fprintf(out, "    {\"name\": \"%s\", \"items_per_op\": %zu, \"iterations\": %zu, \"samples\": %d, "
+                          "\"median_ns\": %.3f, \"min_ns\": %.3f, \"mean_ns\": %.3f, \"stddev_ns\": %.3f}%s\n",
+                     r.name.c_str(), r.itemsPerOp, r.iterations, r.samples, r.medianNs, r.minNs, r.meanNs, r.stddevNs,
+                     i + 1 < results.size() ? "," : "");
+    }
+    std::fprintf(out, "  ]\n}\n");
+}
+
+void writeCsv(FILE* out, const std::vector<BenchmarkResult>& results) {
+    std::string stamp = timestamp();
+    std::fprintf(out, "commit,build,timestamp,name,items_per_op,iterations,samples,median_ns,min_ns,mean_ns,stddev_ns\n");
+    for (const BenchmarkResult& r : results) {
+        std::fprintf(out, "%s,%s,%s,%s,%zu,%zu,%d,%.3f,%.3f,%.3f,%.3f\n", BENCH_COMMIT, BENCH_BUILD, stamp.c_str(),
+                     r.name.c_str(), r.itemsPerOp, r.iterations, r.samples, r.medianNs, r.minNs, r.meanNs, r.stddevNs);
+    }
+}
+
+int main(int argc, char** argv) {
+    BenchOptions options;
+    options.filter = getArg(argc, argv, "--filter", "");
+    options.format = getArg(argc, argv, "--format", "text");
+    options.outPath = getArg(argc, argv, "--out", "");
+    options.samples = std::max(1, std::atoi(getArg(argc, argv, "--samples", "15").c_str()));
+    options.minSampleMs = std::max(0.01, std::atof(getArg(argc, argv, "--min-time", "20").c_str()));
+    if (options.format != "text" && options.format != "json" && options.format != "csv") {
+        std::fprintf(stderr, "Unknown format %s, expected text, json or csv\n", options.format.c_str());
+        return 1;
+    }
+
+    BenchData data;
+    std::vector<Benchmark> benchmarks = makeBenchmarks(data);
+
+    std::vector<BenchmarkResult> results;
+    for (const Benchmark& benchmark : benchmarks) {
+        if (!options.filter.empty() && benchmark.name.find(options.filter) == std::string::npos)
+            continue;
+        results.push_back(runBenchmark(benchmark, options));
+        // Ход выполнения в stderr, чтобы stdout оставался чистым для json и csv
+        std::fprintf(stderr, "%s: %.1f ns\n", results.back().name.c_str(), results.back().medianNs);
+    }
+
+    FILE* out = stdout;
+    if (!options.outPath.empty()) {
+        out = std::fopen(options.outPath.c_str(), "w");
+        if (!out) {
+            std::fprintf(stderr, "Failed to open %s\n", options.outPath.c_str());
+            return 1;
+        }
+    }
+    if (options.format == "json")
+        writeJson(out, results);
+    else if (options.format == "csv")
+        writeCsv(out, results);
+    else
+        writeText(out, results);
+    if (out != stdout)
+        std::fclose(out);
+    return 0;
+}
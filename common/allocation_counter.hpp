@@ -0,0 +1,8 @@
+#pragma once
+
+#include <cstdint>
+
+// Глобальные operator new и delete заменены счётчиками поверх malloc: число выделений кучи
+// с запуска программы во всех потоках. Разница между кадрами показывает, трогает ли
+// установившийся кадр кучу.
+uint64_t heapAllocationCount();
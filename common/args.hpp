@@ -0,0 +1,22 @@
+#pragma once
+
+#include <cstring>
+#include <string>
+
+// Проверка флага командной строки вида --name
+inline bool hasArg(int argc, char** argv, const char* name) {
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], name) == 0)
+            return true;
+    }
+    return false;
+}
+
+// Значение аргумента вида --name value или defaultValue, если его нет
+inline std::string getArg(int argc, char** argv, const char* name, const std::string& defaultValue = "") {
+    for (int i = 1; i + 1 < argc; ++i) {
+        if (std::strcmp(argv[i], name) == 0)
+            return argv[i + 1];
+    }
+    return defaultValue;
+}
@@ -0,0 +1,19 @@
+#pragma once
+
+// Точка кубической кривой Безье при параметре t из [0, 1]. Vector — любой двумерный вектор
+// с умножением на float и сложением: sf::Vector2f в лабораторной, glm::vec2 в замерах.
+template <typename Vector>
+Vector calculateBezierPoint(float t, const Vector& p0, const Vector& p1, const Vector& p2, const Vector& p3) {
+    float u = 1 - t;
+    float tt = t * t;
+    float uu = u * u;
+    float uuu = uu * u;
+    float ttt = tt * t;
+
+    Vector p = uuu * p0;
+    p += 3 * uu * t * p1;
+    p += 3 * u * tt * p2;
+    p += ttt * p3;
+
+    return p;
+}
@@ -0,0 +1,271 @@
+#include "bvh.hpp"
+#include "profiler.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+namespace {
+
+const int binCount = 16;
+const uint32_t maxLeafSize = 8;   // больше примитивов в листе только при невозможности разбить
+const float traversalCost = 1.0f; // в единицах проверки одного примитива
+const int maxDepth = 48;          // стек обхода вмещает maxDepth + 1 узел
+const int traversalStackSize = 64;
+
+struct Bin {
+    Aabb bounds;
+    uint32_t count = 0;
+};
+
+struct Split {
+    int axis = -1;
+    int bin = 0;           // в левую часть идут корзины [0, bin]
+    float cost = noHitDistance;
+};
+
+int binIndex(float centroid, float minimum, float scale) {
+    return std::min(binCount - 1, (int)((centroid - minimum) * scale));
+}
+
+// Стоимость без деления на площадь узла: сумма площадей детей, умноженных на число примитивов
+Split findSplit(const Bvh& bvh, const BvhNode& node, const std::vector<glm::vec3>& centroids,
+                const std::vector<Aabb>& bounds, const Aabb& centroidBounds) {
+    Split best;
+    for (int axis = 0; axis < 3; ++axis) {
+        float minimum = centroidBounds.min[axis];
+        float extent = centroidBounds.max[axis] - minimum;
+        if (extent <= 0.0f)
+            continue;
+        float scale = binCount / extent;
+
+        Bin bins[binCount];
+        for (uint32_t i = node.first; i < node.first + node.count; ++i) {
+            uint32_t primitive = bvh.primitives[i];
+            Bin& bin = bins[binIndex(centroids[primitive][axis], minimum, scale)];
+            growAabb(bin.bounds, bounds[primitive]);
+            ++bin.count;
+        }
+
+        // Проход слева запоминает левые части, проход справа сразу считает стоимость
+        float leftArea[binCount - 1];
+        uint32_t leftCount[binCount - 1];
+        Aabb left;
+        uint32_t count = 0;
+        for (int i = 0; i < binCount - 1; ++i) {
+            growAabb(left, bins[i].bounds);
+            count += bins[i].count;
+            leftArea[i] = aabbHalfArea(left);
+            leftCount[i] = count;
+        }
+        Aabb right;
+        count = 0;
+        for (int i = binCount - 1; i > 0; --i) {
+            growAabb(right, bins[i].bounds);
+            count += bins[i].count;
+            if (leftCount[i - 1] == 0 || count == 0)
+                continue;
+            float cost = leftArea[i - 1] * leftCount[i - 1] + aabbHalfArea(right) * count;
+            if (cost < best.cost)
+                best = { axis, i - 1, cost };
+        }
+    }
+    return best;
+}
+
+float intersectAabb(const Aabb& box, const Ray& ray, const glm::vec3& inverseDirection, float maxDistance) {
+    glm::vec3 t1 = (box.min - ray.origin) * inverseDirection;
+    glm::vec3 t2 = (box.max - ray.origin) * inverseDirection;
+    glm::vec3 near = glm::min(t1, t2);
+    glm::vec3 far = glm::max(t1, t2);
+    float enter = std::max(std::max(near.x, near.y), std::max(near.z, 0.0f));
+    float exit = std::min(std::min(far.x, far.y), std::min(far.z, maxDistance));
+    return enter <= exit ? enter : noHitDistance;
+}
+
+} // namespace
+
+Aabb transformAabb(const Aabb& box, const glm::mat4& matrix) {
+    glm::vec3 center = (box.min + box.max) * 0.5f;
+    glm::vec3 extent = (box.max - box.min) * 0.5f;
+    glm::vec3 worldCenter = glm::vec3(matrix * glm::vec4(center, 1.0f));
+    glm::vec3 worldExtent = glm::abs(glm::vec3(matrix[0])) * extent.x + glm::abs(glm::vec3(matrix[1])) * extent.y +
+                            glm::abs(glm::vec3(matrix[2])) * extent.z;
+    return { worldCenter - worldExtent, worldCenter + worldExtent };
+}
+
+void buildBvh(Bvh& bvh, const std::vector<Aabb>& bounds) {
+    PROFILE_ZONE("Build BVH");
+    uint32_t primitiveCount = (uint32_t)bounds.size();
+    bvh.nodes.clear();
+    bvh.primitives.resize(primitiveCount);
+    std::iota(bvh.primitives.begin(), bvh.primitives.end(), 0u);
+    if (primitiveCount == 0)
+        return;
+
+    std::vector<glm::vec3> centroids(primitiveCount);
+    for (uint32_t i = 0; i < primitiveCount; ++i)
+        centroids[i] = (bounds[i].min + bounds[i].max) * 0.5f;
+
+    bvh.nodes.reserve(2 * (size_t)primitiveCount - 1);
+    bvh.nodes.push_back({ Aabb(), 0, primitiveCount });
+
+    struct Pending {
+        uint32_t node;
+        int depth;
+    };
+    std::vector<Pending> pending = { { 0, 0 } };
+    while (!pending.empty()) {
+        Pending current = pending.back();
+        pending.pop_back();
+        BvhNode node = bvh.nodes[current.node];
+
+        Aabb nodeBounds, centroidBounds;
+        for (uint32_t i = node.first; i < node.first + node.count; ++i) {
+            growAabb(nodeBounds, bounds[bvh.primitives[i]]);
+            growAabb(centroidBounds, centroids[bvh.primitives[i]]);
+        }
+        bvh.nodes[current.node].bounds = nodeBounds;
+        if (node.count == 1 || current.depth >= maxDepth)
+            continue;
+
+        // Лист дешевле разбиения — остаётся листом, если не слишком велик
+        Split split = findSplit(bvh, node, centroids, bounds, centroidBounds);
+        if (split.axis < 0)
+            continue;
+        float leafCost = (node.count - traversalCost) * aabbHalfArea(nodeBounds);
+        if (split.cost >= leafCost && node.count <= maxLeafSize)
+            continue;
+
+        float minimum = centroidBounds.min[split.axis];
+        float scale = binCount / (centroidBounds.max[split.axis] - minimum);
+        uint32_t* begin = bvh.primitives.data() + node.first;
+        uint32_t* middle = std::partition(begin, begin + node.count, [&](uint32_t primitive) {
+            return binIndex(centroids[primitive][split.axis], minimum, scale) <= split.bin;
+        });
+        uint32_t leftCount = (uint32_t)(middle - begin);
+
+        uint32_t left = (uint32_t)bvh.nodes.size();
+        bvh.nodes.push_back({ Aabb(), node.first, leftCount });
+        bvh.nodes.push_back({ Aabb(), node.first + leftCount, node.count - leftCount });
+        bvh.nodes[current.node].first = left;
+        bvh.nodes[current.node].count = 0;
+        pending.push_back({ left, current.depth + 1 });
+        pending.push_back({ left + 1, current.depth + 1 });
+    }
+}
+
+void refitBvh(Bvh& bvh, const std::vector<Aabb>& bounds) {
+    PROFILE_ZONE("Refit BVH");
+    for (size_t i = bvh.nodes.size(); i-- > 0;) {
+        BvhNode& node = bvh.nodes[i];
+        Aabb refitted;
+        if (node.count > 0) {
+            for (uint32_t p = node.first; p < node.first + node.count; ++p)
+                growAabb(refitted, bounds[bvh.primitives[p]]);
+        } else {
+            growAabb(refitted, bvh.nodes[node.first].bounds);
+            growAabb(refitted, bvh.nodes[node.first + 1].bounds);
+        }
+        node.bounds = refitted;
+    }
+}
+
+RayHit raycastBvh(const Bvh& bvh, const Ray& ray, FunctionRef<float(uint32_t primitive, float maxDistance)> intersect,
+                  float maxDistance) {
+    RayHit hit;
+    hit.distance = maxDistance;
+    if (bvh.nodes.empty())
+        return hit;
+
+    glm::vec3 inverseDirection = glm::vec3(1.0f) / ray.direction;
+    struct Entry {
+        uint32_t node;
+        float distance;
+    };
+    Entry stack[traversalStackSize];
+    int size = 0;
+    float rootDistance = intersectAabb(bvh.nodes[0].bounds, ray, inverseDirection, hit.distance);
+    if (rootDistance != noHitDistance)
+        stack[size++] = { 0, rootDistance };
+
+    while (size > 0) {
+        Entry entry = stack[--size];
+        if (entry.distance > hit.distance)
+            continue;
+        const BvhNode& node = bvh.nodes[entry.node];
+        if (node.count > 0) {
+            for (uint32_t i = node.first; i < node.first + node.count; ++i) {
+                uint32_t primitive = bvh.primitives[i];
+                float distance = intersect(primitive, hit.distance);
+                if (distance < hit.distance)
+                    hit = { primitive, distance };
+            }
+            continue;
+        }
+
+        // Ближний ребёнок кладётся последним и обходится первым
+        float nearDistance = intersectAabb(bvh.nodes[node.first].bounds, ray, inverseDirection, hit.distance);
+        float farDistance = intersectAabb(bvh.nodes[node.first + 1].bounds, ray, inverseDirection, hit.distance);
+        uint32_t nearNode = node.first;
+        uint32_t farNode = node.first + 1;
+        if (farDistance < nearDistance) {
+            std::swap(nearDistance, farDistance);
+            std::swap(nearNode, farNode);
+        }
+        if (farDistance != noHitDistance)
+            stack[size++] = { farNode, farDistance };
+        if (nearDistance != noHitDistance)
+            stack[size++] = { nearNode, nearDistance };
+    }
+    if (hit.primitive == noHitPrimitive)
+        hit.distance = noHitDistance;
+    return hit;
+}
+
+void triangleBounds(const GLfloat* positions, size_t stride, const std::vector<GLuint>& indices, std::vector<Aabb>& bounds) {
+    bounds.resize(indices.size() / 3);
+    for (size_t t = 0; t < bounds.size(); ++t) {
+        Aabb box;
+        for (int corner = 0; corner < 3; ++corner) {
+            const GLfloat* p = positions + indices[t * 3 + corner] * stride;
+            growAabb(box, glm::vec3(p[0], p[1], p[2]));
+        }
+        bounds[t] = box;
+    }
+}
+
+float intersectTriangle(const Ray& ray, const glm::vec3& a, const glm::vec3& b, const glm::vec3& c) {
+    glm::vec3 edge1 = b - a;
+    glm::vec3 edge2 = c - a;
+    glm::vec3 p = glm::cross(ray.direction, edge2);
+    float determinant = glm::dot(edge1, p);
+    if (std::fabs(determinant) < 1e-12f)
+        return noHitDistance;
+
+    float inverse = 1.0f / determinant;
+    glm::vec3 s = ray.origin - a;
+    float u = glm::dot(s, p) * inverse;
+    if (u < 0.0f || u > 1.0f)
+        return noHitDistance;
+    glm::vec3 q = glm::cross(s, edge1);
+    float v = glm::dot(ray.direction, q) * inverse;
+    if (v < 0.0f || u + v > 1.0f)
+        return noHitDistance;
+    float t = glm::dot(edge2, q) * inverse;
+    return t >= 0.0f ? t : noHitDistance;
+}
+
+Ray screenRay(float x, float y, float width, float height, const glm::mat4& projection, const glm::mat4& view) {
+    glm::mat4 inverse = glm::inverse(projection * view);
+    float ndcX = 2.0f * x / width - 1.0f;
+    float ndcY = 1.0f - 2.0f * y / height;
+    glm::vec4 near = inverse * glm::vec4(ndcX, ndcY, -1.0f, 1.0f);
+    glm::vec4 far = inverse * glm::vec4(ndcX, ndcY, 1.0f, 1.0f);
+    glm::vec3 origin = glm::vec3(near) / near.w;
+    return { origin, glm::vec3(far) / far.w - origin };
+}
+
+Ray transformRay(const Ray& ray, const glm::mat4& matrix) {
+    return { glm::vec3(matrix * glm::vec4(ray.origin, 1.0f)), glm::vec3(matrix * glm::vec4(ray.direction, 0.0f)) };
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+#include "function_ref.hpp"
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+const float noHitDistance = std::numeric_limits<float>::infinity();
+const uint32_t noHitPrimitive = ~0u;
+
+// Пустой бокс вывернут наизнанку: любое расширение делает его корректным
+struct Aabb {
+    glm::vec3 min = glm::vec3(std::numeric_limits<float>::max());
+    glm::vec3 max = glm::vec3(-std::numeric_limits<float>::max());
+};
+
+inline void growAabb(Aabb& box, const glm::vec3& point) {
+    box.min = glm::min(box.min, point);
+    box.max = glm::max(box.max, point);
+}
+
+inline void growAabb(Aabb& box, const Aabb& other) {
+    box.min = glm::min(box.min, other.min);
+    box.max = glm::max(box.max, other.max);
+}
+
+// Половина площади поверхности: для SAH важны только отношения площадей
+inline float aabbHalfArea(const Aabb& box) {
+    glm::vec3 extent = glm::max(box.max - box.min, glm::vec3(0.0f));
+    return extent.x * extent.y + extent.y * extent.z + extent.z * extent.x;
+}
+
+// Бокс, охватывающий box после преобразования matrix
+Aabb transformAabb(const Aabb& box, const glm::mat4& matrix);
+
+// Узел иерархии. У листа count > 0, его примитивы — primitives[first, first + count);
+// у внутреннего узла count == 0, дети — nodes[first] и nodes[first + 1]. Дети всегда
+// лежат после родителя, поэтому обход массива с конца идёт от листьев к корню.
+struct BvhNode {
+    Aabb bounds;
+    uint32_t first = 0;
+    uint32_t count = 0;
+};
+
+struct Bvh {
+    std::vector<BvhNode> nodes;       // nodes[0] — корень
+    std::vector<uint32_t> primitives; // номера примитивов в порядке листьев
+};
+
+// Строит иерархию над боксами примитивов: на каждом уровне разбиение выбирается по SAH
+// среди границ корзин по центрам боксов на всех трёх осях
+void buildBvh(Bvh& bvh, const std::vector<Aabb>& bounds);
+
+// Пересчитывает боксы узлов под новые боксы примитивов, не меняя структуру. Подходит, пока
+// примитивы двигаются согласованно (масштаб, общий перенос); при сильном перемешивании
+// иерархия перестраивается через buildBvh.
+void refitBvh(Bvh& bvh, const std::vector<Aabb>& bounds);
+
+// Луч: точка origin + t * direction. direction не обязано быть единичным, тогда t —
+// в единицах длины direction; это сохраняет t при переходе в систему координат объекта.
+struct Ray {
+    glm::vec3 origin;
+    glm::vec3 direction;
+};
+
+struct RayHit {
+    uint32_t primitive = noHitPrimitive;
+    float distance = noHitDistance;
+};
+
+// Ближайшее пересечение. intersect(primitive, maxDistance) возвращает t пересечения с примитивом
+// или noHitDistance; узлы дальше лучшего найденного t не обходятся.
+RayHit raycastBvh(const Bvh& bvh, const Ray& ray, FunctionRef<float(uint32_t primitive, float maxDistance)> intersect,
+                  float maxDistance = noHitDistance);
+
+// Боксы треугольников индексированного меша; позиция — первые три float вершины
+void triangleBounds(const GLfloat* positions, size_t stride, const std::vector<GLuint>& indices, std::vector<Aabb>& bounds);
+
+// Пересечение с треугольником с двух сторон (Мёллер — Трумбор): t или noHitDistance
+float intersectTriangle(const Ray& ray, const glm::vec3& a, const glm::vec3& b, const glm::vec3& c);
+
+// Луч из камеры через точку окна (x вправо, y вниз, в пикселях), начинается на ближней плоскости
+Ray screenRay(float x, float y, float width, float height, const glm::mat4& projection, const glm::mat4& view);
+
+// Луч в системе координат, куда переводит matrix (обычно обратная к матрице модели)
+Ray transformRay(const Ray& ray, const glm::mat4& matrix);
@@ -0,0 +1,259 @@
+#include "clustered_lights.hpp"
+#include "frame_arena.hpp"
+#include "gpu_memory.hpp"
+#include "parallel.hpp"
+#include "perf_counters.hpp"
+#include "profiler.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+// Глубина (положительная дистанция вдоль -Z) начала среза
+float sliceDepth(const ClusterGrid& grid, int slice) {
+    return grid.nearPlane * std::pow(grid.farPlane / grid.nearPlane, (float)slice / grid.slices);
+}
+
+int depthToSlice(const ClusterGrid& grid, float depth) {
+    if (depth <= grid.nearPlane)
+        return 0;
+    float slice = std::log(depth / grid.nearPlane) / std::log(grid.farPlane / grid.nearPlane) * grid.slices;
+    return std::min((int)slice, grid.slices - 1);
+}
+
+void computeClusterBounds(ClusterGrid& grid, const glm::mat4& projection) {
+    grid.projection = projection;
+    glm::mat4 inverseProjection = glm::inverse(projection);
+
+    int count = grid.tilesX * grid.tilesY * grid.slices;
+    grid.clusterMin.resize(count);
+    grid.clusterMax.resize(count);
+
+    for (int z = 0; z < grid.slices; ++z) {
+        float nearDepth = sliceDepth(grid, z);
+        float farDepth = sliceDepth(grid, z + 1);
+        for (int y = 0; y < grid.tilesY; ++y) {
+            for (int x = 0; x < grid.tilesX; ++x) {
+                glm::vec3 minPoint(1e30f), maxPoint(-1e30f);
+                for (int corner = 0; corner < 4; ++corner) {
+                    float ndcX = (float)(x + (corner & 1)) / grid.tilesX * 2.0f - 1.0f;
+                    float ndcY = (float)(y + (corner >> 1)) / grid.tilesY * 2.0f - 1.0f;
+                    glm::vec4 point = inverseProjection * glm::vec4(ndcX, ndcY, -1.0f, 1.0f);
+                    glm::vec3 ray = glm::vec3(point) / point.w;
+                    ray /= -ray.z;
+                    minPoint = glm::min(minPoint, glm::min(ray * nearDepth, ray * farDepth));
+                    maxPoint = glm::max(maxPoint, glm::max(ray * nearDepth, ray * farDepth));
+                }
+                int index = (z * grid.tilesY + y) * grid.tilesX + x;
+                grid.clusterMin[index] = minPoint;
+                grid.clusterMax[index] = maxPoint;
+            }
+        }
+    }
+}
+
+bool sphereIntersectsBox(const glm::vec3& center, float radius, const glm::vec3& boxMin, const glm::vec3& boxMax) {
+    glm::vec3 closest = glm::clamp(center, boxMin, boxMax);
+    glm::vec3 delta = closest - center;
+    return glm::dot(delta, delta) <= radius * radius;
+}
+
+// Диапазон тайлов и срезов, который может задеть сфера источника
+bool computeLightBounds(const ClusterGrid& grid, const PointLight& light, const glm::mat4& view, ClusterGrid::LightBounds& bounds) {
+    glm::vec3 center = glm::vec3(view * glm::vec4(light.position, 1.0f));
+    bounds.viewPosition = center;
+
+    float nearDepth = -center.z - light.radius;
+    float farDepth = -center.z + light.radius;
+    if (farDepth < grid.nearPlane || nearDepth > grid.farPlane)
+        return false;
+
+    bounds.minZ = depthToSlice(grid, nearDepth);
+    bounds.maxZ = depthToSlice(grid, farDepth);
+
+    if (nearDepth <= grid.nearPlane) {
+        // Сфера пересекает ближнюю плоскость — проекция не ограничена
+        bounds.minX = 0;
+        bounds.maxX = grid.tilesX - 1;
+        bounds.minY = 0;
+        bounds.maxY = grid.tilesY - 1;
+        return true;
+    }
+
+    glm::vec2 ndcMin(1e30f), ndcMax(-1e30f);
+    for (int corner = 0; corner < 8; ++corner) {
+        glm::vec3 offset((corner & 1) ? light.radius : -light.radius,
+                         (corner & 2) ? light.radius : -light.radius,
+                         (corner & 4) ? light.radius : -light.radius);
+        glm::vec4 clip = grid.projection * glm::vec4(center + offset, 1.0f);
+        glm::vec2 ndc(clip.x / clip.w, clip.y / clip.w);
+        ndcMin = glm::vec2(std::min(ndcMin.x, ndc.x), std::min(ndcMin.y, ndc.y));
+        ndcMax = glm::vec2(std::max(ndcMax.x, ndc.x), std::max(ndcMax.y, ndc.y));
+    }
+    if (ndcMax.x < -1.0f || ndcMin.x > 1.0f || ndcMax.y < -1.0f || ndcMin.y > 1.0f)
+        return false;
+
+    bounds.minX = std::clamp((int)std::floor((ndcMin.x * 0.5f + 0.5f) * grid.tilesX), 0, grid.tilesX - 1);
+    bounds.maxX = std::clamp((int)std::floor((ndcMax.x * 0.5f + 0.5f) * grid.tilesX), 0, grid.tilesX - 1);
+    bounds.minY = std::clamp((int)std::floor((ndcMin.y * 0.5f + 0.5f) * grid.tilesY), 0, grid.tilesY - 1);
+    bounds.maxY = std::clamp((int)std::floor((ndcMax.y * 0.5f + 0.5f) * grid.tilesY), 0, grid.tilesY - 1);
+    return true;
+}
+
+void createTextureBuffer(GLuint& buffer, GLuint& texture, GLenum format) {
+    genTrackedBuffers(1, &buffer, GpuMemoryCategory::Lighting);
+    genTrackedTextures(1, &texture, GpuMemoryCategory::Lighting); // хранилище — сам буфер
+    glBindBuffer(GL_TEXTURE_BUFFER, buffer);
+    trackedBufferData(GL_TEXTURE_BUFFER, buffer, 16, nullptr, GL_STREAM_DRAW);
+    glBindTexture(GL_TEXTURE_BUFFER, texture);
+    glTexBuffer(GL_TEXTURE_BUFFER, format, buffer);
+    glBindTexture(GL_TEXTURE_BUFFER, 0);
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+}
+
+void uploadTextureBuffer(GLuint buffer, const void* data, size_t bytes) {
+    glBindBuffer(GL_TEXTURE_BUFFER, buffer);
+    // Пустой буфер недопустим для TBO, поэтому минимум 16 байт; старое хранилище отдаём драйверу
+    trackedBufferData(GL_TEXTURE_BUFFER, buffer, std::max<size_t>(bytes, 16), nullptr, GL_STREAM_DRAW);
+    if (bytes > 0)
+        glBufferSubData(GL_TEXTURE_BUFFER, 0, bytes, data);
+    addPerfCounter(PerfCounter::UploadedBytes, bytes);
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+}
+
+} // namespace
+
+void initClusterGrid(ClusterGrid& grid, int tilesX, int tilesY, int slices, float nearPlane, float farPlane) {
+    grid.tilesX = tilesX;
+    grid.tilesY = tilesY;
+    grid.slices = slices;
+    grid.nearPlane = nearPlane;
+    grid.farPlane = farPlane;
+    grid.projection = glm::mat4(0.0f);
+    grid.clusters.assign((size_t)tilesX * tilesY * slices * 2, 0);
+    grid.sliceCounts.assign(slices, std::vector<uint32_t>((size_t)tilesX * tilesY));
+    grid.sliceIndices.assign(slices, std::vector<uint32_t>());
+
+    createTextureBuffer(grid.lightBuffer, grid.lightTexture, GL_RGBA32F);
+    createTextureBuffer(grid.clusterBuffer, grid.clusterTexture, GL_RG32UI);
+    createTextureBuffer(grid.indexBuffer, grid.indexTexture, GL_R32UI);
+}
+
+void destroyClusterGrid(ClusterGrid& grid) {
+    GLuint buffers[] = { grid.lightBuffer, grid.clusterBuffer, grid.indexBuffer };
+    GLuint textures[] = { grid.lightTexture, grid.clusterTexture, grid.indexTexture };
+    deleteTrackedBuffers(3, buffers);
+    deleteTrackedTextures(3, textures);
+    grid.lightBuffer = grid.clusterBuffer = grid.indexBuffer = 0;
+    grid.lightTexture = grid.clusterTexture = grid.indexTexture = 0;
+}
+
+void buildClusters(ClusterGrid& grid, const std::vector<PointLight>& lights, const glm::mat4& view, const glm::mat4& projection) {
+    PROFILE_ZONE("Build clusters");
+    if (projection != grid.projection)
+        computeClusterBounds(grid, projection);
+
+    size_t lightCount = lights.size();
+    int tileCount = grid.tilesX * grid.tilesY;
+    grid.bounds.resize(lightCount);
+
+    // 1. Границы каждого источника в координатах сетки; невидимые помечаются пустым диапазоном
+    parallelFor(lightCount, 256, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            ClusterGrid::LightBounds& bounds = grid.bounds[i];
+            if (!computeLightBounds(grid, lights[i], view, bounds)) {
+                bounds.minZ = 1;
+                bounds.maxZ = 0;
+            }
+        }
+    });
+
+    // 2. Каждый срез заполняется одним потоком: подсчёт, префиксная сумма, запись индексов
+    parallelFor(grid.slices, 1, [&](size_t begin, size_t end) {
+        for (size_t z = begin; z < end; ++z) {
+            std::vector<uint32_t>& counts = grid.sliceCounts[z];
+            std::vector<uint32_t>& indices = grid.sliceIndices[z];
+            std::fill(counts.begin(), counts.end(), 0);
+
+            auto visitClusters = [&](auto&& visit) {
+                for (size_t i = 0; i < lightCount; ++i) {
+                    const ClusterGrid::LightBounds& bounds = grid.bounds[i];
+                    if ((int)z < bounds.minZ || (int)z > bounds.maxZ)
+                        continue;
+                    for (int y = bounds.minY; y <= bounds.maxY; ++y) {
+                        for (int x = bounds.minX; x <= bounds.maxX; ++x) {
+                            int tile = y * grid.tilesX + x;
+                            int cluster = (int)z * tileCount + tile;
+                            if (sphereIntersectsBox(bounds.viewPosition, lights[i].radius, grid.clusterMin[cluster], grid.clusterMax[cluster]))
+                                visit(tile, (uint32_t)i);
+                        }
+                    }
+                }
+            };
+
+            visitClusters([&](int tile, uint32_t) { ++counts[tile]; });
+
+            uint32_t total = 0;
+            for (int tile = 0; tile < tileCount; ++tile) {
+                uint32_t count = counts[tile];
+                grid.clusters[((size_t)z * tileCount + tile) * 2 + 0] = total;
+                grid.clusters[((size_t)z * tileCount + tile) * 2 + 1] = count;
+                counts[tile] = total;
+                total += count;
+            }
+
+            indices.resize(total);
+            visitClusters([&](int tile, uint32_t light) { indices[counts[tile]++] = light; });
+        }
+    });
+
+    // 3. Склейка срезов: смещения внутри среза становятся глобальными
+    uint32_t* sliceOffsets = arenaArray<uint32_t>(frameArena(), grid.slices + 1);
+    sliceOffsets[0] = 0;
+    for (int z = 0; z < grid.slices; ++z)
+        sliceOffsets[z + 1] = sliceOffsets[z] + (uint32_t)grid.sliceIndices[z].size();
+    grid.lightIndices.resize(sliceOffsets[grid.slices]);
+
+    parallelFor(grid.slices, 1, [&](size_t begin, size_t end) {
+        for (size_t z = begin; z < end; ++z) {
+            std::copy(grid.sliceIndices[z].begin(), grid.sliceIndices[z].end(), grid.lightIndices.begin() + sliceOffsets[z]);
+            for (int tile = 0; tile < tileCount; ++tile)
+                grid.clusters[((size_t)z * tileCount + tile) * 2] += sliceOffsets[z];
+        }
+    });
+
+    grid.lightData.resize(lightCount * 8);
+    for (size_t i = 0; i < lightCount; ++i) {
+        float* texel = &grid.lightData[i * 8];
+        texel[0] = lights[i].position.x;
+        texel[1] = lights[i].position.y;
+        texel[2] = lights[i].position.z;
+        texel[3] = lights[i].radius;
+        texel[4] = lights[i].color.x;
+        texel[5] = lights[i].color.y;
+        texel[6] = lights[i].color.z;
+        texel[7] = 0.0f;
+    }
+
+    uploadTextureBuffer(grid.lightBuffer, grid.lightData.data(), grid.lightData.size() * sizeof(float));
+    uploadTextureBuffer(grid.clusterBuffer, grid.clusters.data(), grid.clusters.size() * sizeof(uint32_t));
+    uploadTextureBuffer(grid.indexBuffer, grid.lightIndices.data(), grid.lightIndices.size() * sizeof(uint32_t));
+}
+
+void bindClusters(const ClusterGrid& grid, GLuint program, int firstUnit) {
+    const GLuint textures[] = { grid.lightTexture, grid.clusterTexture, grid.indexTexture };
+    const char* samplers[] = { "lightData", "clusterData", "lightIndexData" };
+    for (int i = 0; i < 3; ++i) {
+        glActiveTexture(GL_TEXTURE0 + firstUnit + i);
+        glBindTexture(GL_TEXTURE_BUFFER, textures[i]);
+        glUniform1i(glGetUniformLocation(program, samplers[i]), firstUnit + i);
+    }
+    glActiveTexture(GL_TEXTURE0);
+
+    float logRatio = std::log(grid.farPlane / grid.nearPlane);
+    glUniform3i(glGetUniformLocation(program, "clusterGridSize"), grid.tilesX, grid.tilesY, grid.slices);
+    // slice = log(depth) * scale + bias
+    glUniform2f(glGetUniformLocation(program, "clusterDepthParams"),
+                grid.slices / logRatio, -grid.slices * std::log(grid.nearPlane) / logRatio);
+}
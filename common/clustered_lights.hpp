@@ -0,0 +1,53 @@
+#pragma once
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <vector>
+
+struct PointLight {
+    glm::vec3 position;
+    float radius;
+    glm::vec3 color;
+};
+
+// Сетка кластеров по пирамиде видимости: tilesX x tilesY по экрану и slices
+// логарифмических срезов по глубине. Списки источников строятся на CPU и
+// передаются в шейдер через текстурные буферы.
+struct ClusterGrid {
+    int tilesX = 16;
+    int tilesY = 9;
+    int slices = 24;
+    float nearPlane = 0.1f;
+    float farPlane = 100.0f;
+
+    glm::mat4 projection = glm::mat4(0.0f);
+    std::vector<glm::vec3> clusterMin; // AABB кластеров в пространстве камеры
+    std::vector<glm::vec3> clusterMax;
+
+    std::vector<uint32_t> clusters;     // (offset, count) на кластер
+    std::vector<uint32_t> lightIndices;
+    std::vector<float> lightData;       // два RGBA32F-текселя на источник
+
+    // Промежуточные данные по срезам, чтобы потоки не делили память
+    struct LightBounds {
+        glm::vec3 viewPosition;
+        int minX, maxX, minY, maxY, minZ, maxZ;
+    };
+    std::vector<LightBounds> bounds;
+    std::vector<std::vector<uint32_t>> sliceCounts;
+    std::vector<std::vector<uint32_t>> sliceIndices;
+
+    GLuint lightBuffer = 0, lightTexture = 0;
+    GLuint clusterBuffer = 0, clusterTexture = 0;
+    GLuint indexBuffer = 0, indexTexture = 0;
+};
+
+void initClusterGrid(ClusterGrid& grid, int tilesX, int tilesY, int slices, float nearPlane, float farPlane);
+void destroyClusterGrid(ClusterGrid& grid);
+
+// Распределяет источники по кластерам на всех ядрах и загружает результат в GPU
+void buildClusters(ClusterGrid& grid, const std::vector<PointLight>& lights, const glm::mat4& view, const glm::mat4& projection);
+
+// Привязывает текстурные буферы к блокам firstUnit..firstUnit+2 и выставляет униформы сетки
+void bindClusters(const ClusterGrid& grid, GLuint program, int firstUnit);
@@ -0,0 +1,39 @@
+#include "command_buffer.hpp"
+#include "parallel.hpp"
+#include "profiler.hpp"
+
+#include <algorithm>
+
+namespace {
+
+const size_t minCommandsPerSlice = 256; // меньше не окупает запуск потока
+
+} // namespace
+
+void recordCommands(CommandRecorder& recorder, size_t count,
+                    FunctionRef<void(size_t begin, size_t end, std::vector<DrawItem>& buffer)> record) {
+    PROFILE_ZONE("Record commands");
+    size_t slices = std::clamp<size_t>(count / minCommandsPerSlice, 1, workerCount());
+    if (recorder.buffers.size() < slices)
+        recorder.buffers.resize(slices);
+    for (std::vector<DrawItem>& buffer : recorder.buffers)
+        buffer.clear();
+
+    parallelFor(slices, 1, [&](size_t begin, size_t end) {
+        for (size_t slice = begin; slice < end; ++slice)
+            record(count * slice / slices, count * (slice + 1) / slices, recorder.buffers[slice]);
+    });
+}
+
+void mergeCommands(CommandRecorder& recorder, RenderQueue& queue) {
+    PROFILE_ZONE("Merge commands");
+    size_t total = queue.items.size();
+    for (const std::vector<DrawItem>& buffer : recorder.buffers)
+        total += buffer.size();
+    queue.items.reserve(total);
+
+    for (std::vector<DrawItem>& buffer : recorder.buffers) {
+        queue.items.insert(queue.items.end(), buffer.begin(), buffer.end());
+        buffer.clear();
+    }
+}
@@ -0,0 +1,21 @@
+#pragma once
+
+#include "function_ref.hpp"
+#include "render_queue.hpp"
+
+#include <vector>
+
+// Пакеты рисования кадра, записанные рабочими потоками. У каждого куска работы свой буфер,
+// поэтому запись идёт без блокировок; буферы только дописываются и сбрасываются раз в кадр,
+// их память переживает кадры. GL вызывается только при отправке, в потоке контекста.
+struct CommandRecorder {
+    std::vector<std::vector<DrawItem>> buffers;
+};
+
+// Делит [0, count) на куски по числу рабочих потоков. record(begin, end, buffer) отбрасывает
+// невидимое, считает матрицы и ключи сортировки и дописывает пакеты в свой buffer.
+void recordCommands(CommandRecorder& recorder, size_t count,
+                    FunctionRef<void(size_t begin, size_t end, std::vector<DrawItem>& buffer)> record);
+
+// Переносит пакеты в очередь в порядке кусков: результат не зависит от числа потоков
+void mergeCommands(CommandRecorder& recorder, RenderQueue& queue);
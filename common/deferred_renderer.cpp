@@ -0,0 +1,128 @@
+#include "deferred_renderer.hpp"
+#include "gpu_memory.hpp"
+#include "perf_counters.hpp"
+#include "profiler.hpp"
+
+#include <iostream>
+
+namespace {
+
+GLuint createTarget(GLenum internalFormat, GLenum format, GLenum type, int width, int height) {
+    GLuint texture;
+    genTrackedTextures(1, &texture, GpuMemoryCategory::RenderTarget);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    trackedTexImage2D(texture, internalFormat, width, height, format, type, nullptr);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    return texture;
+}
+
+bool createTargets(GBuffer& gbuffer) {
+    gbuffer.position = createTarget(GL_RGBA32F, GL_RGBA, GL_FLOAT, gbuffer.width, gbuffer.height);
+    gbuffer.normal = createTarget(GL_RGBA16F, GL_RGBA, GL_HALF_FLOAT, gbuffer.width, gbuffer.height);
+    gbuffer.albedo = createTarget(GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE, gbuffer.width, gbuffer.height);
+    gbuffer.depth = createTarget(GL_DEPTH24_STENCIL8, GL_DEPTH_STENCIL, GL_UNSIGNED_INT_24_8, gbuffer.width, gbuffer.height);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    GLint previous;
+    glGetIntegerv(GL_FRAMEBUFFER_BINDING, &previous);
+    glBindFramebuffer(GL_FRAMEBUFFER, gbuffer.framebuffer);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, gbuffer.position, 0);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, gbuffer.normal, 0);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT2, GL_TEXTURE_2D, gbuffer.albedo, 0);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_TEXTURE_2D, gbuffer.depth, 0);
+
+    const GLenum drawBuffers[] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1, GL_COLOR_ATTACHMENT2 };
+    glDrawBuffers(3, drawBuffers);
+
+    bool complete = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+    glBindFramebuffer(GL_FRAMEBUFFER, previous);
+    if (!complete)
+        std::cerr << "G-buffer framebuffer is incomplete" << std::endl;
+    return complete;
+}
+
+void deleteTargets(GBuffer& gbuffer) {
+    GLuint textures[] = { gbuffer.position, gbuffer.normal, gbuffer.albedo, gbuffer.depth };
+    deleteTrackedTextures(4, textures);
+    gbuffer.position = gbuffer.normal = gbuffer.albedo = gbuffer.depth = 0;
+}
+
+} // namespace
+
+bool initGBuffer(GBuffer& gbuffer, int width, int height) {
+    gbuffer.width = width;
+    gbuffer.height = height;
+    glGenFramebuffers(1, &gbuffer.framebuffer);
+    genTrackedVertexArrays(1, &gbuffer.emptyVAO);
+    return createTargets(gbuffer);
+}
+
+void resizeGBuffer(GBuffer& gbuffer, int width, int height) {
+    if (gbuffer.framebuffer == 0 || (width == gbuffer.width && height == gbuffer.height))
+        return;
+    gbuffer.width = width;
+    gbuffer.height = height;
+    deleteTargets(gbuffer);
+    createTargets(gbuffer);
+}
+
+void destroyGBuffer(GBuffer& gbuffer) {
+    deleteTargets(gbuffer);
+    glDeleteFramebuffers(1, &gbuffer.framebuffer);
+    deleteTrackedVertexArrays(1, &gbuffer.emptyVAO);
+    gbuffer.framebuffer = 0;
+    gbuffer.emptyVAO = 0;
+}
+
+void beginGeometryPass(const GBuffer& gbuffer) {
+    glBindFramebuffer(GL_FRAMEBUFFER, gbuffer.framebuffer);
+
+    // Альфа альбедо 0 помечает фон, проход освещения его пропускает
+    GLfloat clearColor[4];
+    glGetFloatv(GL_COLOR_CLEAR_VALUE, clearColor);
+    glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    glClearColor(clearColor[0], clearColor[1], clearColor[2], clearColor[3]);
+}
+
+void endGeometryPass(const GBuffer& gbuffer, GLuint targetFramebuffer) {
+    GLint viewport[4];
+    glGetIntegerv(GL_VIEWPORT, viewport);
+
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, gbuffer.framebuffer);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, targetFramebuffer);
+    glBlitFramebuffer(viewport[0], viewport[1], viewport[0] + viewport[2], viewport[1] + viewport[3],
+                      viewport[0], viewport[1], viewport[0] + viewport[2], viewport[1] + viewport[3],
+                      GL_DEPTH_BUFFER_BIT, GL_NEAREST);
+    glBindFramebuffer(GL_FRAMEBUFFER, targetFramebuffer);
+}
+
+void bindGBufferTextures(const GBuffer& gbuffer, GLuint program, int firstUnit) {
+    const GLuint textures[] = { gbuffer.position, gbuffer.normal, gbuffer.albedo };
+    const char* samplers[] = { "gPosition", "gNormal", "gAlbedo" };
+    for (int i = 0; i < 3; ++i) {
+        glActiveTexture(GL_TEXTURE0 + firstUnit + i);
+        glBindTexture(GL_TEXTURE_2D, textures[i]);
+        glUniform1i(glGetUniformLocation(program, samplers[i]), firstUnit + i);
+    }
+    glActiveTexture(GL_TEXTURE0);
+}
+
+void drawFullscreenTriangle(const GBuffer& gbuffer) {
+    PROFILE_GPU_ZONE("Deferred lighting");
+    GLboolean depthTest = glIsEnabled(GL_DEPTH_TEST);
+    glDisable(GL_DEPTH_TEST);
+    glDepthMask(GL_FALSE);
+
+    glBindVertexArray(gbuffer.emptyVAO);
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+    countDraw(3);
+    glBindVertexArray(0);
+
+    glDepthMask(GL_TRUE);
+    if (depthTest)
+        glEnable(GL_DEPTH_TEST);
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <GL/glew.h>
+
+// G-буфер отложенного освещения: позиция и нормаль в мировых координатах, альбедо.
+// Альфа альбедо равна нулю там, где геометрии нет.
+struct GBuffer {
+    int width = 0;
+    int height = 0;
+    GLuint framebuffer = 0;
+    GLuint position = 0;
+    GLuint normal = 0;
+    GLuint albedo = 0;
+    GLuint depth = 0;
+    GLuint emptyVAO = 0; // для полноэкранного треугольника из gl_VertexID
+};
+
+bool initGBuffer(GBuffer& gbuffer, int width, int height);
+void resizeGBuffer(GBuffer& gbuffer, int width, int height);
+void destroyGBuffer(GBuffer& gbuffer);
+
+// Делает G-буфер целью рисования и очищает его
+void beginGeometryPass(const GBuffer& gbuffer);
+
+// Возвращает рисование в targetFramebuffer и копирует туда глубину геометрического прохода,
+// чтобы последующие прямые проходы корректно перекрывались со сценой
+void endGeometryPass(const GBuffer& gbuffer, GLuint targetFramebuffer);
+
+// Привязывает текстуры G-буфера к блокам firstUnit..firstUnit+2 (gPosition, gNormal, gAlbedo)
+void bindGBufferTextures(const GBuffer& gbuffer, GLuint program, int firstUnit);
+
+// Проход освещения: один треугольник на весь экран без теста и записи глубины
+void drawFullscreenTriangle(const GBuffer& gbuffer);
@@ -0,0 +1,145 @@
+#include "dynamic_resolution.hpp"
+#include "gpu_memory.hpp"
+#include "profiler.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+namespace {
+
+const float smoothing = 0.2f;   // вес нового замера в скользящем среднем
+const float deadZone = 0.05f;   // отклонение от бюджета, на которое регулятор не реагирует
+const float responsiveness = 0.5f;
+
+void allocateBuffers(DynamicResolution& resolution) {
+    glBindRenderbuffer(GL_RENDERBUFFER, resolution.colorBuffer);
+    trackedRenderbufferStorage(resolution.colorBuffer, GL_RGBA8, resolution.windowWidth, resolution.windowHeight);
+    glBindRenderbuffer(GL_RENDERBUFFER, resolution.depthBuffer);
+    trackedRenderbufferStorage(resolution.depthBuffer, GL_DEPTH24_STENCIL8, resolution.windowWidth, resolution.windowHeight);
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+}
+
+void updateRenderSize(DynamicResolution& resolution) {
+    resolution.renderWidth = std::max(1, (int)std::lround(resolution.windowWidth * resolution.scale));
+    resolution.renderHeight = std::max(1, (int)std::lround(resolution.windowHeight * resolution.scale));
+}
+
+} // namespace
+
+void initDynamicResolution(DynamicResolution& resolution, int width, int height) {
+    if (!resolution.enabled)
+        return;
+
+    resolution.windowWidth = width;
+    resolution.windowHeight = height;
+    glGenFramebuffers(1, &resolution.framebuffer);
+    genTrackedRenderbuffers(1, &resolution.colorBuffer, GpuMemoryCategory::RenderTarget);
+    genTrackedRenderbuffers(1, &resolution.depthBuffer, GpuMemoryCategory::RenderTarget);
+    allocateBuffers(resolution);
+
+    GLint previous;
+    glGetIntegerv(GL_FRAMEBUFFER_BINDING, &previous);
+    glBindFramebuffer(GL_FRAMEBUFFER, resolution.framebuffer);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, resolution.colorBuffer);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, resolution.depthBuffer);
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+        std::cerr << "Dynamic resolution framebuffer is incomplete, rendering at full size" << std::endl;
+        glBindFramebuffer(GL_FRAMEBUFFER, previous);
+        destroyDynamicResolution(resolution);
+        resolution.enabled = false;
+        return;
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, previous);
+
+    glGenQueries(DynamicResolution::queryFrames * 2, resolution.queries);
+    resolution.scale = resolution.maxScale;
+    updateRenderSize(resolution);
+    std::cout << "Dynamic resolution: " << resolution.targetMs << " ms budget" << std::endl;
+}
+
+void resizeDynamicResolution(DynamicResolution& resolution, int width, int height) {
+    if (!resolution.enabled || resolution.framebuffer == 0)
+        return;
+    if (width == resolution.windowWidth && height == resolution.windowHeight)
+        return;
+
+    resolution.windowWidth = width;
+    resolution.windowHeight = height;
+    allocateBuffers(resolution);
+    updateRenderSize(resolution);
+}
+
+void destroyDynamicResolution(DynamicResolution& resolution) {
+    if (resolution.framebuffer == 0)
+        return;
+    glDeleteFramebuffers(1, &resolution.framebuffer);
+    deleteTrackedRenderbuffers(1, &resolution.colorBuffer);
+    deleteTrackedRenderbuffers(1, &resolution.depthBuffer);
+    if (resolution.queries[0] != 0)
+        glDeleteQueries(DynamicResolution::queryFrames * 2, resolution.queries);
+    resolution.framebuffer = 0;
+}
+
+void beginDynamicResolutionFrame(DynamicResolution& resolution) {
+    if (!resolution.enabled)
+        return;
+
+    glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &resolution.targetFramebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, resolution.framebuffer);
+    glViewport(0, 0, resolution.renderWidth, resolution.renderHeight);
+    int slot = resolution.frame % DynamicResolution::queryFrames;
+    resolution.queryScales[slot] = resolution.scale;
+    glQueryCounter(resolution.queries[slot * 2], GL_TIMESTAMP);
+}
+
+void endDynamicResolutionFrame(DynamicResolution& resolution) {
+    if (!resolution.enabled)
+        return;
+
+    PROFILE_GPU_ZONE("Upscale");
+    int slot = resolution.frame % DynamicResolution::queryFrames;
+    glQueryCounter(resolution.queries[slot * 2 + 1], GL_TIMESTAMP);
+
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, resolution.framebuffer);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, resolution.targetFramebuffer);
+    glBlitFramebuffer(0, 0, resolution.renderWidth, resolution.renderHeight,
+                      0, 0, resolution.windowWidth, resolution.windowHeight, GL_COLOR_BUFFER_BIT, GL_LINEAR);
+    glBindFramebuffer(GL_FRAMEBUFFER, resolution.targetFramebuffer);
+    glViewport(0, 0, resolution.windowWidth, resolution.windowHeight);
+
+    // Самый старый кадр в кольце: если GPU его ещё не закончил, замер пропускается
+    ++resolution.frame;
+    if (resolution.frame < DynamicResolution::queryFrames)
+        return;
+    int oldest = resolution.frame % DynamicResolution::queryFrames;
+    GLint available = 0;
+    glGetQueryObjectiv(resolution.queries[oldest * 2 + 1], GL_QUERY_RESULT_AVAILABLE, &available);
+    if (!available)
+        return;
+    GLuint64 begin = 0;
+    GLuint64 end = 0;
+    glGetQueryObjectui64v(resolution.queries[oldest * 2], GL_QUERY_RESULT, &begin);
+    glGetQueryObjectui64v(resolution.queries[oldest * 2 + 1], GL_QUERY_RESULT, &end);
+    updateRenderScale(resolution, (end - begin) / 1.0e6f, resolution.queryScales[oldest]);
+    updateRenderSize(resolution);
+}
+
+void updateRenderScale(DynamicResolution& resolution, float gpuMs, float frameScale) {
+    float fullSizeMs = gpuMs / std::max(frameScale * frameScale, 1e-4f);
+    if (resolution.fullSizeMs == 0.0f)
+        resolution.fullSizeMs = fullSizeMs;
+    else
+        resolution.fullSizeMs += (fullSizeMs - resolution.fullSizeMs) * smoothing;
+
+    float desired = std::clamp(std::sqrt(resolution.targetMs / std::max(resolution.fullSizeMs, 0.01f)),
+                               resolution.minScale, resolution.maxScale);
+    if (std::abs(desired - resolution.scale) < deadZone * resolution.scale)
+        return;
+    resolution.scale += (desired - resolution.scale) * responsiveness;
+
+    if (std::abs(resolution.scale - resolution.reportedScale) >= 0.05f) {
+        std::cout << "Render scale: " << resolution.scale << " (" << resolution.fullSizeMs << " ms at full size)" << std::endl;
+        resolution.reportedScale = resolution.scale;
+    }
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <GL/glew.h>
+
+// Отрисовка во внеэкранный буфер уменьшенного размера с растяжением в окно. Масштаб
+// подбирает регулятор по времени GPU, чтобы кадр укладывался в бюджет targetMs.
+// Буфер выделяется под окно целиком, меняется только область рисования — смена масштаба
+// не пересоздаёт текстуры.
+struct DynamicResolution {
+    bool enabled = false;
+    float targetMs = 16.7f;
+    float minScale = 0.5f;
+    float maxScale = 1.0f;
+    float scale = 1.0f;
+    float fullSizeMs = 0.0f; // сглаженная оценка времени кадра при scale = 1
+    float reportedScale = 1.0f;
+
+    int windowWidth = 0;
+    int windowHeight = 0;
+    int renderWidth = 0;
+    int renderHeight = 0;
+    GLuint framebuffer = 0;
+    GLuint colorBuffer = 0;
+    GLuint depthBuffer = 0;
+    GLint targetFramebuffer = 0;
+
+    // Метки GL_TIMESTAMP начала и конца кадра (см. runHeadless), читаются с задержкой,
+    // чтобы не ждать GPU.
+    static const int queryFrames = 4;
+    GLuint queries[queryFrames * 2] = {};
+    float queryScales[queryFrames] = {}; // масштаб, с которым нарисован кадр в этом слоте
+    int frame = 0;
+};
+
+// Ничего не делают, если enabled == false
+void initDynamicResolution(DynamicResolution& resolution, int width, int height);
+void resizeDynamicResolution(DynamicResolution& resolution, int width, int height);
+void destroyDynamicResolution(DynamicResolution& resolution);
+
+// Запоминает текущий буфер кадра, привязывает внеэкранный и ставит viewport под масштаб
+void beginDynamicResolutionFrame(DynamicResolution& resolution);
+
+// Растягивает кадр в запомненный буфер, возвращает полный viewport и обновляет масштаб
+void endDynamicResolutionFrame(DynamicResolution& resolution);
+
+// Шаг регулятора. Замер приходит с опозданием на несколько кадров, поэтому он приводится
+// к полному размеру делением на scale² того кадра, а масштаб тянется к sqrt(targetMs / fullSizeMs).
+// Сглаживание и мёртвая зона не дают ему дрожать.
+void updateRenderScale(DynamicResolution& resolution, float gpuMs, float frameScale);
@@ -0,0 +1,42 @@
+#include "frame_arena.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <new>
+
+void* arenaAllocate(FrameArena& arena, size_t bytes, size_t alignment) {
+    uintptr_t base = (uintptr_t)arena.memory.get();
+    uintptr_t aligned = (base + arena.offset + alignment - 1) & ~(uintptr_t)(alignment - 1);
+    size_t end = (size_t)(aligned - base) + bytes;
+    arena.requested += bytes + alignment - 1;
+
+    if (arena.memory && end <= arena.capacity) {
+        arena.offset = end;
+        return (void*)aligned;
+    }
+
+    alignment = std::max(alignment, alignof(std::max_align_t));
+    void* pointer = ::operator new(std::max<size_t>(bytes, 1), std::align_val_t(alignment));
+    arena.overflow.push_back({ pointer, alignment });
+    return pointer;
+}
+
+void resetFrameArena(FrameArena& arena) {
+    for (const FrameArena::Overflow& block : arena.overflow)
+        ::operator delete(block.pointer, std::align_val_t(block.alignment));
+    arena.overflow.clear();
+
+    arena.peak = std::max(arena.peak, arena.requested);
+    if (arena.peak > arena.capacity) {
+        // Запас на колебания между кадрами, чтобы не расти по чуть-чуть
+        arena.capacity = arena.peak + arena.peak / 2;
+        arena.memory.reset(new unsigned char[arena.capacity]);
+    }
+    arena.offset = 0;
+    arena.requested = 0;
+}
+
+FrameArena& frameArena() {
+    static FrameArena arena;
+    return arena;
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+// Линейная арена для временных данных кадра: выделение — сдвиг указателя, освобождение —
+// сброс всей арены в конце кадра. Если кадру не хватило места, блок берётся из кучи, а при
+// сбросе арена вырастает до пика, так что в установившемся режиме кадр не трогает кучу.
+// Только из одного потока; память недействительна после resetFrameArena.
+struct FrameArena {
+    std::unique_ptr<unsigned char[]> memory;
+    size_t capacity = 0;
+    size_t offset = 0;
+    size_t requested = 0; // байт, запрошенных за кадр, вместе с ушедшими в кучу
+    size_t peak = 0;      // наибольший requested за всё время
+
+    struct Overflow {
+        void* pointer;
+        size_t alignment;
+    };
+    std::vector<Overflow> overflow;
+};
+
+void* arenaAllocate(FrameArena& arena, size_t bytes, size_t alignment = alignof(std::max_align_t));
+
+// Неинициализированный массив: деструкторы при сбросе не вызываются
+template <typename T>
+T* arenaArray(FrameArena& arena, size_t count) {
+    static_assert(std::is_trivially_destructible_v<T>, "frame arena never runs destructors");
+    return static_cast<T*>(arenaAllocate(arena, count * sizeof(T), alignof(T)));
+}
+
+// Освобождает всё выделенное за кадр и при нехватке увеличивает арену до пика
+void resetFrameArena(FrameArena& arena);
+
+// Арена потока кадра; её сбрасывают циклы render_thread и headless после каждого кадра
+FrameArena& frameArena();
@@ -0,0 +1,99 @@
+#include "frame_pacer.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+const double minWakeLatencyMs = 0.05;
+const double maxWakeLatencyMs = 4.0;
+// Доли нового замера в оценке опоздания: к росту быстрее, чем к спаду, но единичный
+// выброс планировщика забывается за десяток кадров
+const double wakeLatencyRise = 0.5;
+const double wakeLatencyFall = 0.25;
+const double lateFactor = 1.5; // кадр длиннее полутора периодов считается пропущенным
+
+double millisecondsBetween(Clock::time_point from, Clock::time_point to) {
+    return std::chrono::duration<double, std::milli>(to - from).count();
+}
+
+void waitUntil(FramePacer& pacer, Clock::time_point deadline) {
+    Clock::time_point now = Clock::now();
+    double remainingMs = millisecondsBetween(now, deadline);
+    if (remainingMs > pacer.wakeLatencyMs) {
+        double sleepMs = remainingMs - pacer.wakeLatencyMs;
+        std::this_thread::sleep_for(std::chrono::duration<double, std::milli>(sleepMs));
+        Clock::time_point woke = Clock::now();
+        double latency = millisecondsBetween(now, woke) - sleepMs;
+        double weight = latency > pacer.wakeLatencyMs ? wakeLatencyRise : wakeLatencyFall;
+        pacer.wakeLatencyMs += (latency - pacer.wakeLatencyMs) * weight;
+        pacer.wakeLatencyMs = std::clamp(pacer.wakeLatencyMs, minWakeLatencyMs, maxWakeLatencyMs);
+    }
+    while (Clock::now() < deadline)
+        std::this_thread::yield();
+}
+
+void reportPacing(FramePacer& pacer) {
+    std::vector<float>& times = pacer.frameTimes;
+    double sum = 0.0;
+    for (float time : times)
+        sum += time;
+    double average = sum / times.size();
+    double variance = 0.0;
+    for (float time : times)
+        variance += (time - average) * (time - average);
+    double jitter = std::sqrt(variance / times.size());
+
+    int late = 0;
+    if (pacer.targetFps > 0.0f) {
+        double periodMs = 1000.0 / pacer.targetFps;
+        for (float time : times)
+            late += time > periodMs * lateFactor;
+    }
+
+    std::sort(times.begin(), times.end());
+    float p99 = times[std::min(times.size() - 1, (size_t)(times.size() * 0.99))];
+    std::cout << std::fixed << std::setprecision(2)
+              << "Frame pacing: " << 1000.0 / average << " fps, frame ms avg=" << average << " p99=" << p99
+              << " max=" << times.back() << " jitter=" << jitter << " late=" << late << std::endl;
+    std::cout.unsetf(std::ios::floatfield);
+    times.clear();
+    pacer.reportElapsed = 0.0;
+}
+
+} // namespace
+
+float waitForNextFrame(FramePacer& pacer) {
+    Clock::time_point now = Clock::now();
+    if (!pacer.started) {
+        pacer.started = true;
+        pacer.deadline = now;
+        pacer.lastFrame = now;
+        return 0.0f;
+    }
+
+    if (pacer.targetFps > 0.0f) {
+        auto period = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / pacer.targetFps));
+        pacer.deadline += period;
+        // Отстали больше чем на кадр — не догоняем пачкой коротких кадров, а начинаем отсчёт заново
+        if (now > pacer.deadline + period)
+            pacer.deadline = now;
+        else
+            waitUntil(pacer, pacer.deadline);
+        now = Clock::now();
+    }
+
+    double frameMs = millisecondsBetween(pacer.lastFrame, now);
+    pacer.lastFrame = now;
+    pacer.frameTimes.push_back((float)frameMs);
+    pacer.reportElapsed += frameMs / 1000.0;
+    if (pacer.reportElapsed >= pacer.reportInterval)
+        reportPacing(pacer);
+
+    return std::min((float)(frameMs / 1000.0), pacer.maxFrameDelta);
+}
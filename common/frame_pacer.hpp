@@ -0,0 +1,27 @@
+#pragma once
+
+#include <chrono>
+#include <vector>
+
+// Ограничитель частоты кадров. Ждёт срока следующего кадра сначала сном, затем коротким
+// циклом ожидания: sleep_for просыпается с опозданием, поэтому сон обрывается раньше срока
+// на оценку этого опоздания, а остаток докручивается с точностью до микросекунд.
+// Интервалы между кадрами копятся и раз в reportInterval секунд печатаются вместе с
+// разбросом (jitter) и числом пропущенных сроков.
+struct FramePacer {
+    float targetFps = 60.0f; // 0 — без ограничения
+    float reportInterval = 5.0f;
+    float maxFrameDelta = 0.25f; // шаг движения после долгой паузы (перетаскивание окна, отладчик)
+
+    bool started = false;
+    std::chrono::steady_clock::time_point deadline;
+    std::chrono::steady_clock::time_point lastFrame;
+    double wakeLatencyMs = 1.0; // оценка опоздания пробуждения после sleep_for
+
+    std::vector<float> frameTimes; // интервалы с последнего отчёта, мс
+    double reportElapsed = 0.0;
+};
+
+// Дожидается начала следующего кадра и возвращает время с прошлого кадра в секундах.
+// Вызывается в начале кадра, до опроса событий и ввода, чтобы ввод был свежим.
+float waitForNextFrame(FramePacer& pacer);
@@ -0,0 +1,26 @@
+#include "frustum.hpp"
+
+Frustum extractFrustum(const glm::mat4& viewProjection) {
+    glm::vec4 rows[4];
+    for (int i = 0; i < 4; ++i)
+        rows[i] = glm::vec4(viewProjection[0][i], viewProjection[1][i], viewProjection[2][i], viewProjection[3][i]);
+
+    Frustum frustum;
+    frustum.planes[0] = rows[3] + rows[0]; // левая
+    frustum.planes[1] = rows[3] - rows[0]; // правая
+    frustum.planes[2] = rows[3] + rows[1]; // нижняя
+    frustum.planes[3] = rows[3] - rows[1]; // верхняя
+    frustum.planes[4] = rows[3] + rows[2]; // ближняя
+    frustum.planes[5] = rows[3] - rows[2]; // дальняя
+    for (glm::vec4& plane : frustum.planes)
+        plane /= glm::length(glm::vec3(plane));
+    return frustum;
+}
+
+bool sphereInFrustum(const Frustum& frustum, const glm::vec3& center, float radius) {
+    for (const glm::vec4& plane : frustum.planes) {
+        if (glm::dot(glm::vec3(plane), center) + plane.w < -radius)
+            return false;
+    }
+    return true;
+}
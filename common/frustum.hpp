@@ -0,0 +1,14 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+// Шесть плоскостей пирамиды видимости, нормали смотрят внутрь
+struct Frustum {
+    glm::vec4 planes[6];
+};
+
+// Плоскости из матрицы projection * view (метод Гриба — Хартманна)
+Frustum extractFrustum(const glm::mat4& viewProjection);
+
+// Сфера хотя бы частично внутри пирамиды
+bool sphereInFrustum(const Frustum& frustum, const glm::vec3& center, float radius);
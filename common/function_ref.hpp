@@ -0,0 +1,30 @@
+#pragma once
+
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+// Невладеющая ссылка на вызываемый объект: указатель на него и функция вызова. В отличие от
+// std::function не копирует лямбду и не выделяет память, поэтому годится для параметров,
+// которые вызываются до возврата функции. Хранить её дольше объекта нельзя.
+template <typename Signature>
+class FunctionRef;
+
+template <typename Result, typename... Args>
+class FunctionRef<Result(Args...)> {
+public:
+    template <typename Function, typename = std::enable_if_t<!std::is_same_v<std::decay_t<Function>, FunctionRef>>>
+    FunctionRef(Function&& function)
+        : callable((void*)std::addressof(function)),
+          invoke([](void* callable, Args... args) -> Result {
+              return (*static_cast<std::remove_reference_t<Function>*>(callable))(std::forward<Args>(args)...);
+          }) {}
+
+    Result operator()(Args... args) const {
+        return invoke(callable, std::forward<Args>(args)...);
+    }
+
+private:
+    void* callable;
+    Result (*invoke)(void* callable, Args... args);
+};
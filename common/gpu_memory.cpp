@@ -0,0 +1,180 @@
+#include "gpu_memory.hpp"
+
+#include <cstdint>
+#include <cstdio>
+#include <unordered_map>
+
+namespace {
+
+enum class ObjectKind : uint64_t { Buffer, Texture, Renderbuffer, VertexArray };
+
+struct Allocation {
+    GpuMemoryCategory category;
+    size_t bytes = 0;
+};
+
+const char* categoryNames[gpuMemoryCategoryCount] = { "geometry", "lighting", "render targets" };
+
+std::unordered_map<uint64_t, Allocation> allocations;
+GpuMemoryStats stats;
+
+int windowFrame = 0;
+size_t windowStartBytes = 0;
+size_t growthStartBytes = 0;
+int growingWindows = 0;
+
+uint64_t objectKey(ObjectKind kind, GLuint id) {
+    return ((uint64_t)kind << 32) | id;
+}
+
+size_t& objectCount(ObjectKind kind) {
+    switch (kind) {
+    case ObjectKind::Buffer: return stats.buffers;
+    case ObjectKind::Texture: return stats.textures;
+    case ObjectKind::Renderbuffer: return stats.renderbuffers;
+    default: return stats.vertexArrays;
+    }
+}
+
+void trackObjects(ObjectKind kind, GLsizei count, const GLuint* ids, GpuMemoryCategory category) {
+    for (GLsizei i = 0; i < count; ++i) {
+        if (allocations.insert({ objectKey(kind, ids[i]), { category, 0 } }).second)
+            ++objectCount(kind);
+    }
+}
+
+void untrackObjects(ObjectKind kind, GLsizei count, const GLuint* ids) {
+    for (GLsizei i = 0; i < count; ++i) {
+        auto found = allocations.find(objectKey(kind, ids[i]));
+        if (found == allocations.end())
+            continue;
+        stats.bytes[(int)found->second.category] -= found->second.bytes;
+        --objectCount(kind);
+        allocations.erase(found);
+    }
+}
+
+void setObjectSize(ObjectKind kind, GLuint id, size_t bytes) {
+    auto found = allocations.find(objectKey(kind, id));
+    if (found == allocations.end())
+        return; // создан в обход учёта
+    size_t& total = stats.bytes[(int)found->second.category];
+    total = total - found->second.bytes + bytes;
+    found->second.bytes = bytes;
+}
+
+size_t bytesPerTexel(GLenum internalFormat) {
+    switch (internalFormat) {
+    case GL_R8: return 1;
+    case GL_RG8: case GL_R16F: case GL_DEPTH_COMPONENT16: return 2;
+    case GL_RGB8: return 3;
+    case GL_RGBA8: case GL_RG16F: case GL_R32F: case GL_R32UI: case GL_DEPTH_COMPONENT24:
+    case GL_DEPTH24_STENCIL8: case GL_DEPTH_COMPONENT32F: return 4;
+    case GL_RGBA16F: case GL_RG32F: case GL_RG32UI: return 8;
+    case GL_RGB32F: return 12;
+    case GL_RGBA32F: case GL_RGBA32UI: return 16;
+    default: return 4;
+    }
+}
+
+double megabytes(size_t bytes) {
+    return bytes / (1024.0 * 1024.0);
+}
+
+} // namespace
+
+size_t GpuMemoryStats::totalBytes() const {
+    size_t total = 0;
+    for (size_t categoryBytes : bytes)
+        total += categoryBytes;
+    return total;
+}
+
+void genTrackedBuffers(GLsizei count, GLuint* buffers, GpuMemoryCategory category) {
+    glGenBuffers(count, buffers);
+    trackObjects(ObjectKind::Buffer, count, buffers, category);
+}
+
+void deleteTrackedBuffers(GLsizei count, const GLuint* buffers) {
+    untrackObjects(ObjectKind::Buffer, count, buffers);
+    glDeleteBuffers(count, buffers);
+}
+
+void trackedBufferData(GLenum target, GLuint buffer, GLsizeiptr size, const void* data, GLenum usage) {
+    glBufferData(target, size, data, usage);
+    setObjectSize(ObjectKind::Buffer, buffer, (size_t)size);
+}
+
+void genTrackedTextures(GLsizei count, GLuint* textures, GpuMemoryCategory category) {
+    glGenTextures(count, textures);
+    trackObjects(ObjectKind::Texture, count, textures, category);
+}
+
+void deleteTrackedTextures(GLsizei count, const GLuint* textures) {
+    untrackObjects(ObjectKind::Texture, count, textures);
+    glDeleteTextures(count, textures);
+}
+
+void trackedTexImage2D(GLuint texture, GLint internalFormat, GLsizei width, GLsizei height, GLenum format, GLenum type,
+                       const void* data) {
+    glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, width, height, 0, format, type, data);
+    setObjectSize(ObjectKind::Texture, texture, (size_t)width * height * bytesPerTexel(internalFormat));
+}
+
+void genTrackedRenderbuffers(GLsizei count, GLuint* renderbuffers, GpuMemoryCategory category) {
+    glGenRenderbuffers(count, renderbuffers);
+    trackObjects(ObjectKind::Renderbuffer, count, renderbuffers, category);
+}
+
+void deleteTrackedRenderbuffers(GLsizei count, const GLuint* renderbuffers) {
+    untrackObjects(ObjectKind::Renderbuffer, count, renderbuffers);
+    glDeleteRenderbuffers(count, renderbuffers);
+}
+
+void trackedRenderbufferStorage(GLuint renderbuffer, GLenum internalFormat, GLsizei width, GLsizei height) {
+    glRenderbufferStorage(GL_RENDERBUFFER, internalFormat, width, height);
+    setObjectSize(ObjectKind::Renderbuffer, renderbuffer, (size_t)width * height * bytesPerTexel(internalFormat));
+}
+
+void genTrackedVertexArrays(GLsizei count, GLuint* arrays) {
+    glGenVertexArrays(count, arrays);
+    trackObjects(ObjectKind::VertexArray, count, arrays, GpuMemoryCategory::Geometry);
+}
+
+void deleteTrackedVertexArrays(GLsizei count, const GLuint* arrays) {
+    untrackObjects(ObjectKind::VertexArray, count, arrays);
+    glDeleteVertexArrays(count, arrays);
+}
+
+GpuMemoryStats gpuMemoryStats() {
+    return stats;
+}
+
+void printGpuMemory(const char* title) {
+    std::printf("%s: %.2f MB (", title, megabytes(stats.totalBytes()));
+    for (int i = 0; i < gpuMemoryCategoryCount; ++i)
+        std::printf("%s%s %.2f MB", i > 0 ? ", " : "", categoryNames[i], megabytes(stats.bytes[i]));
+    std::printf("), %zu buffers, %zu textures, %zu renderbuffers, %zu VAOs\n",
+                stats.buffers, stats.textures, stats.renderbuffers, stats.vertexArrays);
+}
+
+void updateGpuMemory() {
+    if (++windowFrame < gpuMemoryWindowFrames)
+        return;
+    windowFrame = 0;
+
+    size_t bytes = stats.totalBytes();
+    if (bytes > windowStartBytes) {
+        if (growingWindows == 0)
+            growthStartBytes = windowStartBytes;
+        if (++growingWindows == gpuMemoryGrowthWindows) {
+            std::printf("Warning: GPU memory grew for %d windows of %d frames in a row, %.2f MB -> %.2f MB\n",
+                        gpuMemoryGrowthWindows, gpuMemoryWindowFrames, megabytes(growthStartBytes), megabytes(bytes));
+            printGpuMemory("GPU memory");
+            growingWindows = 0;
+        }
+    } else {
+        growingWindows = 0;
+    }
+    windowStartBytes = bytes;
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <GL/glew.h>
+#include <cstddef>
+
+// Учёт памяти GPU. Буферы, текстуры, рендербуферы и VAO создаются и удаляются обёртками
+// ниже вместо прямых вызовов GL, размер хранилища берётся из вызовов, которые его задают.
+// Объём — оценка по формату, без выравнивания и служебных данных драйвера.
+// Только из потока с GL-контекстом.
+enum class GpuMemoryCategory {
+    Geometry,     // вершины и индексы
+    Lighting,     // запечённые цвета и данные источников
+    RenderTarget, // G-буфер и внеэкранные цели
+    Count
+};
+
+const int gpuMemoryCategoryCount = (int)GpuMemoryCategory::Count;
+
+struct GpuMemoryStats {
+    size_t bytes[gpuMemoryCategoryCount] = {};
+    size_t buffers = 0;
+    size_t textures = 0;
+    size_t renderbuffers = 0;
+    size_t vertexArrays = 0;
+
+    size_t totalBytes() const;
+};
+
+void genTrackedBuffers(GLsizei count, GLuint* buffers, GpuMemoryCategory category);
+void deleteTrackedBuffers(GLsizei count, const GLuint* buffers);
+// glBufferData для buffer, уже привязанного к target
+void trackedBufferData(GLenum target, GLuint buffer, GLsizeiptr size, const void* data, GLenum usage);
+
+void genTrackedTextures(GLsizei count, GLuint* textures, GpuMemoryCategory category);
+void deleteTrackedTextures(GLsizei count, const GLuint* textures);
+// glTexImage2D нулевого уровня для texture, уже привязанной к GL_TEXTURE_2D
+void trackedTexImage2D(GLuint texture, GLint internalFormat, GLsizei width, GLsizei height, GLenum format, GLenum type,
+                       const void* data);
+
+void genTrackedRenderbuffers(GLsizei count, GLuint* renderbuffers, GpuMemoryCategory category);
+void deleteTrackedRenderbuffers(GLsizei count, const GLuint* renderbuffers);
+// glRenderbufferStorage для renderbuffer, уже привязанного к GL_RENDERBUFFER
+void trackedRenderbufferStorage(GLuint renderbuffer, GLenum internalFormat, GLsizei width, GLsizei height);
+
+// VAO своей памяти почти не держат, но незакрытые VAO выдают утечку так же, как буферы
+void genTrackedVertexArrays(GLsizei count, GLuint* arrays);
+void deleteTrackedVertexArrays(GLsizei count, const GLuint* arrays);
+
+GpuMemoryStats gpuMemoryStats();
+void printGpuMemory(const char* title);
+
+// Раз в кадр. Объём сравнивается по окнам из gpuMemoryWindowFrames кадров; если он рос
+// gpuMemoryGrowthWindows окон подряд, печатается предупреждение о вероятной утечке.
+const int gpuMemoryWindowFrames = 60;
+const int gpuMemoryGrowthWindows = 5;
+void updateGpuMemory();
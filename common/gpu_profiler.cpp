@@ -0,0 +1,96 @@
+#include "profiler.hpp"
+
+#ifdef ENABLE_PROFILER
+
+#include <GL/glew.h>
+#include <vector>
+
+namespace profiler {
+namespace {
+
+const size_t maxPendingZones = 4096; // результаты, которые никто не забирает, не копятся бесконечно
+
+struct GpuQuery {
+    const char* name;
+    GLuint begin;
+    GLuint end;
+};
+
+// Зоны GPU размечаются парами меток GL_TIMESTAMP (почему не GL_TIME_ELAPSED — см. runHeadless).
+// Результаты читаются в конце следующих кадров, когда они готовы, — без ожидания GPU.
+struct GpuProfiler {
+    std::vector<GLuint> freeQueries;
+    std::vector<GpuQuery> open;    // стек незакрытых зон
+    std::vector<GpuQuery> pending; // закрытые зоны в порядке отправки
+    bool calibrated = false;
+    int64_t offset = 0; // время GPU + offset = время профилировщика
+    int track = 0;
+};
+
+GpuProfiler gpu;
+
+GLuint acquireQuery() {
+    if (gpu.freeQueries.empty()) {
+        GLuint query;
+        glGenQueries(1, &query);
+        return query;
+    }
+    GLuint query = gpu.freeQueries.back();
+    gpu.freeQueries.pop_back();
+    return query;
+}
+
+void calibrate() {
+    GLint64 gpuTime = 0;
+    glGetInteger64v(GL_TIMESTAMP, &gpuTime);
+    gpu.offset = now() - gpuTime;
+    gpu.track = createTrack("GPU");
+    gpu.calibrated = true;
+}
+
+} // namespace
+
+void beginGpuZone(const char* name) {
+    if (!gpu.calibrated)
+        calibrate();
+    GpuQuery query = { name, acquireQuery(), 0 };
+    glQueryCounter(query.begin, GL_TIMESTAMP);
+    gpu.open.push_back(query);
+}
+
+void endGpuZone() {
+    GpuQuery query = gpu.open.back();
+    gpu.open.pop_back();
+    query.end = acquireQuery();
+    glQueryCounter(query.end, GL_TIMESTAMP);
+    if (gpu.pending.size() < maxPendingZones) {
+        gpu.pending.push_back(query);
+    } else {
+        gpu.freeQueries.push_back(query.begin);
+        gpu.freeQueries.push_back(query.end);
+    }
+}
+
+void collectGpuZones() {
+    size_t done = 0;
+    for (; done < gpu.pending.size(); ++done) {
+        const GpuQuery& query = gpu.pending[done];
+        // GPU выполняет команды по порядку: если эта зона не готова, следующие тоже
+        GLint available = 0;
+        glGetQueryObjectiv(query.end, GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available)
+            break;
+        GLuint64 begin = 0;
+        GLuint64 end = 0;
+        glGetQueryObjectui64v(query.begin, GL_QUERY_RESULT, &begin);
+        glGetQueryObjectui64v(query.end, GL_QUERY_RESULT, &end);
+        recordEvent(query.name, (int64_t)begin + gpu.offset, (int64_t)(end - begin), gpu.track);
+        gpu.freeQueries.push_back(query.begin);
+        gpu.freeQueries.push_back(query.end);
+    }
+    gpu.pending.erase(gpu.pending.begin(), gpu.pending.begin() + done);
+}
+
+} // namespace profiler
+
+#endif
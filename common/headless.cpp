@@ -0,0 +1,457 @@
+#include "headless.hpp"
+#include "allocation_counter.hpp"
+#include "frame_arena.hpp"
+#include "gpu_memory.hpp"
+#include "perf_counters.hpp"
+#include "profiler.hpp"
+
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+namespace {
+
+struct HeadlessContext {
+    EGLDisplay display = EGL_NO_DISPLAY;
+    EGLContext context = EGL_NO_CONTEXT;
+    EGLSurface surface = EGL_NO_SURFACE;
+    GLuint framebuffer = 0;
+    GLuint colorBuffer = 0;
+    GLuint depthBuffer = 0;
+};
+
+struct Image {
+    int width = 0;
+    int height = 0;
+    std::vector<unsigned char> pixels; // RGB, строки сверху вниз
+};
+
+bool createHeadlessContext(HeadlessContext& ctx, const HeadlessOptions& options) {
+    if (options.softwareRenderer) {
+        // Программный растеризатор Mesa даёт одинаковую картинку на любой машине
+        setenv("LIBGL_ALWAYS_SOFTWARE", "1", 0);
+    }
+
+    auto getPlatformDisplay = (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+    if (getPlatformDisplay) {
+        ctx.display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+    }
+    if (ctx.display == EGL_NO_DISPLAY) {
+        ctx.display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+    }
+
+    EGLint major, minor;
+    if (ctx.display == EGL_NO_DISPLAY || !eglInitialize(ctx.display, &major, &minor)) {
+        std::cerr << "EGL initialization error: 0x" << std::hex << eglGetError() << std::dec << std::endl;
+        return false;
+    }
+    eglBindAPI(EGL_OPENGL_API);
+
+    const EGLint configAttribs[] = {
+        EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+        EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+        EGL_RED_SIZE, 8,
+        EGL_GREEN_SIZE, 8,
+        EGL_BLUE_SIZE, 8,
+        EGL_DEPTH_SIZE, 24,
+        EGL_NONE
+    };
+    EGLConfig config = nullptr;
+    EGLint numConfigs = 0;
+    eglChooseConfig(ctx.display, configAttribs, &config, 1, &numConfigs);
+
+    const EGLint contextAttribs[] = {
+        EGL_CONTEXT_MAJOR_VERSION, 3,
+        EGL_CONTEXT_MINOR_VERSION, 3,
+        EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_COMPATIBILITY_PROFILE_BIT,
+        EGL_NONE
+    };
+    ctx.context = eglCreateContext(ctx.display, numConfigs > 0 ? config : EGL_NO_CONFIG_KHR, EGL_NO_CONTEXT, contextAttribs);
+    if (ctx.context == EGL_NO_CONTEXT) {
+        std::cerr << "EGL context creation error: 0x" << std::hex << eglGetError() << std::dec << std::endl;
+        return false;
+    }
+
+    // Рисуем в собственный FBO, поверхность нужна только драйверам без surfaceless_context
+    if (numConfigs > 0) {
+        const EGLint pbufferAttribs[] = { EGL_WIDTH, 16, EGL_HEIGHT, 16, EGL_NONE };
+        ctx.surface = eglCreatePbufferSurface(ctx.display, config, pbufferAttribs);
+    }
+    if (!eglMakeCurrent(ctx.display, ctx.surface, ctx.surface, ctx.context)) {
+        std::cerr << "EGL make current error: 0x" << std::hex << eglGetError() << std::dec << std::endl;
+        return false;
+    }
+
+    // glewInit() на EGL-контексте пытается инициализировать GLX, поэтому только ядро
+    glewExperimental = GL_TRUE;
+    if (glewContextInit() != GLEW_OK) {
+        std::cerr << "GLEW initialization error" << std::endl;
+        return false;
+    }
+
+    glGenFramebuffers(1, &ctx.framebuffer);
+    genTrackedRenderbuffers(1, &ctx.colorBuffer, GpuMemoryCategory::RenderTarget);
+    genTrackedRenderbuffers(1, &ctx.depthBuffer, GpuMemoryCategory::RenderTarget);
+
+    glBindRenderbuffer(GL_RENDERBUFFER, ctx.colorBuffer);
+    trackedRenderbufferStorage(ctx.colorBuffer, GL_RGBA8, options.width, options.height);
+    glBindRenderbuffer(GL_RENDERBUFFER, ctx.depthBuffer);
+    trackedRenderbufferStorage(ctx.depthBuffer, GL_DEPTH24_STENCIL8, options.width, options.height);
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, ctx.framebuffer);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, ctx.colorBuffer);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, ctx.depthBuffer);
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+        std::cerr << "Headless framebuffer is incomplete" << std::endl;
+        return false;
+    }
+
+    std::cout << "Headless renderer: " << glGetString(GL_RENDERER) << " (" << glGetString(GL_VERSION) << ")" << std::endl;
+    return true;
+}
+
+void destroyHeadlessContext(HeadlessContext& ctx) {
+    if (ctx.framebuffer) {
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        glDeleteFramebuffers(1, &ctx.framebuffer);
+        deleteTrackedRenderbuffers(1, &ctx.colorBuffer);
+        deleteTrackedRenderbuffers(1, &ctx.depthBuffer);
+    }
+    if (ctx.display != EGL_NO_DISPLAY) {
+        eglMakeCurrent(ctx.display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+        if (ctx.surface != EGL_NO_SURFACE)
+            eglDestroySurface(ctx.display, ctx.surface);
+        if (ctx.context != EGL_NO_CONTEXT)
+            eglDestroyContext(ctx.display, ctx.context);
+        eglTerminate(ctx.display);
+    }
+}
+
+Image readFramebuffer(int width, int height) {
+    Image image;
+    image.width = width;
+    image.height = height;
+    image.pixels.resize((size_t)width * height * 3);
+
+    std::vector<unsigned char> rows((size_t)width * height * 3);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(0, 0, width, height, GL_RGB, GL_UNSIGNED_BYTE, rows.data());
+
+    // glReadPixels возвращает строки снизу вверх
+    size_t stride = (size_t)width * 3;
+    for (int y = 0; y < height; ++y) {
+        std::memcpy(&image.pixels[y * stride], &rows[(height - 1 - y) * stride], stride);
+    }
+    return image;
+}
+
+bool writePPM(const std::string& path, const Image& image) {
+    std::ofstream file(path, std::ios::binary);
+    if (!file) {
+        std::cerr << "Failed to write " << path << std::endl;
+        return false;
+    }
+    file << "P6\n" << image.width << " " << image.height << "\n255\n";
+    file.write((const char*)image.pixels.data(), image.pixels.size());
+    return true;
+}
+
+bool readPPM(const std::string& path, Image& image) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file)
+        return false;
+
+    std::string magic;
+    int maxValue;
+    file >> magic >> image.width >> image.height >> maxValue;
+    file.get();
+    if (magic != "P6" || maxValue != 255 || image.width <= 0 || image.height <= 0)
+        return false;
+
+    image.pixels.resize((size_t)image.width * image.height * 3);
+    file.read((char*)image.pixels.data(), image.pixels.size());
+    return (bool)file;
+}
+
+struct CompareResult {
+    bool passed = false;
+    int maxDiff = 0;
+    float badRatio = 0.0f;
+};
+
+CompareResult compareImages(const Image& actual, const Image& golden, const HeadlessOptions& options) {
+    CompareResult result;
+    if (actual.width != golden.width || actual.height != golden.height) {
+        result.badRatio = 1.0f;
+        return result;
+    }
+
+    size_t badPixels = 0;
+    size_t pixelCount = (size_t)actual.width * actual.height;
+    for (size_t i = 0; i < pixelCount; ++i) {
+        int pixelDiff = 0;
+        for (int c = 0; c < 3; ++c) {
+            int diff = std::abs((int)actual.pixels[i * 3 + c] - (int)golden.pixels[i * 3 + c]);
+            pixelDiff = std::max(pixelDiff, diff);
+        }
+        result.maxDiff = std::max(result.maxDiff, pixelDiff);
+        if (pixelDiff > options.channelTolerance)
+            ++badPixels;
+    }
+
+    result.badRatio = (float)badPixels / (float)pixelCount;
+    result.passed = result.badRatio <= options.maxBadPixelRatio;
+    return result;
+}
+
+void printTimings(const char* name, std::vector<double> samples) {
+    if (samples.empty())
+        return;
+    std::sort(samples.begin(), samples.end());
+    double sum = 0.0;
+    for (double s : samples)
+        sum += s;
+    auto percentile = [&](double p) { return samples[(size_t)(p * (samples.size() - 1))]; };
+    std::printf("%s ms: avg=%.3f min=%.3f p50=%.3f p95=%.3f max=%.3f (%zu frames)\n",
+                name, sum / samples.size(), samples.front(), percentile(0.5), percentile(0.95), samples.back(), samples.size());
+}
+
+} // namespace
+
+bool parseHeadlessArgs(int argc, char** argv, HeadlessOptions& options) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        auto next = [&]() -> const char* {
+            if (i + 1 >= argc) {
+                std::cerr << "Missing value for " << arg << std::endl;
+                return nullptr;
+            }
+            return argv[++i];
+        };
+
+        if (arg == "--headless") {
+            options.enabled = true;
+        } else if (arg == "--hw") {
+            options.softwareRenderer = false;
+        } else if (arg == "--update-golden") {
+            options.updateGolden = true;
+        } else if (arg == "--zero-alloc") {
+            options.requireZeroAllocations = true;
+        } else if (arg == "--frames" || arg == "--width" || arg == "--height" || arg == "--capture-every" || arg == "--warmup" || arg == "--tolerance") {
+            const char* value = next();
+            if (!value)
+                return false;
+            int number = std::atoi(value);
+            if (arg == "--frames") options.frames = std::max(1, number);
+            else if (arg == "--width") options.width = std::max(1, number);
+            else if (arg == "--height") options.height = std::max(1, number);
+            else if (arg == "--capture-every") options.captureEvery = std::max(1, number);
+            else if (arg == "--warmup") options.warmupFrames = std::max(0, number);
+            else options.channelTolerance = std::max(0, number);
+        } else if (arg == "--max-bad-pixels") {
+            const char* value = next();
+            if (!value)
+                return false;
+            options.maxBadPixelRatio = (float)std::atof(value);
+        } else if (arg == "--camera" || arg == "--dump" || arg == "--golden") {
+            const char* value = next();
+            if (!value)
+                return false;
+            if (arg == "--camera") options.cameraPath = value;
+            else if (arg == "--dump") options.dumpDir = value;
+            else options.goldenDir = value;
+        }
+    }
+    return true;
+}
+
+std::vector<CameraKey> loadCameraPath(const std::string& path) {
+    std::vector<CameraKey> keys;
+    std::ifstream file(path);
+    if (!file) {
+        std::cerr << "Failed to open camera path " << path << std::endl;
+        return keys;
+    }
+
+    // Формат строки: time x y z yaw pitch scale, '#' — комментарий
+    std::string line;
+    while (std::getline(file, line)) {
+        if (line.empty() || line[0] == '#')
+            continue;
+        std::istringstream stream(line);
+        CameraKey key;
+        if (stream >> key.time >> key.position.x >> key.position.y >> key.position.z >> key.yaw >> key.pitch >> key.scale)
+            keys.push_back(key);
+    }
+
+    std::sort(keys.begin(), keys.end(), [](const CameraKey& a, const CameraKey& b) { return a.time < b.time; });
+    return keys;
+}
+
+CameraKey sampleCameraPath(const std::vector<CameraKey>& path, float time) {
+    if (path.empty())
+        return CameraKey();
+    if (time <= path.front().time)
+        return path.front();
+    if (time >= path.back().time)
+        return path.back();
+
+    size_t i = 1;
+    while (path[i].time < time)
+        ++i;
+    const CameraKey& a = path[i - 1];
+    const CameraKey& b = path[i];
+    float t = (time - a.time) / std::max(b.time - a.time, 1e-6f);
+
+    CameraKey key;
+    key.time = time;
+    key.position = a.position + (b.position - a.position) * t;
+    key.yaw = a.yaw + (b.yaw - a.yaw) * t;
+    key.pitch = a.pitch + (b.pitch - a.pitch) * t;
+    key.scale = a.scale + (b.scale - a.scale) * t;
+    return key;
+}
+
+int runHeadless(const HeadlessOptions& options,
+                const std::function<void(int width, int height)>& init,
+                const std::function<void(const CameraKey& key)>& renderFrame) {
+    std::vector<CameraKey> path;
+    if (!options.cameraPath.empty()) {
+        path = loadCameraPath(options.cameraPath);
+        if (path.empty())
+            return 1;
+    }
+    float duration = path.empty() ? 0.0f : path.back().time;
+
+    HeadlessContext ctx;
+    if (!createHeadlessContext(ctx, options)) {
+        destroyHeadlessContext(ctx);
+        return 1;
+    }
+
+    glBindFramebuffer(GL_FRAMEBUFFER, ctx.framebuffer);
+    glViewport(0, 0, options.width, options.height);
+    init(options.width, options.height);
+
+    if (!options.dumpDir.empty())
+        std::filesystem::create_directories(options.dumpDir);
+    if (!options.goldenDir.empty() && options.updateGolden)
+        std::filesystem::create_directories(options.goldenDir);
+
+    // Запросы таймера читаются с задержкой в несколько кадров, чтобы не ждать GPU
+    const int queryCount = 4;
+    GLuint queries[queryCount];
+    glGenQueries(queryCount, queries);
+
+    std::vector<double> cpuTimes;
+    std::vector<double> gpuTimes;
+    int failed = 0;
+    int missing = 0;
+    uint64_t allocationTotal = 0;
+    uint64_t allocationMax = 0;
+    int allocatingFrames = 0;
+
+    auto collectGpuTime = [&](int frame) {
+        GLuint64 elapsed = 0;
+        glGetQueryObjectui64v(queries[frame % queryCount], GL_QUERY_RESULT, &elapsed);
+        if (frame >= options.warmupFrames)
+            gpuTimes.push_back(elapsed / 1.0e6);
+    };
+
+    for (int frame = 0; frame < options.frames; ++frame) {
+        float time = options.frames > 1 ? duration * frame / (options.frames - 1) : 0.0f;
+        CameraKey key = path.empty() ? CameraKey() : sampleCameraPath(path, time);
+
+        if (frame >= queryCount)
+            collectGpuTime(frame - queryCount);
+
+        uint64_t allocationsBefore = heapAllocationCount();
+        auto start = std::chrono::steady_clock::now();
+        {
+            PROFILE_ZONE("Frame");
+            glBindFramebuffer(GL_FRAMEBUFFER, ctx.framebuffer);
+            glBeginQuery(GL_TIME_ELAPSED, queries[frame % queryCount]);
+            renderFrame(key);
+            glEndQuery(GL_TIME_ELAPSED);
+            glFlush();
+        }
+        PROFILE_FRAME();
+        auto end = std::chrono::steady_clock::now();
+        double frameMs = std::chrono::duration<double, std::milli>(end - start).count();
+        uint64_t frameAllocations = heapAllocationCount() - allocationsBefore;
+        addPerfCounter(PerfCounter::HeapAllocations, frameAllocations);
+        publishPerfFrame(frameMs);
+        resetFrameArena(frameArena());
+        updateGpuMemory();
+        if (frame >= options.warmupFrames) {
+            cpuTimes.push_back(frameMs);
+            allocationTotal += frameAllocations;
+            allocationMax = std::max(allocationMax, frameAllocations);
+            if (frameAllocations > 0)
+                ++allocatingFrames;
+        }
+
+        if (frame % options.captureEvery != 0)
+            continue;
+        if (options.dumpDir.empty() && options.goldenDir.empty())
+            continue;
+
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, ctx.framebuffer);
+        Image image = readFramebuffer(options.width, options.height);
+
+        char name[32];
+        std::snprintf(name, sizeof(name), "frame_%04d.ppm", frame);
+        if (!options.dumpDir.empty())
+            writePPM(options.dumpDir + "/" + name, image);
+
+        if (options.goldenDir.empty())
+            continue;
+        std::string goldenPath = options.goldenDir + "/" + name;
+        if (options.updateGolden) {
+            writePPM(goldenPath, image);
+            continue;
+        }
+
+        Image golden;
+        if (!readPPM(goldenPath, golden)) {
+            std::cerr << "Missing golden image " << goldenPath << std::endl;
+            ++missing;
+            continue;
+        }
+        CompareResult result = compareImages(image, golden, options);
+        if (!result.passed) {
+            std::printf("FAIL %s: max diff %d, %.4f%% pixels over tolerance\n", name, result.maxDiff, result.badRatio * 100.0f);
+            ++failed;
+        }
+    }
+
+    for (int frame = std::max(0, options.frames - queryCount); frame < options.frames; ++frame)
+        collectGpuTime(frame);
+    glDeleteQueries(queryCount, queries);
+
+    printTimings("cpu", cpuTimes);
+    printTimings("gpu", gpuTimes);
+    if (!cpuTimes.empty()) {
+        std::printf("heap allocations: avg=%.2f max=%llu per frame, %d of %zu frames allocated\n",
+                    (double)allocationTotal / cpuTimes.size(), (unsigned long long)allocationMax, allocatingFrames, cpuTimes.size());
+    }
+    std::printf("frame arena: peak %zu bytes\n", frameArena().peak);
+    printGpuMemory("GPU memory");
+    bool allocationFailed = options.requireZeroAllocations && allocatingFrames > 0;
+    if (allocationFailed)
+        std::printf("FAIL zero-alloc: %d frames after warmup touched the heap\n", allocatingFrames);
+    if (!options.goldenDir.empty() && !options.updateGolden)
+        std::printf("golden: %d failed, %d missing\n", failed, missing);
+
+    destroyHeadlessContext(ctx);
+    return (failed > 0 || missing > 0 || allocationFailed) ? 1 : 0;
+}
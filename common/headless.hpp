@@ -0,0 +1,47 @@
+#pragma once
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include <functional>
+#include <string>
+#include <vector>
+
+// Параметры безоконного прогона (--headless)
+struct HeadlessOptions {
+    bool enabled = false;
+    bool softwareRenderer = true;
+    bool updateGolden = false;
+    bool requireZeroAllocations = false; // --zero-alloc: кадр после прогрева не должен трогать кучу
+    int width = 800;
+    int height = 600;
+    int frames = 120;
+    int captureEvery = 1;
+    int warmupFrames = 1;
+    std::string cameraPath;
+    std::string dumpDir;
+    std::string goldenDir;
+    int channelTolerance = 2;
+    float maxBadPixelRatio = 0.001f;
+};
+
+// Ключевой кадр сценария камеры
+struct CameraKey {
+    float time = 0.0f;
+    glm::vec3 position = glm::vec3(0.0f, 1.0f, 5.0f);
+    float yaw = -90.0f;
+    float pitch = 0.0f;
+    float scale = 1.0f;
+};
+
+bool parseHeadlessArgs(int argc, char** argv, HeadlessOptions& options);
+
+std::vector<CameraKey> loadCameraPath(const std::string& path);
+CameraKey sampleCameraPath(const std::vector<CameraKey>& path, float time);
+
+// Создаёт EGL-контекст и FBO, вызывает init, затем прогоняет options.frames кадров
+// по сценарию камеры. Возвращает 0, если все кадры совпали с эталоном.
+// Время GPU кадра меряется запросом GL_TIME_ELAPSED вокруг renderFrame. Такие запросы
+// нельзя вкладывать друг в друга, поэтому замеры внутри кадра ставят метки GL_TIMESTAMP.
+int runHeadless(const HeadlessOptions& options,
+                const std::function<void(int width, int height)>& init,
+                const std::function<void(const CameraKey& key)>& renderFrame);
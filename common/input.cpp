@@ -0,0 +1,237 @@
+#include "input.hpp"
+#include "args.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+namespace {
+
+const char inputMagic[4] = { 'I', 'N', 'P', 'T' };
+const uint32_t inputVersion = 1;
+const float cameraTolerance = 1e-4f;
+
+struct InputHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t keyCount;
+    float timestep;
+};
+
+enum class InputMode { Live, Record, Replay };
+
+struct InputSession {
+    InputMode mode = InputMode::Live;
+    KeyState keys;
+    bool submittedKeys = false;
+    KeyState pendingKeys;
+    int frame = 0;
+    float simulationTime = 0.0f;
+
+    std::ofstream record;
+    std::chrono::steady_clock::time_point recordStart;
+
+    std::vector<char> replay;
+    size_t replayOffset = 0;
+    bool finished = false;
+    std::vector<float> recordedCamera; // камера текущего кадра записи
+    int divergedFrames = 0;
+    float maxDivergence = 0.0f;
+
+    bool frameStarted = false;
+    std::chrono::steady_clock::time_point frameStart;
+    std::vector<double> frameTimes;
+};
+
+InputSession session;
+
+void cameraValues(const CameraKey& camera, float values[6]) {
+    values[0] = camera.position.x;
+    values[1] = camera.position.y;
+    values[2] = camera.position.z;
+    values[3] = camera.yaw;
+    values[4] = camera.pitch;
+    values[5] = camera.scale;
+}
+
+template <typename T>
+void writeValue(std::ofstream& out, const T& value) {
+    out.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template <typename T>
+bool readValue(T& value) {
+    if (session.replayOffset + sizeof(T) > session.replay.size())
+        return false;
+    std::memcpy(&value, session.replay.data() + session.replayOffset, sizeof(T));
+    session.replayOffset += sizeof(T);
+    return true;
+}
+
+bool readReplayFrame() {
+    float time;
+    uint8_t changed;
+    if (!readValue(time) || !readValue(changed))
+        return false;
+    for (int i = 0; i < changed; ++i) {
+        uint8_t key;
+        if (!readValue(key) || key >= sf::Keyboard::KeyCount)
+            return false;
+        session.keys.flip(key);
+    }
+    session.recordedCamera.resize(6);
+    for (float& value : session.recordedCamera) {
+        if (!readValue(value))
+            return false;
+    }
+    return true;
+}
+
+double percentile(std::vector<double> values, double p) {
+    std::sort(values.begin(), values.end());
+    return values[std::min(values.size() - 1, (size_t)(p * (values.size() - 1) + 0.5))];
+}
+
+} // namespace
+
+bool initInput(int argc, char** argv) {
+    std::string recordPath = getArg(argc, argv, "--record", "");
+    std::string replayPath = getArg(argc, argv, "--replay", "");
+
+    if (!replayPath.empty()) {
+        std::ifstream in(replayPath, std::ios::binary);
+        if (!in) {
+            std::cerr << "Failed to open input recording " << replayPath << std::endl;
+            return false;
+        }
+        session.replay.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+        InputHeader header;
+        if (!readValue(header) || std::memcmp(header.magic, inputMagic, 4) != 0 || header.version != inputVersion ||
+            header.keyCount != sf::Keyboard::KeyCount || header.timestep != inputTimestep) {
+            std::cerr << "Unsupported input recording " << replayPath << std::endl;
+            return false;
+        }
+        session.mode = InputMode::Replay;
+        std::cout << "Replaying input from " << replayPath << std::endl;
+    } else if (!recordPath.empty()) {
+        session.record.open(recordPath, std::ios::binary | std::ios::trunc);
+        if (!session.record) {
+            std::cerr << "Failed to create input recording " << recordPath << std::endl;
+            return false;
+        }
+        InputHeader header;
+        std::memcpy(header.magic, inputMagic, 4);
+        header.version = inputVersion;
+        header.keyCount = sf::Keyboard::KeyCount;
+        header.timestep = inputTimestep;
+        writeValue(session.record, header);
+        session.mode = InputMode::Record;
+        session.recordStart = std::chrono::steady_clock::now();
+        std::cout << "Recording input to " << recordPath << std::endl;
+    }
+    return true;
+}
+
+bool isReplayingInput() {
+    return session.mode == InputMode::Replay;
+}
+
+bool isLiveInput() {
+    return session.mode == InputMode::Live;
+}
+
+void submitInputKeys(const KeyState& keys) {
+    session.pendingKeys = keys;
+    session.submittedKeys = true;
+}
+
+bool inputReplayFinished() {
+    return session.mode == InputMode::Replay && session.finished;
+}
+
+float beginInputFrame(float wallTime) {
+    auto now = std::chrono::steady_clock::now();
+    // Время кадров нужно только для отчёта о воспроизведении, живая сессия не растит вектор
+    if (session.frameStarted && session.mode == InputMode::Replay)
+        session.frameTimes.push_back(std::chrono::duration<double, std::milli>(now - session.frameStart).count());
+    session.frameStart = now;
+    session.frameStarted = true;
+
+    float time = session.mode == InputMode::Live ? wallTime : session.frame * inputTimestep;
+    ++session.frame;
+
+    if (session.mode == InputMode::Replay) {
+        if (!session.finished && !readReplayFrame()) {
+            session.finished = true;
+            session.keys.reset();
+        }
+        return time;
+    }
+
+    KeyState keys = session.pendingKeys;
+    if (!session.submittedKeys) {
+        for (int key = 0; key < sf::Keyboard::KeyCount; ++key)
+            keys[key] = sf::Keyboard::isKeyPressed((sf::Keyboard::Key)key);
+    }
+
+    if (session.mode == InputMode::Record) {
+        KeyState changed = keys ^ session.keys;
+        writeValue(session.record, std::chrono::duration<float>(now - session.recordStart).count());
+        writeValue(session.record, (uint8_t)changed.count());
+        for (int key = 0; key < sf::Keyboard::KeyCount; ++key) {
+            if (changed[key])
+                writeValue(session.record, (uint8_t)key);
+        }
+    }
+    session.keys = keys;
+    return time;
+}
+
+float inputDeltaTime(float wallDelta) {
+    return session.mode == InputMode::Live ? wallDelta : inputTimestep;
+}
+
+bool isKeyDown(sf::Keyboard::Key key) {
+    return key >= 0 && key < sf::Keyboard::KeyCount && session.keys[key];
+}
+
+void endInputFrame(const CameraKey& camera) {
+    float values[6];
+    cameraValues(camera, values);
+
+    if (session.mode == InputMode::Record) {
+        for (float value : values)
+            writeValue(session.record, value);
+    } else if (session.mode == InputMode::Replay && !session.finished) {
+        float divergence = 0.0f;
+        for (int i = 0; i < 6; ++i)
+            divergence = std::max(divergence, std::abs(values[i] - session.recordedCamera[i]));
+        if (divergence > cameraTolerance)
+            ++session.divergedFrames;
+        session.maxDivergence = std::max(session.maxDivergence, divergence);
+    }
+}
+
+void finishInput() {
+    if (session.mode == InputMode::Record) {
+        session.record.close();
+        std::cout << "Recorded " << session.frame << " frames of input" << std::endl;
+    }
+    if (session.mode != InputMode::Replay || session.frameTimes.empty())
+        return;
+
+    double sum = 0.0;
+    for (double time : session.frameTimes)
+        sum += time;
+    std::cout << "Replay: " << session.frameTimes.size() << " frames, frame ms: avg=" << sum / session.frameTimes.size()
+              << " p50=" << percentile(session.frameTimes, 0.5) << " p95=" << percentile(session.frameTimes, 0.95) << std::endl;
+    std::cout << "Replay: camera diverged on " << session.divergedFrames << " frames (max difference "
+              << session.maxDivergence << ")" << std::endl;
+}
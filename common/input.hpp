@@ -0,0 +1,48 @@
+#pragma once
+
+#include "headless.hpp"
+
+#include <SFML/Window.hpp>
+#include <bitset>
+
+// Ввод кадра идёт через этот слой: с клавиатуры, с клавиатуры с записью в файл (--record путь)
+// или из записи (--replay путь). При записи и воспроизведении время сцены идёт фиксированным
+// шагом inputTimestep, поэтому повтор даёт те же кадры, что и запись, на любой машине.
+//
+// Формат записи: заголовок "INPT", версия, число клавиш, шаг; затем на кадр — время от начала
+// записи, число сменивших состояние клавиш, их коды (uint8) и камера после обработки ввода
+// (позиция, рысканье, тангаж, масштаб).
+const float inputTimestep = 1.0f / 60.0f;
+
+using KeyState = std::bitset<sf::Keyboard::KeyCount>;
+
+// Разбирает --record и --replay. false, если файл не открылся или это не запись ввода.
+bool initInput(int argc, char** argv);
+
+bool isReplayingInput();
+
+// Ни записи, ни воспроизведения: шаг и время кадра берутся с часов
+bool isLiveInput();
+
+// Клавиши, собранные потоком окна по событиям. После первого вызова beginInputFrame берёт
+// состояние отсюда, а не опрашивает sf::Keyboard.
+void submitInputKeys(const KeyState& keys);
+
+// Запись кончилась: дальше все клавиши отпущены
+bool inputReplayFinished();
+
+// Снимает состояние клавиатуры или читает следующий кадр записи. Возвращает время сцены:
+// wallTime при живом вводе и номер кадра * inputTimestep при записи и воспроизведении.
+float beginInputFrame(float wallTime);
+
+// Шаг движения за кадр: wallDelta при живом вводе, inputTimestep при записи и воспроизведении
+float inputDeltaTime(float wallDelta);
+
+bool isKeyDown(sf::Keyboard::Key key);
+
+// Камера после обработки ввода: дописывается в запись или сверяется с записанной
+void endInputFrame(const CameraKey& camera);
+
+// Закрывает запись; после воспроизведения печатает время кадров и число кадров, где камера
+// разошлась с записью
+void finishInput();
@@ -0,0 +1,90 @@
+#include "job_system.hpp"
+#include "parallel.hpp"
+#include "profiler.hpp"
+
+#include <algorithm>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace {
+
+struct JobSystem {
+    std::mutex mutex;
+    std::condition_variable wake;
+    // Кольцевой буфер задач: в отличие от deque, он не выделяет и не освобождает блоки
+    // по мере движения очереди, а только растёт, когда задач больше, чем мест
+    std::vector<std::function<void()>> jobs;
+    size_t head = 0;
+    size_t queued = 0;
+    std::vector<std::thread> threads;
+    bool stopping = false;
+
+    explicit JobSystem(unsigned threadCount) {
+        for (unsigned i = 0; i < threadCount; ++i)
+            threads.emplace_back([this]() { run(); });
+    }
+
+    // Задачи, не начатые к выходу из программы, отбрасываются: их future получат broken_promise
+    ~JobSystem() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (std::thread& thread : threads)
+            thread.join();
+    }
+
+    void run() {
+        PROFILE_THREAD("Worker");
+        for (;;) {
+            std::function<void()> job;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                wake.wait(lock, [this]() { return stopping || queued > 0; });
+                if (stopping)
+                    return;
+                job = std::move(jobs[head]);
+                jobs[head] = nullptr;
+                head = (head + 1) % jobs.size();
+                --queued;
+            }
+            PROFILE_ZONE("Job");
+            job();
+        }
+    }
+
+    void push(std::function<void()> job) {
+        if (queued == jobs.size()) {
+            std::vector<std::function<void()>> grown(std::max<size_t>(64, jobs.size() * 2));
+            for (size_t i = 0; i < queued; ++i)
+                grown[i] = std::move(jobs[(head + i) % jobs.size()]);
+            jobs.swap(grown);
+            head = 0;
+        }
+        jobs[(head + queued) % jobs.size()] = std::move(job);
+        ++queued;
+    }
+};
+
+JobSystem& jobSystem() {
+    static JobSystem system(jobThreadCount());
+    return system;
+}
+
+} // namespace
+
+unsigned jobThreadCount() {
+    return std::max(1u, workerCount() - 1);
+}
+
+void enqueueJob(std::function<void()> job) {
+    JobSystem& system = jobSystem();
+    {
+        std::lock_guard<std::mutex> lock(system.mutex);
+        system.push(std::move(job));
+    }
+    system.wake.notify_one();
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <chrono>
+#include <functional>
+#include <future>
+#include <memory>
+#include <type_traits>
+
+// Число потоков пула (не меньше одного, даже на одноядерной машине, чтобы фоновые задачи
+// не ждали, пока освободится поток отрисовки)
+unsigned jobThreadCount();
+
+// Ставит задачу в очередь общего пула потоков. Пул создаётся при первом вызове.
+void enqueueJob(std::function<void()> job);
+
+// Запускает function на пуле и возвращает future с её результатом
+template <typename Function>
+auto submitJob(Function&& function) -> std::future<std::invoke_result_t<Function>> {
+    using Result = std::invoke_result_t<Function>;
+    auto task = std::make_shared<std::packaged_task<Result()>>(std::forward<Function>(function));
+    std::future<Result> result = task->get_future();
+    enqueueJob([task]() { (*task)(); });
+    return result;
+}
+
+// Результат готов и get() не заблокирует поток
+template <typename T>
+bool isReady(const std::future<T>& future) {
+    return future.valid() && future.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+}
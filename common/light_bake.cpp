@@ -0,0 +1,43 @@
+#include "light_bake.hpp"
+#include "frame_arena.hpp"
+#include "parallel.hpp"
+#include "profiler.hpp"
+#include "transforms.hpp"
+
+#include <algorithm>
+
+namespace {
+
+const size_t vertexGrain = 1 << 14;
+
+} // namespace
+
+void bakeDiffuseLighting(const GLfloat* positions, size_t positionStride, const GLfloat* normals, size_t normalStride,
+                         size_t vertexCount, const StaticLighting& lighting, GLfloat* colors) {
+    PROFILE_ZONE("Bake diffuse lighting");
+    glm::mat3 normalTransform = normalMatrix(lighting.model);
+    glm::vec3 lightColor = lighting.lightColor * lighting.lightScale;
+
+    // Направления на направленные источники не зависят от вершины
+    glm::vec3* directions = arenaArray<glm::vec3>(frameArena(), lighting.lights.size());
+    for (size_t i = 0; i < lighting.lights.size(); ++i)
+        directions[i] = glm::normalize(lighting.lights[i]);
+
+    parallelFor(vertexCount, vertexGrain, [&](size_t begin, size_t end) {
+        for (size_t v = begin; v < end; ++v) {
+            const GLfloat* p = positions + v * positionStride;
+            const GLfloat* n = normals + v * normalStride;
+            glm::vec3 position = transformPosition(lighting.model, p);
+            glm::vec3 normal = transformNormal(normalTransform, n);
+
+            glm::vec3 result(0.0f);
+            for (size_t i = 0; i < lighting.lights.size(); ++i) {
+                glm::vec3 lightDir = lighting.directional ? directions[i] : glm::normalize(lighting.lights[i] - position);
+                result += std::max(glm::dot(normal, lightDir), 0.0f) * lightColor;
+            }
+            colors[v * 3] = result.x;
+            colors[v * 3 + 1] = result.y;
+            colors[v * 3 + 2] = result.z;
+        }
+    });
+}
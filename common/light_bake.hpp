@@ -0,0 +1,23 @@
+#pragma once
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include <vector>
+
+// Параметры неподвижного освещения, при которых было выполнено запекание
+struct StaticLighting {
+    std::vector<glm::vec3> lights; // позиции точечных источников или направления на источник
+    bool directional = false;
+    glm::vec3 lightColor = glm::vec3(1.0f);
+    float lightScale = 1.0f;
+    glm::mat4 model = glm::mat4(1.0f);
+
+    bool operator==(const StaticLighting& other) const = default;
+};
+
+// Рассеянное освещение в каждой вершине той же моделью, что computeLighting в lighting.glsl.
+// Позиция и нормаль — первые три float из каждых positionStride и normalStride, вершины
+// делятся между потоками. В colors пишутся три float цвета на вершину. Временные данные
+// берутся из кадровой арены, поэтому вызывать из потока кадра.
+void bakeDiffuseLighting(const GLfloat* positions, size_t positionStride, const GLfloat* normals, size_t normalStride,
+                         size_t vertexCount, const StaticLighting& lighting, GLfloat* colors);
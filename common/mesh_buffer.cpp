@@ -0,0 +1,80 @@
+#include "mesh_buffer.hpp"
+#include "gpu_memory.hpp"
+#include "perf_counters.hpp"
+#include "profiler.hpp"
+
+void initMeshBuffer(MeshBuffer& buffer) {
+    genTrackedVertexArrays(1, &buffer.vao);
+    genTrackedBuffers(1, &buffer.vbo, GpuMemoryCategory::Geometry);
+    genTrackedBuffers(1, &buffer.ebo, GpuMemoryCategory::Geometry);
+
+    glBindVertexArray(buffer.vao);
+    glBindBuffer(GL_ARRAY_BUFFER, buffer.vbo);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, meshVertexFloats * sizeof(GLfloat), (void*)0);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, meshVertexFloats * sizeof(GLfloat), (void*)(3 * sizeof(GLfloat)));
+    glEnableVertexAttribArray(1);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, buffer.ebo);
+    glBindVertexArray(0);
+}
+
+void destroyMeshBuffer(MeshBuffer& buffer) {
+    deleteTrackedVertexArrays(1, &buffer.vao);
+    deleteTrackedBuffers(1, &buffer.vbo);
+    deleteTrackedBuffers(1, &buffer.ebo);
+    buffer.vao = buffer.vbo = buffer.ebo = 0;
+}
+
+uint32_t addMesh(MeshBuffer& buffer, const MeshData& mesh) {
+    MeshRange range;
+    range.baseVertex = (GLint)meshBufferVertexCount(buffer);
+    range.vertexCount = (GLuint)(mesh.vertices.size() / meshVertexFloats);
+    range.firstIndex = (GLuint)buffer.indices.size();
+    range.indexCount = (GLsizei)mesh.indices.size();
+
+    buffer.vertices.insert(buffer.vertices.end(), mesh.vertices.begin(), mesh.vertices.end());
+    buffer.indices.insert(buffer.indices.end(), mesh.indices.begin(), mesh.indices.end());
+    buffer.meshes.push_back(range);
+    buffer.dirty = true;
+    return (uint32_t)buffer.meshes.size() - 1;
+}
+
+void replaceMesh(MeshBuffer& buffer, uint32_t id, const MeshData& mesh) {
+    MeshRange& range = buffer.meshes[id];
+    GLuint vertexCount = (GLuint)(mesh.vertices.size() / meshVertexFloats);
+    GLsizei indexCount = (GLsizei)mesh.indices.size();
+
+    auto vertexBegin = buffer.vertices.begin() + (size_t)range.baseVertex * meshVertexFloats;
+    buffer.vertices.erase(vertexBegin, vertexBegin + (size_t)range.vertexCount * meshVertexFloats);
+    buffer.vertices.insert(buffer.vertices.begin() + (size_t)range.baseVertex * meshVertexFloats,
+                           mesh.vertices.begin(), mesh.vertices.end());
+    auto indexBegin = buffer.indices.begin() + range.firstIndex;
+    buffer.indices.erase(indexBegin, indexBegin + range.indexCount);
+    buffer.indices.insert(buffer.indices.begin() + range.firstIndex, mesh.indices.begin(), mesh.indices.end());
+
+    GLint vertexShift = (GLint)vertexCount - (GLint)range.vertexCount;
+    GLint indexShift = (GLint)indexCount - (GLint)range.indexCount;
+    range.vertexCount = vertexCount;
+    range.indexCount = indexCount;
+    for (size_t i = id + 1; i < buffer.meshes.size(); ++i) {
+        buffer.meshes[i].baseVertex += vertexShift;
+        buffer.meshes[i].firstIndex += indexShift;
+    }
+    buffer.dirty = true;
+}
+
+void uploadMeshBuffer(MeshBuffer& buffer) {
+    if (!buffer.dirty)
+        return;
+    PROFILE_ZONE("Upload mesh buffer");
+    size_t vertexBytes = buffer.vertices.size() * sizeof(GLfloat);
+    size_t indexBytes = buffer.indices.size() * sizeof(GLuint);
+
+    glBindVertexArray(buffer.vao);
+    glBindBuffer(GL_ARRAY_BUFFER, buffer.vbo);
+    trackedBufferData(GL_ARRAY_BUFFER, buffer.vbo, vertexBytes, buffer.vertices.data(), GL_STATIC_DRAW);
+    trackedBufferData(GL_ELEMENT_ARRAY_BUFFER, buffer.ebo, indexBytes, buffer.indices.data(), GL_STATIC_DRAW);
+    glBindVertexArray(0);
+    addPerfCounter(PerfCounter::UploadedBytes, vertexBytes + indexBytes);
+    buffer.dirty = false;
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include "mesh_loader.hpp"
+
+#include <GL/glew.h>
+#include <cstdint>
+#include <vector>
+
+// Место меша в общих буферах: индексы рисуются с firstIndex, к каждому прибавляется baseVertex
+struct MeshRange {
+    GLint baseVertex = 0;
+    GLuint vertexCount = 0;
+    GLuint firstIndex = 0;
+    GLsizei indexCount = 0;
+};
+
+// Все меши сцены в одном VBO и одном EBO с общим VAO: переход между мешами не меняет
+// состояние GL, и любые меши рисуются одним glMultiDrawElementsIndirect.
+// Вершины в формате MeshData (meshVertexFloats на вершину). Копия данных остаётся на CPU,
+// чтобы меш можно было заменить; буферы GL перезаливаются целиком в uploadMeshBuffer.
+struct MeshBuffer {
+    GLuint vao = 0;
+    GLuint vbo = 0;
+    GLuint ebo = 0;
+    std::vector<GLfloat> vertices;
+    std::vector<GLuint> indices;
+    std::vector<MeshRange> meshes;
+    bool dirty = false;
+};
+
+// Тот же порядок полей, что читает glMultiDrawElementsIndirect из GL_DRAW_INDIRECT_BUFFER
+struct DrawElementsIndirectCommand {
+    GLuint count;
+    GLuint instanceCount;
+    GLuint firstIndex;
+    GLint baseVertex;
+    GLuint baseInstance;
+};
+
+void initMeshBuffer(MeshBuffer& buffer);
+void destroyMeshBuffer(MeshBuffer& buffer);
+
+// Дописывает меш в конец и возвращает его номер в buffer.meshes
+uint32_t addMesh(MeshBuffer& buffer, const MeshData& mesh);
+
+// Заменяет данные меша; диапазоны всех следующих мешей сдвигаются
+void replaceMesh(MeshBuffer& buffer, uint32_t id, const MeshData& mesh);
+
+// Заливает буферы, если меши добавлялись или менялись с прошлого вызова
+void uploadMeshBuffer(MeshBuffer& buffer);
+
+inline size_t meshBufferVertexCount(const MeshBuffer& buffer) {
+    return buffer.vertices.size() / meshVertexFloats;
+}
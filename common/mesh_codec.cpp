@@ -0,0 +1,553 @@
+#include "mesh_codec.hpp"
+#include "parallel.hpp"
+#include "profiler.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace {
+
+const uint32_t codecMagic = 0x48534d43; // "CMSH"
+const uint32_t codecVersion = 1;
+const int blockSize = 16;  // 16 значений по bits бит — ровно 2 * bits байт
+const int streamCount = 5; // x, y, z позиции, u, v нормали
+const int edgeFifoSize = 16;
+
+// Код треугольника: старшие 4 бита — номер общего ребра в очереди (0 — последнее добавленное),
+// младшие — расстояние третьей вершины назад от следующей новой (0 — сама новая вершина)
+const uint8_t freeTriangle = 15;            // старшая половина: общего ребра нет
+const uint8_t explicitDistance = 15;        // младшая половина: расстояние записано отдельно
+const uint8_t newTriangleCode = 0xf0;       // три новые вершины подряд
+const uint8_t explicitTriangleCode = 0xff;  // три расстояния записаны отдельно
+
+// За заголовком: потоки вершин (vertexBytes), по байту кода на треугольник, затем
+// расстояния, не уместившиеся в код (extraBytes, LEB128)
+struct Header {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t vertexCount;
+    uint32_t indexCount;
+    float bounds[6];
+    uint8_t positionBits;
+    uint8_t normalBits;
+    uint8_t reserved[2];
+    uint32_t vertexBytes;
+    uint32_t extraBytes;
+};
+
+// Поток одной компоненты: разрядность каждого блока байтом, затем блоки
+size_t blockCountFor(size_t count) {
+    return (count + blockSize - 1) / blockSize;
+}
+
+inline uint16_t zigzag(uint16_t delta) {
+    return (uint16_t)((delta << 1) ^ (uint16_t)-(delta >> 15));
+}
+
+void encodeStream(const std::vector<uint16_t>& values, std::vector<uint8_t>& out) {
+    size_t blockCount = blockCountFor(values.size());
+    size_t widths = out.size();
+    out.resize(out.size() + blockCount);
+
+    uint16_t previous = 0;
+    for (size_t block = 0; block < blockCount; ++block) {
+        uint16_t codes[blockSize] = {};
+        uint32_t combined = 0;
+        size_t first = block * blockSize;
+        size_t count = std::min((size_t)blockSize, values.size() - first);
+        for (size_t i = 0; i < count; ++i) {
+            codes[i] = zigzag((uint16_t)(values[first + i] - previous));
+            previous = values[first + i];
+            combined |= codes[i];
+        }
+        int bits = 0;
+        while (combined >> bits)
+            ++bits;
+        out[widths + block] = (uint8_t)bits;
+
+        uint64_t buffer = 0;
+        int filled = 0;
+        for (int i = 0; i < blockSize; ++i) {
+            buffer |= (uint64_t)codes[i] << filled;
+            for (filled += bits; filled >= 8; filled -= 8) {
+                out.push_back((uint8_t)buffer);
+                buffer >>= 8;
+            }
+        }
+    }
+}
+
+// Распаковка блока фиксированной разрядности: смещения известны при компиляции, цикл
+// разворачивается без ветвлений. Читает 8 байт окном, поэтому у конца данных идёт через копию.
+template <int bits>
+void unpackBlock(const uint8_t* data, uint16_t* codes) {
+    for (int i = 0; i < blockSize; ++i) {
+        uint64_t window;
+        std::memcpy(&window, data + i * bits / 8, sizeof(window));
+        codes[i] = (uint16_t)((window >> (i * bits % 8)) & ((1u << bits) - 1));
+    }
+}
+
+typedef void (*UnpackBlock)(const uint8_t* data, uint16_t* codes);
+
+const UnpackBlock unpackBlocks[17] = {
+    unpackBlock<0>, unpackBlock<1>, unpackBlock<2>, unpackBlock<3>, unpackBlock<4>, unpackBlock<5>,
+    unpackBlock<6>, unpackBlock<7>, unpackBlock<8>, unpackBlock<9>, unpackBlock<10>, unpackBlock<11>,
+    unpackBlock<12>, unpackBlock<13>, unpackBlock<14>, unpackBlock<15>, unpackBlock<16>,
+};
+
+// Перевод квантованных компонент обратно в float
+struct Dequantize {
+    float origin[3];
+    float step[3];
+    float normalScale;
+};
+
+// Вершина i блока: values[поток][i]
+inline void assembleVertex(const uint16_t (*values)[blockSize], int i, const Dequantize& d, GLfloat* out) {
+    for (int axis = 0; axis < 3; ++axis)
+        out[axis] = d.origin[axis] + values[axis][i] * d.step[axis];
+
+    float x = values[3][i] * d.normalScale - 1.0f;
+    float y = values[4][i] * d.normalScale - 1.0f;
+    float z = 1.0f - std::fabs(x) - std::fabs(y);
+    float fold = std::max(-z, 0.0f);
+    x -= std::copysign(fold, x);
+    y -= std::copysign(fold, y);
+    float inverseLength = 1.0f / std::sqrt(x * x + y * y + z * z);
+    out[3] = x * inverseLength;
+    out[4] = y * inverseLength;
+    out[5] = z * inverseLength;
+}
+
+#if defined(__SSE2__)
+
+// Обратный зигзаг и префиксная сумма разностей блока, возвращает последнее значение
+inline uint16_t accumulateBlock(uint16_t* values, uint16_t previous) {
+    const __m128i one = _mm_set1_epi16(1);
+    __m128i carry = _mm_set1_epi16((short)previous);
+    for (int half = 0; half < blockSize; half += 8) {
+        __m128i codes = _mm_loadu_si128((const __m128i*)(values + half));
+        __m128i deltas = _mm_xor_si128(_mm_srli_epi16(codes, 1), _mm_sub_epi16(_mm_setzero_si128(), _mm_and_si128(codes, one)));
+        deltas = _mm_add_epi16(deltas, _mm_slli_si128(deltas, 2));
+        deltas = _mm_add_epi16(deltas, _mm_slli_si128(deltas, 4));
+        deltas = _mm_add_epi16(deltas, _mm_slli_si128(deltas, 8));
+        __m128i sums = _mm_add_epi16(deltas, carry);
+        _mm_storeu_si128((__m128i*)(values + half), sums);
+        __m128i high = _mm_shufflehi_epi16(sums, _MM_SHUFFLE(3, 3, 3, 3));
+        carry = _mm_unpackhi_epi64(high, high);
+    }
+    return values[blockSize - 1];
+}
+
+inline __m128 loadQuantized(const uint16_t* values) {
+    __m128i packed = _mm_loadl_epi64((const __m128i*)values);
+    return _mm_cvtepi32_ps(_mm_unpacklo_epi16(packed, _mm_setzero_si128()));
+}
+
+// По четыре вершины: те же операции, что в assembleVertex, затем транспонирование в чередование
+void assembleVertices(const uint16_t (*values)[blockSize], int count, const Dequantize& d, GLfloat* out) {
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 signMask = _mm_set1_ps(-0.0f);
+    const __m128 normalScale = _mm_set1_ps(d.normalScale);
+    int i = 0;
+    for (; i + 4 <= count; i += 4, out += 4 * meshVertexFloats) {
+        __m128 px = _mm_add_ps(_mm_set1_ps(d.origin[0]), _mm_mul_ps(loadQuantized(values[0] + i), _mm_set1_ps(d.step[0])));
+        __m128 py = _mm_add_ps(_mm_set1_ps(d.origin[1]), _mm_mul_ps(loadQuantized(values[1] + i), _mm_set1_ps(d.step[1])));
+        __m128 pz = _mm_add_ps(_mm_set1_ps(d.origin[2]), _mm_mul_ps(loadQuantized(values[2] + i), _mm_set1_ps(d.step[2])));
+
+        __m128 x = _mm_sub_ps(_mm_mul_ps(loadQuantized(values[3] + i), normalScale), one);
+        __m128 y = _mm_sub_ps(_mm_mul_ps(loadQuantized(values[4] + i), normalScale), one);
+        __m128 z = _mm_sub_ps(_mm_sub_ps(one, _mm_andnot_ps(signMask, x)), _mm_andnot_ps(signMask, y));
+        __m128 fold = _mm_max_ps(_mm_sub_ps(_mm_setzero_ps(), z), _mm_setzero_ps());
+        x = _mm_sub_ps(x, _mm_or_ps(fold, _mm_and_ps(signMask, x)));
+        y = _mm_sub_ps(y, _mm_or_ps(fold, _mm_and_ps(signMask, y)));
+        __m128 lengthSquared = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)), _mm_mul_ps(z, z));
+        __m128 inverseLength = _mm_div_ps(one, _mm_sqrt_ps(lengthSquared));
+        __m128 nx = _mm_mul_ps(x, inverseLength);
+        __m128 ny = _mm_mul_ps(y, inverseLength);
+        __m128 nz = _mm_mul_ps(z, inverseLength);
+
+        _MM_TRANSPOSE4_PS(px, py, pz, nx);
+        __m128 low = _mm_unpacklo_ps(ny, nz);
+        __m128 high = _mm_unpackhi_ps(ny, nz);
+        _mm_storeu_ps(out, px);
+        _mm_storel_pi((__m64*)(out + 4), low);
+        _mm_storeu_ps(out + 6, py);
+        _mm_storeh_pi((__m64*)(out + 10), low);
+        _mm_storeu_ps(out + 12, pz);
+        _mm_storel_pi((__m64*)(out + 16), high);
+        _mm_storeu_ps(out + 18, nx);
+        _mm_storeh_pi((__m64*)(out + 22), high);
+    }
+    for (; i < count; ++i, out += meshVertexFloats)
+        assembleVertex(values, i, d, out);
+}
+
+#else
+
+inline uint16_t accumulateBlock(uint16_t* values, uint16_t previous) {
+    for (int i = 0; i < blockSize; ++i) {
+        previous = (uint16_t)(previous + ((values[i] >> 1) ^ (uint16_t)-(values[i] & 1)));
+        values[i] = previous;
+    }
+    return previous;
+}
+
+void assembleVertices(const uint16_t (*values)[blockSize], int count, const Dequantize& d, GLfloat* out) {
+    for (int i = 0; i < count; ++i, out += meshVertexFloats)
+        assembleVertex(values, i, d, out);
+}
+
+#endif
+
+// Поток при разборе: разрядности блоков и текущее место в данных
+struct StreamCursor {
+    const uint8_t* widths;
+    const uint8_t* data;
+    uint16_t previous;
+};
+
+// Находит начала потоков и проверяет, что их блоки занимают ровно секцию вершин
+bool openStreams(const uint8_t* p, const uint8_t* end, size_t blockCount, StreamCursor* streams) {
+    for (int stream = 0; stream < streamCount; ++stream) {
+        if ((size_t)(end - p) < blockCount)
+            return false;
+        size_t bytes = 0;
+        for (size_t block = 0; block < blockCount; ++block) {
+            if (p[block] > 16)
+                return false;
+            bytes += p[block] * 2;
+        }
+        if ((size_t)(end - p) - blockCount < bytes)
+            return false;
+        streams[stream] = { p, p + blockCount, 0 };
+        p += blockCount + bytes;
+    }
+    return p == end;
+}
+
+void decodeBlock(StreamCursor& stream, size_t block, const uint8_t* end, uint16_t* values) {
+    int bits = stream.widths[block];
+    if ((size_t)(end - stream.data) >= (size_t)bits * 2 + sizeof(uint64_t)) {
+        unpackBlocks[bits](stream.data, values);
+    } else {
+        uint8_t padded[2 * 16 + sizeof(uint64_t)] = {};
+        std::memcpy(padded, stream.data, bits * 2);
+        unpackBlocks[bits](padded, values);
+    }
+    stream.previous = accumulateBlock(values, stream.previous);
+    stream.data += bits * 2;
+}
+
+// Блок за блоком все пять потоков сразу: значения блока не покидают стек
+void decodeVertices(StreamCursor* streams, const uint8_t* end, size_t vertexCount, const Dequantize& d, GLfloat* out) {
+    uint16_t values[streamCount][blockSize];
+    for (size_t first = 0; first < vertexCount; first += blockSize) {
+        size_t block = first / blockSize;
+        for (int stream = 0; stream < streamCount; ++stream)
+            decodeBlock(streams[stream], block, end, values[stream]);
+        int count = (int)std::min((size_t)blockSize, vertexCount - first);
+        assembleVertices(values, count, d, out + first * meshVertexFloats);
+    }
+}
+
+uint16_t quantize(float value, float minimum, float scale, uint32_t maximum) {
+    float q = std::round((value - minimum) * scale);
+    return (uint16_t)std::clamp(q, 0.0f, (float)maximum);
+}
+
+// Октаэдрическая развёртка единичной сферы в квадрат [-1, 1]²
+void encodeOctahedral(const GLfloat* normal, float& u, float& v) {
+    float x = normal[0], y = normal[1], z = normal[2];
+    float length = std::fabs(x) + std::fabs(y) + std::fabs(z);
+    if (length == 0.0f) {
+        u = v = 0.0f;
+        return;
+    }
+    x /= length;
+    y /= length;
+    u = z >= 0.0f ? x : (1.0f - std::fabs(y)) * (x >= 0.0f ? 1.0f : -1.0f);
+    v = z >= 0.0f ? y : (1.0f - std::fabs(x)) * (y >= 0.0f ? 1.0f : -1.0f);
+}
+
+void writeVarint(std::vector<uint8_t>& out, uint32_t value) {
+    while (value >= 0x80) {
+        out.push_back((uint8_t)(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back((uint8_t)value);
+}
+
+bool readVarint(const uint8_t*& p, const uint8_t* end, uint32_t& value) {
+    value = 0;
+    for (int shift = 0; shift < 35 && p < end; shift += 7) {
+        uint8_t byte = *p++;
+        value |= (uint32_t)(byte & 0x7f) << shift;
+        if (!(byte & 0x80))
+            return true;
+    }
+    return false;
+}
+
+// Очередь последних рёбер в порядке обхода их треугольников; соседний треугольник проходит
+// общее ребро в обратную сторону
+struct EdgeFifo {
+    uint32_t edges[edgeFifoSize][2];
+    size_t pushed = 0;
+
+    void push(uint32_t a, uint32_t b) {
+        edges[pushed % edgeFifoSize][0] = a;
+        edges[pushed % edgeFifoSize][1] = b;
+        ++pushed;
+    }
+
+    const uint32_t* slot(size_t index) const {
+        return edges[(pushed - 1 - index) % edgeFifoSize];
+    }
+
+    size_t size() const {
+        return std::min(pushed, (size_t)freeTriangle);
+    }
+};
+
+void encodeIndices(const std::vector<GLuint>& indices, const std::vector<uint32_t>& remap, std::vector<uint8_t>& codes,
+                   std::vector<uint8_t>& extra) {
+    EdgeFifo fifo;
+    uint32_t next = 0; // номер следующей новой вершины: вершины пронумерованы по первому использованию
+    for (size_t t = 0; t < indices.size() / 3; ++t) {
+        uint32_t v[3] = { remap[indices[t * 3]], remap[indices[t * 3 + 1]], remap[indices[t * 3 + 2]] };
+
+        int slot = -1;
+        int rotation = 0;
+        for (size_t s = 0; s < fifo.size() && slot < 0; ++s) {
+            const uint32_t* edge = fifo.slot(s);
+            for (int r = 0; r < 3; ++r) {
+                if (v[r] == edge[1] && v[(r + 1) % 3] == edge[0]) {
+                    slot = (int)s;
+                    rotation = r;
+                    break;
+                }
+            }
+        }
+
+        if (slot >= 0) {
+            // Обе вершины ребра уже встречались, новой может быть только третья
+            uint32_t a = v[rotation], b = v[(rotation + 1) % 3], c = v[(rotation + 2) % 3];
+            uint32_t distance = next - c;
+            if (c == next)
+                ++next;
+            uint8_t nibble = distance < explicitDistance ? (uint8_t)distance : explicitDistance;
+            codes.push_back((uint8_t)(slot << 4 | nibble));
+            if (nibble == explicitDistance)
+                writeVarint(extra, distance);
+            fifo.push(b, c);
+            fifo.push(c, a);
+            continue;
+        }
+
+        if (v[0] == next && v[1] == next + 1 && v[2] == next + 2) {
+            codes.push_back(newTriangleCode);
+            next += 3;
+        } else {
+            codes.push_back(explicitTriangleCode);
+            for (uint32_t vertex : v) {
+                writeVarint(extra, next - vertex);
+                if (vertex == next)
+                    ++next;
+            }
+        }
+        fifo.push(v[0], v[1]);
+        fifo.push(v[1], v[2]);
+        fifo.push(v[2], v[0]);
+    }
+}
+
+bool decodeIndices(const uint8_t* codes, size_t triangleCount, const uint8_t* extra, const uint8_t* extraEnd,
+                   uint32_t vertexCount, GLuint* indices) {
+    EdgeFifo fifo;
+    uint32_t next = 0;
+    auto vertexAt = [&](uint32_t distance, uint32_t& vertex) {
+        if (distance == 0) {
+            vertex = next++;
+            return vertex < vertexCount;
+        }
+        vertex = next - distance;
+        return distance <= next;
+    };
+
+    for (size_t t = 0; t < triangleCount; ++t) {
+        uint8_t code = codes[t];
+        uint8_t slot = code >> 4;
+        uint32_t a, b, c;
+        if (slot != freeTriangle) {
+            if (slot >= fifo.size())
+                return false;
+            const uint32_t* edge = fifo.slot(slot);
+            a = edge[1];
+            b = edge[0];
+            uint32_t distance = code & 15;
+            if (distance == explicitDistance && !readVarint(extra, extraEnd, distance))
+                return false;
+            if (!vertexAt(distance, c))
+                return false;
+            fifo.push(b, c);
+            fifo.push(c, a);
+        } else {
+            if (code == newTriangleCode) {
+                if (vertexCount - next < 3)
+                    return false;
+                a = next;
+                b = next + 1;
+                c = next + 2;
+                next += 3;
+            } else {
+                uint32_t distances[3];
+                if (code != explicitTriangleCode || !readVarint(extra, extraEnd, distances[0]) ||
+                    !vertexAt(distances[0], a) || !readVarint(extra, extraEnd, distances[1]) ||
+                    !vertexAt(distances[1], b) || !readVarint(extra, extraEnd, distances[2]) || !vertexAt(distances[2], c))
+                    return false;
+            }
+            fifo.push(a, b);
+            fifo.push(b, c);
+            fifo.push(c, a);
+        }
+        indices[t * 3] = a;
+        indices[t * 3 + 1] = b;
+        indices[t * 3 + 2] = c;
+    }
+    return extra == extraEnd;
+}
+
+} // namespace
+
+bool encodeMesh(const MeshData& mesh, std::vector<uint8_t>& out, const MeshCodecOptions& options) {
+    PROFILE_ZONE("Encode mesh");
+    size_t sourceVertices = mesh.vertices.size() / meshVertexFloats;
+    if (mesh.indices.size() % 3 != 0 || options.positionBits < 1 || options.positionBits > 16 ||
+        options.normalBits < 1 || options.normalBits > 16)
+        return false;
+
+    std::vector<uint32_t> remap(sourceVertices, ~0u);
+    uint32_t vertexCount = 0;
+    for (GLuint index : mesh.indices) {
+        if (index >= sourceVertices)
+            return false;
+        if (remap[index] == ~0u)
+            remap[index] = vertexCount++;
+    }
+
+    Header header = {};
+    header.magic = codecMagic;
+    header.version = codecVersion;
+    header.vertexCount = vertexCount;
+    header.indexCount = (uint32_t)mesh.indices.size();
+    header.positionBits = (uint8_t)options.positionBits;
+    header.normalBits = (uint8_t)options.normalBits;
+
+    // Рамка по используемым вершинам: bounds меша могут быть не посчитаны
+    glm::vec3 minimum(0.0f), maximum(0.0f);
+    bool first = true;
+    for (size_t v = 0; v < sourceVertices; ++v) {
+        if (remap[v] == ~0u)
+            continue;
+        glm::vec3 position(mesh.vertices[v * meshVertexFloats], mesh.vertices[v * meshVertexFloats + 1], mesh.vertices[v * meshVertexFloats + 2]);
+        minimum = first ? position : glm::min(minimum, position);
+        maximum = first ? position : glm::max(maximum, position);
+        first = false;
+    }
+    for (int i = 0; i < 3; ++i) {
+        header.bounds[i] = minimum[i];
+        header.bounds[3 + i] = maximum[i];
+    }
+
+    uint32_t positionMax = (1u << options.positionBits) - 1;
+    uint32_t normalMax = (1u << options.normalBits) - 1;
+    std::vector<uint16_t> streams[streamCount];
+    for (std::vector<uint16_t>& stream : streams)
+        stream.resize(vertexCount);
+    for (size_t v = 0; v < sourceVertices; ++v) {
+        if (remap[v] == ~0u)
+            continue;
+        const GLfloat* vertex = &mesh.vertices[v * meshVertexFloats];
+        for (int i = 0; i < 3; ++i) {
+            float extent = maximum[i] - minimum[i];
+            float scale = extent > 0.0f ? positionMax / extent : 0.0f;
+            streams[i][remap[v]] = quantize(vertex[i], minimum[i], scale, positionMax);
+        }
+        float u, w;
+        encodeOctahedral(vertex + 3, u, w);
+        streams[3][remap[v]] = quantize(u, -1.0f, normalMax * 0.5f, normalMax);
+        streams[4][remap[v]] = quantize(w, -1.0f, normalMax * 0.5f, normalMax);
+    }
+
+    out.assign(sizeof(Header), 0);
+    for (const std::vector<uint16_t>& stream : streams)
+        encodeStream(stream, out);
+    header.vertexBytes = (uint32_t)(out.size() - sizeof(Header));
+
+    std::vector<uint8_t> extra;
+    encodeIndices(mesh.indices, remap, out, extra);
+    header.extraBytes = (uint32_t)extra.size();
+    out.insert(out.end(), extra.begin(), extra.end());
+    std::memcpy(out.data(), &header, sizeof(header));
+    return true;
+}
+
+bool decodeMesh(const uint8_t* data, size_t size, MeshData& mesh) {
+    PROFILE_ZONE("Decode mesh");
+    Header header;
+    if (size < sizeof(header))
+        return false;
+    std::memcpy(&header, data, sizeof(header));
+    size_t triangleCount = header.indexCount / 3;
+    if (header.magic != codecMagic || header.version != codecVersion || header.indexCount % 3 != 0 ||
+        header.positionBits < 1 || header.positionBits > 16 || header.normalBits < 1 || header.normalBits > 16 ||
+        size != sizeof(header) + (size_t)header.vertexBytes + triangleCount + header.extraBytes)
+        return false;
+
+    // Каждый поток начинается с байта на блок — размер файла ограничивает число вершин
+    size_t vertexCount = header.vertexCount;
+    size_t blockCount = blockCountFor(vertexCount);
+    if (blockCount * streamCount > header.vertexBytes)
+        return false;
+
+    const uint8_t* vertexBegin = data + sizeof(header);
+    const uint8_t* vertexEnd = vertexBegin + header.vertexBytes;
+    StreamCursor streams[streamCount];
+    if (!openStreams(vertexBegin, vertexEnd, blockCount, streams))
+        return false;
+
+    Dequantize dequantize;
+    float positionMax = (float)((1u << header.positionBits) - 1);
+    for (int i = 0; i < 3; ++i) {
+        dequantize.origin[i] = header.bounds[i];
+        dequantize.step[i] = (header.bounds[3 + i] - header.bounds[i]) / positionMax;
+    }
+    dequantize.normalScale = 2.0f / (float)((1u << header.normalBits) - 1);
+
+    // Вершины и индексы друг от друга не зависят и разбираются параллельно
+    mesh.vertices.resize(vertexCount * meshVertexFloats);
+    mesh.indices.resize(header.indexCount);
+    const uint8_t* extra = vertexEnd + triangleCount;
+    bool indicesValid = true;
+    parallelFor(2, 1, [&](size_t begin, size_t end) {
+        for (size_t part = begin; part < end; ++part) {
+            if (part == 0)
+                decodeVertices(streams, vertexEnd, vertexCount, dequantize, mesh.vertices.data());
+            else
+                indicesValid = decodeIndices(vertexEnd, triangleCount, extra, extra + header.extraBytes, header.vertexCount, mesh.indices.data());
+        }
+    });
+    if (!indicesValid)
+        return false;
+
+    mesh.boundsMin = glm::vec3(header.bounds[0], header.bounds[1], header.bounds[2]);
+    mesh.boundsMax = glm::vec3(header.bounds[3], header.bounds[4], header.bounds[5]);
+    return true;
+}
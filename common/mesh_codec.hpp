@@ -0,0 +1,30 @@
+#pragma once
+
+#include "mesh_loader.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Сжатый формат мешей .cmesh для передачи и хранения: файл в несколько раз меньше сырых
+// float и индексов, а разбор быстрее чтения несжатых данных с диска.
+//
+// Вершины переупорядочиваются по первому использованию в индексах (неиспользуемые
+// выбрасываются), позиция квантуется в сетку по рамке меша, нормаль — в октаэдрические
+// координаты. Каждая компонента — отдельный поток: разности соседних вершин в зигзаг-коде,
+// уложенные блоками по 16 значений одинаковой разрядности. Треугольники кодируются
+// байтом: общее ребро с одним из недавних треугольников и третья вершина — новая или
+// на небольшом расстоянии назад. Индексы могут начинаться с другой вершины треугольника,
+// порядок обхода сохраняется.
+const char* const compressedMeshExtension = ".cmesh";
+
+struct MeshCodecOptions {
+    int positionBits = 16; // 1..16 на компоненту
+    int normalBits = 12;   // 1..16 на октаэдрическую координату
+};
+
+// Сжимает меш в out. Ложь, если индексы не кратны трём или ссылаются за пределы вершин.
+bool encodeMesh(const MeshData& mesh, std::vector<uint8_t>& out, const MeshCodecOptions& options = MeshCodecOptions());
+
+// Разбирает сжатый меш; данные проверяются, испорченный файл даёт ложь, а не выход за буфер
+bool decodeMesh(const uint8_t* data, size_t size, MeshData& mesh);
@@ -0,0 +1,969 @@
+#include "mesh_loader.hpp"
+#include "mesh_codec.hpp"
+#include "normals.hpp"
+#include "parallel.hpp"
+#include "profiler.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+const uint32_t cacheMagic = 0x4853454d; // "MESH"
+const uint32_t cacheVersion = 1;
+const char* cacheDirectory = ".mesh_cache";
+
+// Файл, отображённый в память только для чтения
+struct MappedFile {
+    const char* data = nullptr;
+    size_t size = 0;
+    int64_t modified = 0;
+
+    bool open(const std::string& path) {
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+            return false;
+        struct stat info;
+        if (fstat(fd, &info) != 0) {
+            ::close(fd);
+            return false;
+        }
+        size = (size_t)info.st_size;
+        modified = (int64_t)info.st_mtim.tv_sec * 1000000000ll + info.st_mtim.tv_nsec;
+        if (size > 0) {
+            void* mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (mapping == MAP_FAILED) {
+                ::close(fd);
+                return false;
+            }
+            madvise(mapping, size, MADV_SEQUENTIAL | MADV_WILLNEED);
+            data = (const char*)mapping;
+        }
+        ::close(fd);
+        return true;
+    }
+
+    ~MappedFile() {
+        if (data)
+            munmap((void*)data, size);
+    }
+};
+
+struct CacheHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t sourceSize;
+    int64_t sourceModified;
+    uint64_t vertexFloats;
+    uint64_t indexCount;
+    float bounds[6];
+};
+
+uint64_t hashBytes(uint64_t hash, const void* data, size_t size) {
+    // FNV-1a
+    const unsigned char* bytes = (const unsigned char*)data;
+    for (size_t i = 0; i < size; ++i) {
+        hash ^= bytes[i];
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+uint64_t mixHash(uint64_t value) {
+    value ^= value >> 33;
+    value *= 0xff51afd7ed558ccdull;
+    value ^= value >> 33;
+    value *= 0xc4ceb9fe1a85ec53ull;
+    value ^= value >> 33;
+    return value;
+}
+
+std::string cachePath(const std::string& path) {
+    std::error_code error;
+    std::string absolute = std::filesystem::absolute(path, error).string();
+    uint64_t hash = hashBytes(14695981039346656037ull, absolute.data(), absolute.size());
+    char name[32];
+    std::snprintf(name, sizeof(name), "%016llx.mesh", (unsigned long long)hash);
+    return std::string(cacheDirectory) + "/" + name;
+}
+
+bool loadCache(const std::string& path, const MappedFile& source, MeshData& mesh) {
+    MappedFile cache;
+    if (!cache.open(cachePath(path)) || cache.size < sizeof(CacheHeader))
+        return false;
+
+    CacheHeader header;
+    std::memcpy(&header, cache.data, sizeof(header));
+    if (header.magic != cacheMagic || header.version != cacheVersion ||
+        header.sourceSize != source.size || header.sourceModified != source.modified)
+        return false;
+
+    size_t vertexBytes = header.vertexFloats * sizeof(GLfloat);
+    size_t indexBytes = header.indexCount * sizeof(GLuint);
+    if (cache.size != sizeof(header) + vertexBytes + indexBytes)
+        return false;
+
+    mesh.vertices.resize(header.vertexFloats);
+    mesh.indices.resize(header.indexCount);
+    std::memcpy(mesh.vertices.data(), cache.data + sizeof(header), vertexBytes);
+    std::memcpy(mesh.indices.data(), cache.data + sizeof(header) + vertexBytes, indexBytes);
+    mesh.boundsMin = glm::vec3(header.bounds[0], header.bounds[1], header.bounds[2]);
+    mesh.boundsMax = glm::vec3(header.bounds[3], header.bounds[4], header.bounds[5]);
+    return true;
+}
+
+void saveCache(const std::string& path, const MappedFile& source, const MeshData& mesh) {
+    std::error_code error;
+    std::filesystem::create_directories(cacheDirectory, error);
+
+    // Пишем во временный файл и переименовываем, чтобы прерванная запись не оставила битый кэш
+    std::string target = cachePath(path);
+    std::string temporary = target + ".tmp";
+    std::ofstream file(temporary, std::ios::binary);
+    if (!file)
+        return;
+
+    CacheHeader header = {
+        cacheMagic, cacheVersion, source.size, source.modified,
+        mesh.vertices.size(), mesh.indices.size(),
+        { mesh.boundsMin.x, mesh.boundsMin.y, mesh.boundsMin.z, mesh.boundsMax.x, mesh.boundsMax.y, mesh.boundsMax.z }
+    };
+    file.write((const char*)&header, sizeof(header));
+    file.write((const char*)mesh.vertices.data(), mesh.vertices.size() * sizeof(GLfloat));
+    file.write((const char*)mesh.indices.data(), mesh.indices.size() * sizeof(GLuint));
+    file.close();
+    if (file)
+        std::filesystem::rename(temporary, target, error);
+}
+
+// ---- Разбор текста ----
+
+inline const char* skipSpaces(const char* p, const char* end) {
+    while (p < end && (*p == ' ' || *p == '\t' || *p == '\r'))
+        ++p;
+    return p;
+}
+
+inline const char* nextLine(const char* p, const char* end) {
+    const char* newline = (const char*)std::memchr(p, '\n', end - p);
+    return newline ? newline + 1 : end;
+}
+
+template <typename T>
+inline bool parseNumber(const char*& p, const char* end, T& value) {
+    p = skipSpaces(p, end);
+    if (p < end && *p == '+')
+        ++p;
+    auto result = std::from_chars(p, end, value);
+    if (result.ec != std::errc())
+        return false;
+    p = result.ptr;
+    return true;
+}
+
+// Делит [begin, end) на куски по границам строк
+std::vector<const char*> splitLines(const char* begin, const char* end, size_t chunkCount) {
+    std::vector<const char*> bounds = { begin };
+    size_t size = end - begin;
+    for (size_t i = 1; i < chunkCount; ++i) {
+        const char* p = std::max(begin + size * i / chunkCount, bounds.back());
+        p = p > begin ? nextLine(p - 1, end) : p;
+        bounds.push_back(p);
+    }
+    bounds.push_back(end);
+    return bounds;
+}
+
+size_t chunkCountFor(size_t bytes) {
+    const size_t minChunkBytes = 1 << 20;
+    return std::max<size_t>(1, std::min<size_t>(workerCount() * 4, bytes / minChunkBytes));
+}
+
+// ---- Сборка меша ----
+
+void computeBounds(MeshData& mesh) {
+    size_t vertexCount = mesh.vertices.size() / meshVertexFloats;
+    if (vertexCount == 0) {
+        mesh.boundsMin = mesh.boundsMax = glm::vec3(0.0f);
+        return;
+    }
+    mesh.boundsMin = glm::vec3(1e30f);
+    mesh.boundsMax = glm::vec3(-1e30f);
+    for (size_t v = 0; v < vertexCount; ++v) {
+        glm::vec3 position(mesh.vertices[v * meshVertexFloats], mesh.vertices[v * meshVertexFloats + 1], mesh.vertices[v * meshVertexFloats + 2]);
+        mesh.boundsMin = glm::min(mesh.boundsMin, position);
+        mesh.boundsMax = glm::max(mesh.boundsMax, position);
+    }
+}
+
+// Открытая адресация по заранее посчитанным хэшам; возвращает для каждого ключа
+// номер первого равного ему ключа в порядке появления
+template <typename Equal>
+std::vector<GLuint> uniqueByHash(const std::vector<uint64_t>& hashes, Equal equal, size_t& uniqueCount) {
+    size_t capacity = 16;
+    while (capacity < hashes.size() * 2)
+        capacity <<= 1;
+    std::vector<GLuint> table(capacity, ~0u);
+    std::vector<GLuint> first(hashes.size());
+
+    uniqueCount = 0;
+    for (size_t i = 0; i < hashes.size(); ++i) {
+        size_t slot = hashes[i] & (capacity - 1);
+        while (true) {
+            GLuint candidate = table[slot];
+            if (candidate == ~0u) {
+                table[slot] = (GLuint)i;
+                first[i] = (GLuint)i;
+                ++uniqueCount;
+                break;
+            }
+            if (hashes[candidate] == hashes[i] && equal(candidate, i)) {
+                first[i] = candidate;
+                break;
+            }
+            slot = (slot + 1) & (capacity - 1);
+        }
+    }
+    return first;
+}
+
+// ---- OBJ ----
+
+struct ObjCorner {
+    int64_t position;
+    int64_t normal;     // 0 — нормали нет
+};
+
+struct ObjChunk {
+    std::vector<GLfloat> positions;
+    std::vector<GLfloat> normals;
+    std::vector<ObjCorner> corners; // по три на треугольник, индексы ещё не разрешены
+    std::vector<uint8_t> relative;  // бит 0/1: отрицательный индекс позиции/нормали
+    bool failed = false;
+    size_t failedLine = 0;
+};
+
+bool parseObjIndex(const char*& p, const char* end, ObjCorner& corner, uint8_t& relative) {
+    long long value;
+    if (!parseNumber(p, end, value) || value == 0)
+        return false;
+    corner.position = value;
+    corner.normal = 0;
+    relative = value < 0 ? 1 : 0;
+
+    // v, v/vt, v//vn, v/vt/vn
+    if (p < end && *p == '/') {
+        ++p;
+        if (p < end && *p != '/') {
+            long long texcoord;
+            if (!parseNumber(p, end, texcoord))
+                return false;
+        }
+        if (p < end && *p == '/') {
+            ++p;
+            if (!parseNumber(p, end, value) || value == 0)
+                return false;
+            corner.normal = value;
+            if (value < 0)
+                relative |= 2;
+        }
+    }
+    return true;
+}
+
+void parseObjChunk(const char* begin, const char* end, ObjChunk& chunk) {
+    std::vector<ObjCorner> polygon;
+    std::vector<uint8_t> polygonRelative;
+    size_t line = 0;
+
+    for (const char* p = begin; p < end; p = nextLine(p, end), ++line) {
+        const char* q = skipSpaces(p, end);
+        if (q + 1 >= end)
+            continue;
+
+        if (q[0] == 'v' && (q[1] == ' ' || q[1] == '\t')) {
+            q += 1;
+            float x, y, z;
+            if (!parseNumber(q, end, x) || !parseNumber(q, end, y) || !parseNumber(q, end, z)) {
+                chunk.failed = true;
+                chunk.failedLine = line;
+                return;
+            }
+            chunk.positions.insert(chunk.positions.end(), { x, y, z });
+        } else if (q[0] == 'v' && q[1] == 'n') {
+            q += 2;
+            float x, y, z;
+            if (!parseNumber(q, end, x) || !parseNumber(q, end, y) || !parseNumber(q, end, z)) {
+                chunk.failed = true;
+                chunk.failedLine = line;
+                return;
+            }
+            chunk.normals.insert(chunk.normals.end(), { x, y, z });
+        } else if (q[0] == 'f' && (q[1] == ' ' || q[1] == '\t')) {
+            q += 1;
+            polygon.clear();
+            polygonRelative.clear();
+            const char* lineEnd = nextLine(q, end);
+            while (true) {
+                q = skipSpaces(q, lineEnd);
+                if (q >= lineEnd || *q == '\n' || *q == '#')
+                    break;
+                ObjCorner corner;
+                uint8_t relative;
+                if (!parseObjIndex(q, lineEnd, corner, relative)) {
+                    chunk.failed = true;
+                    chunk.failedLine = line;
+                    return;
+                }
+                // Отрицательный индекс считается от конца уже прочитанных вершин этого куска
+                if (relative & 1)
+                    corner.position += (int64_t)chunk.positions.size() / 3;
+                if (relative & 2)
+                    corner.normal += (int64_t)chunk.normals.size() / 3;
+                polygon.push_back(corner);
+                polygonRelative.push_back(relative);
+            }
+            for (size_t i = 2; i < polygon.size(); ++i) {
+                size_t triangle[3] = { 0, i - 1, i };
+                for (size_t corner : triangle) {
+                    chunk.corners.push_back(polygon[corner]);
+                    chunk.relative.push_back(polygonRelative[corner]);
+                }
+            }
+        }
+    }
+}
+
+bool loadObj(const std::string& path, const MappedFile& file, MeshData& mesh) {
+    size_t chunkCount = chunkCountFor(file.size);
+    std::vector<const char*> bounds = splitLines(file.data, file.data + file.size, chunkCount);
+    std::vector<ObjChunk> chunks(chunkCount);
+
+    parallelFor(chunkCount, 1, [&](size_t begin, size_t end) {
+        for (size_t c = begin; c < end; ++c)
+            parseObjChunk(bounds[c], bounds[c + 1], chunks[c]);
+    });
+
+    // Смещения кусков в общих массивах
+    std::vector<size_t> positionOffset(chunkCount + 1, 0), normalOffset(chunkCount + 1, 0), cornerOffset(chunkCount + 1, 0);
+    for (size_t c = 0; c < chunkCount; ++c) {
+        if (chunks[c].failed) {
+            size_t line = chunks[c].failedLine + 1;
+            for (const char* p = file.data; p < bounds[c]; p = nextLine(p, bounds[c]))
+                ++line;
+            std::cerr << "Failed to parse " << path << " at line " << line << std::endl;
+            return false;
+        }
+        positionOffset[c + 1] = positionOffset[c] + chunks[c].positions.size() / 3;
+        normalOffset[c + 1] = normalOffset[c] + chunks[c].normals.size() / 3;
+        cornerOffset[c + 1] = cornerOffset[c] + chunks[c].corners.size();
+    }
+    size_t positionCount = positionOffset[chunkCount];
+    size_t normalCount = normalOffset[chunkCount];
+    size_t cornerCount = cornerOffset[chunkCount];
+
+    // Разрешаем индексы в глобальные (с нуля); без нормалей индекс нормали равен ~0
+    std::vector<uint64_t> cornerKeys(cornerCount);
+    std::atomic<bool> invalid(false);
+    std::atomic<bool> anyNormals(false);
+    parallelFor(chunkCount, 1, [&](size_t begin, size_t end) {
+        for (size_t c = begin; c < end; ++c) {
+            const ObjChunk& chunk = chunks[c];
+            bool chunkNormals = false;
+            for (size_t i = 0; i < chunk.corners.size(); ++i) {
+                const ObjCorner& corner = chunk.corners[i];
+                int64_t position = (chunk.relative[i] & 1) ? (int64_t)positionOffset[c] + corner.position : corner.position - 1;
+                int64_t normal = -1;
+                if (corner.normal != 0) {
+                    normal = (chunk.relative[i] & 2) ? (int64_t)normalOffset[c] + corner.normal : corner.normal - 1;
+                    chunkNormals = true;
+                    if (normal < 0 || normal >= (int64_t)normalCount)
+                        invalid = true;
+                }
+                if (position < 0 || position >= (int64_t)positionCount)
+                    invalid = true;
+                cornerKeys[cornerOffset[c] + i] = ((uint64_t)(uint32_t)normal << 32) | (uint32_t)position;
+            }
+            if (chunkNormals)
+                anyNormals = true;
+        }
+    });
+    if (invalid) {
+        std::cerr << "Mesh " << path << " references a vertex that does not exist" << std::endl;
+        return false;
+    }
+
+    std::vector<GLfloat> positions(positionCount * 3), normals(normalCount * 3);
+    parallelFor(chunkCount, 1, [&](size_t begin, size_t end) {
+        for (size_t c = begin; c < end; ++c) {
+            std::copy(chunks[c].positions.begin(), chunks[c].positions.end(), positions.begin() + positionOffset[c] * 3);
+            std::copy(chunks[c].normals.begin(), chunks[c].normals.end(), normals.begin() + normalOffset[c] * 3);
+        }
+    });
+    chunks.clear();
+
+    mesh.indices.resize(cornerCount);
+    if (!anyNormals) {
+        // Без нормалей вершина OBJ — это просто позиция
+        mesh.vertices.assign(positionCount * meshVertexFloats, 0.0f);
+        parallelFor(positionCount, 1 << 14, [&](size_t begin, size_t end) {
+            for (size_t v = begin; v < end; ++v)
+                std::copy(&positions[v * 3], &positions[v * 3] + 3, &mesh.vertices[v * meshVertexFloats]);
+        });
+        parallelFor(cornerCount, 1 << 16, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i)
+                mesh.indices[i] = (GLuint)cornerKeys[i];
+        });
+        return true;
+    }
+
+    // Каждая уникальная пара (позиция, нормаль) становится вершиной
+    std::vector<uint64_t> hashes(cornerCount);
+    parallelFor(cornerCount, 1 << 16, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i)
+            hashes[i] = mixHash(cornerKeys[i]);
+    });
+    size_t uniqueCount;
+    std::vector<GLuint> first = uniqueByHash(hashes, [&](size_t a, size_t b) {
+        return cornerKeys[a] == cornerKeys[b];
+    }, uniqueCount);
+
+    std::vector<GLuint> vertexOf(cornerCount);
+    mesh.vertices.clear();
+    mesh.vertices.reserve(uniqueCount * meshVertexFloats);
+    for (size_t i = 0; i < cornerCount; ++i) {
+        if (first[i] != i) {
+            vertexOf[i] = vertexOf[first[i]];
+            continue;
+        }
+        vertexOf[i] = (GLuint)(mesh.vertices.size() / meshVertexFloats);
+        uint32_t position = (uint32_t)cornerKeys[i];
+        uint32_t normal = (uint32_t)(cornerKeys[i] >> 32);
+        mesh.vertices.insert(mesh.vertices.end(), &positions[position * 3], &positions[position * 3] + 3);
+        if (normal != ~0u)
+            mesh.vertices.insert(mesh.vertices.end(), &normals[normal * 3], &normals[normal * 3] + 3);
+        else
+            mesh.vertices.insert(mesh.vertices.end(), { 0.0f, 0.0f, 0.0f });
+    }
+    mesh.indices = std::move(vertexOf);
+    return true;
+}
+
+// ---- PLY ----
+
+enum class PlyType { Int8, UInt8, Int16, UInt16, Int32, UInt32, Float32, Float64, Invalid };
+
+PlyType plyType(const std::string& name) {
+    if (name == "char" || name == "int8") return PlyType::Int8;
+    if (name == "uchar" || name == "uint8") return PlyType::UInt8;
+    if (name == "short" || name == "int16") return PlyType::Int16;
+    if (name == "ushort" || name == "uint16") return PlyType::UInt16;
+    if (name == "int" || name == "int32") return PlyType::Int32;
+    if (name == "uint" || name == "uint32") return PlyType::UInt32;
+    if (name == "float" || name == "float32") return PlyType::Float32;
+    if (name == "double" || name == "float64") return PlyType::Float64;
+    return PlyType::Invalid;
+}
+
+size_t plyTypeSize(PlyType type) {
+    switch (type) {
+    case PlyType::Int8: case PlyType::UInt8: return 1;
+    case PlyType::Int16: case PlyType::UInt16: return 2;
+    case PlyType::Int32: case PlyType::UInt32: case PlyType::Float32: return 4;
+    case PlyType::Float64: return 8;
+    default: return 0;
+    }
+}
+
+// Помещаются ли count значений по size байт между p и end; без умножения, которое может переполниться
+inline bool plyFits(const char* p, const char* end, size_t count, size_t size) {
+    return size == 0 || count <= (size_t)(end - p) / size;
+}
+
+inline double readPlyValue(const char* p, PlyType type) {
+    switch (type) {
+    case PlyType::Int8: return (double)*(const int8_t*)p;
+    case PlyType::UInt8: return (double)*(const uint8_t*)p;
+    case PlyType::Int16: { int16_t v; std::memcpy(&v, p, 2); return v; }
+    case PlyType::UInt16: { uint16_t v; std::memcpy(&v, p, 2); return v; }
+    case PlyType::Int32: { int32_t v; std::memcpy(&v, p, 4); return v; }
+    case PlyType::UInt32: { uint32_t v; std::memcpy(&v, p, 4); return v; }
+    case PlyType::Float32: { float v; std::memcpy(&v, p, 4); return v; }
+    case PlyType::Float64: { double v; std::memcpy(&v, p, 8); return v; }
+    default: return 0.0;
+    }
+}
+
+const size_t maxPlyVertexProperties = 64;
+
+struct PlyProperty {
+    std::string name;
+    PlyType type = PlyType::Invalid;
+    PlyType countType = PlyType::Invalid; // Invalid — не список
+    size_t offset = 0;                    // смещение в записи фиксированного размера
+};
+
+struct PlyElement {
+    std::string name;
+    size_t count = 0;
+    std::vector<PlyProperty> properties;
+    bool hasLists = false;
+    size_t stride = 0;
+
+    int find(const char* property) const {
+        for (size_t i = 0; i < properties.size(); ++i) {
+            if (properties[i].name == property)
+                return (int)i;
+        }
+        return -1;
+    }
+};
+
+bool parsePlyHeader(const MappedFile& file, std::vector<PlyElement>& elements, bool& binary, size_t& bodyOffset) {
+    const char* end = file.data + file.size;
+    const char* p = file.data;
+    bool sawFormat = false;
+
+    for (bool first = true; p < end; first = false) {
+        const char* lineEnd = nextLine(p, end);
+        std::string line(p, lineEnd);
+        p = lineEnd;
+        while (!line.empty() && (line.back() == '\n' || line.back() == '\r'))
+            line.pop_back();
+
+        char word[64] = {}, a[64] = {}, b[64] = {}, c[64] = {};
+        int fields = std::sscanf(line.c_str(), "%63s %63s %63s %63s", word, a, b, c);
+        if (first) {
+            if (std::strcmp(word, "ply") != 0)
+                return false;
+            continue;
+        }
+        if (fields <= 0 || std::strcmp(word, "comment") == 0 || std::strcmp(word, "obj_info") == 0)
+            continue;
+
+        if (std::strcmp(word, "format") == 0) {
+            if (std::strcmp(a, "ascii") == 0)
+                binary = false;
+            else if (std::strcmp(a, "binary_little_endian") == 0)
+                binary = true;
+            else
+                return false;
+            sawFormat = true;
+        } else if (std::strcmp(word, "element") == 0 && fields >= 3) {
+            PlyElement element;
+            element.name = a;
+            element.count = std::strtoull(b, nullptr, 10);
+            elements.push_back(element);
+        } else if (std::strcmp(word, "property") == 0 && !elements.empty()) {
+            PlyElement& element = elements.back();
+            PlyProperty property;
+            if (std::strcmp(a, "list") == 0 && fields == 4) {
+                char name[64] = {};
+                std::sscanf(line.c_str(), "%*s %*s %*s %*s %63s", name);
+                property.countType = plyType(b);
+                property.type = plyType(c);
+                property.name = name;
+                element.hasLists = true;
+                if (property.countType == PlyType::Invalid)
+                    return false;
+            } else {
+                property.type = plyType(a);
+                property.name = b;
+                property.offset = element.stride;
+                element.stride += plyTypeSize(property.type);
+            }
+            if (property.type == PlyType::Invalid)
+                return false;
+            element.properties.push_back(property);
+        } else if (std::strcmp(word, "end_header") == 0) {
+            bodyOffset = p - file.data;
+            return sawFormat;
+        }
+    }
+    return false;
+}
+
+// Какие свойства элементов PLY идут в меш
+struct PlyLayout {
+    int columns[6];     // x, y, z, nx, ny, nz среди свойств вершины, -1 — нет
+    int faceList;       // список индексов среди свойств грани
+    size_t vertexCount;
+};
+
+void storePlyVertex(GLfloat* vertex, const double* values, const PlyLayout& layout) {
+    for (int i = 0; i < 6; ++i)
+        vertex[i] = layout.columns[i] >= 0 ? (GLfloat)values[layout.columns[i]] : 0.0f;
+}
+
+void appendFan(const std::vector<uint32_t>& polygon, GLuint* out) {
+    for (size_t k = 2; k < polygon.size(); ++k) {
+        *out++ = polygon[0];
+        *out++ = polygon[k - 1];
+        *out++ = polygon[k];
+    }
+}
+
+bool readBinaryPlyVertices(const char*& p, const char* end, const PlyElement& element, const PlyLayout& layout, MeshData& mesh) {
+    if (!plyFits(p, end, element.count, element.stride))
+        return false;
+
+    // Записи фиксированного размера: каждая вершина читается независимо
+    const char* base = p;
+    parallelFor(element.count, 1 << 14, [&](size_t begin, size_t finish) {
+        double values[maxPlyVertexProperties];
+        for (size_t v = begin; v < finish; ++v) {
+            const char* record = base + v * element.stride;
+            for (size_t i = 0; i < element.properties.size(); ++i)
+                values[i] = readPlyValue(record + element.properties[i].offset, element.properties[i].type);
+            storePlyVertex(&mesh.vertices[v * meshVertexFloats], values, layout);
+        }
+    });
+    p += element.stride * element.count;
+    return true;
+}
+
+bool readBinaryPlyFaces(const char*& p, const char* end, const PlyElement& element, const PlyLayout& layout, MeshData& mesh) {
+    // Размер записи грани зависит от длины списка: сначала последовательно
+    // находим начала записей, затем разбираем их параллельно. Каждая запись занимает
+    // хотя бы байт, так что счётчик из заголовка не больше остатка файла.
+    if (element.count > (size_t)(end - p))
+        return false;
+    std::vector<const char*> records(element.count);
+    std::vector<size_t> triangleOffset(element.count + 1, 0);
+    const char* q = p;
+    for (size_t f = 0; f < element.count; ++f) {
+        records[f] = q;
+        size_t triangles = 0;
+        for (size_t i = 0; i < element.properties.size(); ++i) {
+            const PlyProperty& property = element.properties[i];
+            if (property.countType == PlyType::Invalid) {
+                if (!plyFits(q, end, 1, plyTypeSize(property.type)))
+                    return false;
+                q += plyTypeSize(property.type);
+                continue;
+            }
+            if (!plyFits(q, end, 1, plyTypeSize(property.countType)))
+                return false;
+            double length = readPlyValue(q, property.countType);
+            q += plyTypeSize(property.countType);
+            // Отрицательная или дробная длина списка — испорченный файл; сравнение отсеивает и NaN
+            if (!(length >= 0.0 && length <= (double)(end - q)) || length != std::floor(length))
+                return false;
+            size_t count = (size_t)length;
+            if (!plyFits(q, end, count, plyTypeSize(property.type)))
+                return false;
+            q += count * plyTypeSize(property.type);
+            if ((int)i == layout.faceList && count >= 3)
+                triangles = count - 2;
+        }
+        triangleOffset[f + 1] = triangleOffset[f] + triangles;
+    }
+    p = q;
+
+    std::atomic<bool> valid(true);
+    mesh.indices.resize(triangleOffset[element.count] * 3);
+    parallelFor(element.count, 1 << 14, [&](size_t begin, size_t finish) {
+        std::vector<uint32_t> polygon;
+        for (size_t f = begin; f < finish; ++f) {
+            const char* r = records[f];
+            for (size_t i = 0; i < element.properties.size(); ++i) {
+                const PlyProperty& property = element.properties[i];
+                if (property.countType == PlyType::Invalid) {
+                    r += plyTypeSize(property.type);
+                    continue;
+                }
+                size_t count = (size_t)readPlyValue(r, property.countType);
+                r += plyTypeSize(property.countType);
+                if ((int)i == layout.faceList) {
+                    polygon.resize(count);
+                    for (size_t k = 0; k < count; ++k) {
+                        double index = readPlyValue(r + k * plyTypeSize(property.type), property.type);
+                        if (index < 0 || index >= (double)layout.vertexCount)
+                            valid = false;
+                        polygon[k] = (uint32_t)index;
+                    }
+                }
+                r += count * plyTypeSize(property.type);
+            }
+            appendFan(polygon, &mesh.indices[triangleOffset[f] * 3]);
+        }
+    });
+    return valid;
+}
+
+bool readAsciiPlyVertices(const char* begin, const char* end, const PlyElement& element, const PlyLayout& layout, MeshData& mesh) {
+    size_t chunkCount = chunkCountFor(end - begin);
+    std::vector<const char*> bounds = splitLines(begin, end, chunkCount);
+
+    // Номер первой вершины каждого куска
+    std::vector<size_t> firstRecord(chunkCount + 1, 0);
+    parallelFor(chunkCount, 1, [&](size_t first, size_t last) {
+        for (size_t c = first; c < last; ++c) {
+            for (const char* q = bounds[c]; q < bounds[c + 1]; q = nextLine(q, bounds[c + 1]))
+                ++firstRecord[c + 1];
+        }
+    });
+    for (size_t c = 0; c < chunkCount; ++c)
+        firstRecord[c + 1] += firstRecord[c];
+
+    std::atomic<bool> valid(true);
+    parallelFor(chunkCount, 1, [&](size_t first, size_t last) {
+        double values[maxPlyVertexProperties];
+        for (size_t c = first; c < last; ++c) {
+            size_t v = firstRecord[c];
+            for (const char* q = bounds[c]; q < bounds[c + 1] && v < layout.vertexCount; q = nextLine(q, bounds[c + 1]), ++v) {
+                for (size_t i = 0; i < element.properties.size(); ++i) {
+                    if (!parseNumber(q, bounds[c + 1], values[i]))
+                        valid = false;
+                }
+                storePlyVertex(&mesh.vertices[v * meshVertexFloats], values, layout);
+            }
+        }
+    });
+    return valid;
+}
+
+bool readAsciiPlyFaces(const char* begin, const char* end, const PlyElement& element, const PlyLayout& layout, MeshData& mesh) {
+    size_t chunkCount = chunkCountFor(end - begin);
+    std::vector<const char*> bounds = splitLines(begin, end, chunkCount);
+
+    // Число треугольников заранее неизвестно: куски копят индексы отдельно, потом склеиваются
+    std::vector<std::vector<GLuint>> chunkIndices(chunkCount);
+    std::atomic<bool> valid(true);
+    parallelFor(chunkCount, 1, [&](size_t first, size_t last) {
+        std::vector<uint32_t> polygon;
+        for (size_t c = first; c < last; ++c) {
+            for (const char* q = bounds[c]; q < bounds[c + 1]; q = nextLine(q, bounds[c + 1])) {
+                polygon.clear();
+                for (size_t i = 0; i < element.properties.size(); ++i) {
+                    long long count = 1;
+                    if (element.properties[i].countType != PlyType::Invalid && !parseNumber(q, bounds[c + 1], count))
+                        valid = false;
+                    for (long long k = 0; k < count; ++k) {
+                        double value;
+                        if (!parseNumber(q, bounds[c + 1], value))
+                            valid = false;
+                        if ((int)i != layout.faceList)
+                            continue;
+                        if (value < 0 || value >= (double)layout.vertexCount)
+                            valid = false;
+                        polygon.push_back((uint32_t)value);
+                    }
+                }
+                if (polygon.size() >= 3) {
+                    size_t offset = chunkIndices[c].size();
+                    chunkIndices[c].resize(offset + (polygon.size() - 2) * 3);
+                    appendFan(polygon, &chunkIndices[c][offset]);
+                }
+            }
+        }
+    });
+
+    std::vector<size_t> offset(chunkCount + 1, 0);
+    for (size_t c = 0; c < chunkCount; ++c)
+        offset[c + 1] = offset[c] + chunkIndices[c].size();
+    mesh.indices.resize(offset.back());
+    parallelFor(chunkCount, 1, [&](size_t first, size_t last) {
+        for (size_t c = first; c < last; ++c)
+            std::copy(chunkIndices[c].begin(), chunkIndices[c].end(), mesh.indices.begin() + offset[c]);
+    });
+    return valid;
+}
+
+bool loadPly(const std::string& path, const MappedFile& file, MeshData& mesh) {
+    std::vector<PlyElement> elements;
+    bool binary = false;
+    size_t bodyOffset = 0;
+    if (!parsePlyHeader(file, elements, binary, bodyOffset)) {
+        std::cerr << "Unsupported or malformed PLY header in " << path << std::endl;
+        return false;
+    }
+
+    const PlyElement* vertexElement = nullptr;
+    const PlyElement* faceElement = nullptr;
+    for (const PlyElement& element : elements) {
+        if (element.name == "vertex")
+            vertexElement = &element;
+        else if (element.name == "face")
+            faceElement = &element;
+    }
+    if (!vertexElement || !faceElement) {
+        std::cerr << "PLY file " << path << " has no vertex or face element" << std::endl;
+        return false;
+    }
+
+    static const char* attributeNames[6] = { "x", "y", "z", "nx", "ny", "nz" };
+    PlyLayout layout;
+    for (int i = 0; i < 6; ++i)
+        layout.columns[i] = vertexElement->find(attributeNames[i]);
+    layout.faceList = faceElement->find("vertex_indices");
+    if (layout.faceList < 0)
+        layout.faceList = faceElement->find("vertex_index");
+    layout.vertexCount = vertexElement->count;
+    if (layout.columns[0] < 0 || layout.columns[1] < 0 || layout.columns[2] < 0 || layout.faceList < 0 ||
+        vertexElement->hasLists || vertexElement->properties.size() > maxPlyVertexProperties) {
+        std::cerr << "PLY file " << path << " lacks x/y/z or vertex_indices" << std::endl;
+        return false;
+    }
+    if (layout.columns[3] < 0 || layout.columns[4] < 0 || layout.columns[5] < 0)
+        layout.columns[3] = layout.columns[4] = layout.columns[5] = -1;
+
+    // Вершина занимает в теле хотя бы байт: больший счётчик — испорченный заголовок, а не повод для огромного выделения
+    if (layout.vertexCount > file.size) {
+        std::cerr << "PLY file " << path << " declares more vertices than it can hold" << std::endl;
+        return false;
+    }
+    mesh.vertices.assign(layout.vertexCount * meshVertexFloats, 0.0f);
+
+    // Элементы идут в теле подряд, начало каждого находится только после предыдущего
+    const char* end = file.data + file.size;
+    const char* p = file.data + bodyOffset;
+    for (const PlyElement& element : elements) {
+        bool valid = true;
+        if (binary) {
+            if (&element == vertexElement)
+                valid = readBinaryPlyVertices(p, end, element, layout, mesh);
+            else if (&element == faceElement)
+                valid = readBinaryPlyFaces(p, end, element, layout, mesh);
+            else if (element.hasLists) {
+                std::cerr << "PLY element " << element.name << " with lists is not supported in " << path << std::endl;
+                return false;
+            } else if (plyFits(p, end, element.count, element.stride))
+                p += element.stride * element.count;
+            else
+                valid = false;
+        } else {
+            const char* elementBegin = p;
+            for (size_t i = 0; i < element.count && p < end; ++i)
+                p = nextLine(p, end);
+            if (&element == vertexElement)
+                valid = readAsciiPlyVertices(elementBegin, p, element, layout, mesh);
+            else if (&element == faceElement)
+                valid = readAsciiPlyFaces(elementBegin, p, element, layout, mesh);
+        }
+
+        if (!valid || p > end) {
+            std::cerr << "Failed to parse PLY element " << element.name << " in " << path << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+bool hasNormals(const MeshData& mesh) {
+    for (size_t v = 0; v < mesh.vertices.size(); v += meshVertexFloats) {
+        if (mesh.vertices[v + 3] != 0.0f || mesh.vertices[v + 4] != 0.0f || mesh.vertices[v + 5] != 0.0f)
+            return true;
+    }
+    return false;
+}
+
+} // namespace
+
+bool loadMesh(const std::string& path, MeshData& mesh, bool useCache) {
+    PROFILE_ZONE("Load mesh");
+    MappedFile file;
+    if (!file.open(path)) {
+        std::cerr << "Failed to open mesh " << path << std::endl;
+        return false;
+    }
+
+    std::string extension = std::filesystem::path(path).extension().string();
+    std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+    // Сжатый меш уже слит и с нормалями; кэш для него только увеличил бы чтение с диска
+    if (extension == compressedMeshExtension) {
+        if (decodeMesh((const uint8_t*)file.data, file.size, mesh))
+            return true;
+        std::cerr << "Malformed compressed mesh " << path << std::endl;
+        return false;
+    }
+    if (useCache && loadCache(path, file, mesh))
+        return true;
+
+    mesh = MeshData();
+    bool loaded;
+    if (extension == ".obj")
+        loaded = loadObj(path, file, mesh);
+    else if (extension == ".ply")
+        loaded = loadPly(path, file, mesh);
+    else {
+        std::cerr << "Unsupported mesh format " << extension << " (" << path << ")" << std::endl;
+        return false;
+    }
+    if (!loaded)
+        return false;
+
+    weldVertices(mesh);
+    if (!hasNormals(mesh))
+        computeVertexNormals(mesh);
+    computeBounds(mesh);
+
+    if (useCache)
+        saveCache(path, file, mesh);
+    return true;
+}
+
+// Сливает вершины с побитово равными атрибутами и выбрасывает неиспользуемые
+void weldVertices(MeshData& mesh) {
+    PROFILE_ZONE("Weld vertices");
+    size_t vertexCount = mesh.vertices.size() / meshVertexFloats;
+    GLfloat* vertices = mesh.vertices.data();
+
+    std::vector<uint64_t> hashes(vertexCount);
+    parallelFor(vertexCount, 1 << 14, [&](size_t begin, size_t end) {
+        for (size_t v = begin; v < end; ++v) {
+            // -0.0 и 0.0 различаются побитово; прибавление нуля приводит их к одному виду
+            for (int i = 0; i < meshVertexFloats; ++i)
+                vertices[v * meshVertexFloats + i] += 0.0f;
+            hashes[v] = mixHash(hashBytes(14695981039346656037ull, vertices + v * meshVertexFloats, meshVertexFloats * sizeof(GLfloat)));
+        }
+    });
+
+    size_t uniqueCount;
+    std::vector<GLuint> first = uniqueByHash(hashes, [&](size_t a, size_t b) {
+        return std::memcmp(vertices + a * meshVertexFloats, vertices + b * meshVertexFloats, meshVertexFloats * sizeof(GLfloat)) == 0;
+    }, uniqueCount);
+
+    std::vector<uint8_t> used(vertexCount, 0);
+    for (GLuint index : mesh.indices)
+        used[first[index]] = 1;
+
+    std::vector<GLuint> remap(vertexCount, ~0u);
+    std::vector<GLfloat> welded;
+    welded.reserve(uniqueCount * meshVertexFloats);
+    for (size_t v = 0; v < vertexCount; ++v) {
+        if (first[v] != v || !used[v])
+            continue;
+        remap[v] = (GLuint)(welded.size() / meshVertexFloats);
+        welded.insert(welded.end(), vertices + v * meshVertexFloats, vertices + (v + 1) * meshVertexFloats);
+    }
+
+    parallelFor(mesh.indices.size(), 1 << 16, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i)
+            mesh.indices[i] = remap[first[mesh.indices[i]]];
+    });
+    mesh.vertices.swap(welded);
+}
+
+glm::mat4 meshFitMatrix(const MeshData& mesh) {
+    glm::vec3 center = (mesh.boundsMin + mesh.boundsMax) * 0.5f;
+    glm::vec3 extent = (mesh.boundsMax - mesh.boundsMin) * 0.5f;
+    float radius = std::max(extent.x, std::max(extent.y, extent.z));
+    float scale = radius > 0.0f ? 1.0f / radius : 1.0f;
+
+    glm::mat4 fit = glm::mat4(scale);
+    fit[3] = glm::vec4(-center * scale, 1.0f);
+    return fit;
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include <string>
+#include <vector>
+
+// Число float на вершину: позиция (location 0), затем нормаль (location 1)
+const int meshVertexFloats = 6;
+
+// Индексированный меш с чередующимися атрибутами, готовый к glBufferData
+struct MeshData {
+    std::vector<GLfloat> vertices;
+    std::vector<GLuint> indices;
+    glm::vec3 boundsMin = glm::vec3(0.0f);
+    glm::vec3 boundsMax = glm::vec3(0.0f);
+};
+
+// Загружает .obj или .ply (ascii и binary_little_endian). Файл отображается в память и
+// разбирается кусками на всех ядрах, одинаковые вершины сливаются, многоугольники
+// разбиваются веером, отсутствующие нормали вычисляются. При useCache результат
+// сохраняется в .mesh_cache/ и следующие запуски читают его без разбора, пока исходный
+// файл не изменится. Сжатый .cmesh (mesh_codec.hpp) распаковывается напрямую, без кэша.
+bool loadMesh(const std::string& path, MeshData& mesh, bool useCache = true);
+
+// Сливает вершины с побитово равными атрибутами и выбрасывает неиспользуемые
+void weldVertices(MeshData& mesh);
+
+// Матрица, переносящая центр меша в начало координат и вписывающая его в куб [-1, 1]
+glm::mat4 meshFitMatrix(const MeshData& mesh);
@@ -0,0 +1,287 @@
+#include "normals.hpp"
+#include "parallel.hpp"
+#include "profiler.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace {
+
+const size_t triangleGrain = 1 << 14;
+
+#if defined(__SSE2__)
+
+// Вектор в SSE-регистре (x, y, z, 0)
+typedef __m128 Vec4;
+
+inline Vec4 loadPosition(const GLfloat* p) {
+    return _mm_setr_ps(p[0], p[1], p[2], 0.0f);
+}
+
+inline Vec4 sub(Vec4 a, Vec4 b) {
+    return _mm_sub_ps(a, b);
+}
+
+inline Vec4 mulScalar(Vec4 a, float s) {
+    return _mm_mul_ps(a, _mm_set1_ps(s));
+}
+
+inline Vec4 cross(Vec4 a, Vec4 b) {
+    Vec4 aYZX = _mm_shuffle_ps(a, a, _MM_SHUFFLE(3, 0, 2, 1));
+    Vec4 bYZX = _mm_shuffle_ps(b, b, _MM_SHUFFLE(3, 0, 2, 1));
+    Vec4 c = _mm_sub_ps(_mm_mul_ps(a, bYZX), _mm_mul_ps(aYZX, b));
+    return _mm_shuffle_ps(c, c, _MM_SHUFFLE(3, 0, 2, 1));
+}
+
+inline float dot(Vec4 a, Vec4 b) {
+    Vec4 m = _mm_mul_ps(a, b);
+    Vec4 s = _mm_add_ps(m, _mm_shuffle_ps(m, m, _MM_SHUFFLE(2, 3, 0, 1)));
+    s = _mm_add_ps(s, _mm_shuffle_ps(s, s, _MM_SHUFFLE(1, 0, 3, 2)));
+    return _mm_cvtss_f32(s);
+}
+
+// Накопители хранятся по четыре float на вершину, чтобы складывать одной инструкцией
+inline void accumulate(float* sum, Vec4 value) {
+    _mm_storeu_ps(sum, _mm_add_ps(_mm_loadu_ps(sum), value));
+}
+
+inline glm::vec3 toVec3(Vec4 a) {
+    alignas(16) float values[4];
+    _mm_store_ps(values, a);
+    return glm::vec3(values[0], values[1], values[2]);
+}
+
+#else
+
+// Скалярная замена для платформ без SSE2
+typedef glm::vec4 Vec4;
+
+inline Vec4 loadPosition(const GLfloat* p) {
+    return Vec4(p[0], p[1], p[2], 0.0f);
+}
+
+inline Vec4 sub(Vec4 a, Vec4 b) {
+    return a - b;
+}
+
+inline Vec4 mulScalar(Vec4 a, float s) {
+    return a * s;
+}
+
+inline Vec4 cross(Vec4 a, Vec4 b) {
+    return Vec4(glm::cross(glm::vec3(a), glm::vec3(b)), 0.0f);
+}
+
+inline float dot(Vec4 a, Vec4 b) {
+    return glm::dot(a, b);
+}
+
+inline void accumulate(float* sum, Vec4 value) {
+    for (int i = 0; i < 3; ++i)
+        sum[i] += value[i];
+}
+
+inline glm::vec3 toVec3(Vec4 a) {
+    return glm::vec3(a);
+}
+
+#endif
+
+inline float angleBetween(Vec4 a, Vec4 b) {
+    float lengths = std::sqrt(dot(a, a) * dot(b, b));
+    if (lengths <= 0.0f)
+        return 0.0f;
+    return std::acos(std::clamp(dot(a, b) / lengths, -1.0f, 1.0f));
+}
+
+// Ненормированная нормаль треугольника (длина — удвоенная площадь) и углы при его вершинах
+struct TriangleFrame {
+    Vec4 normal;
+    float angles[3];
+};
+
+inline TriangleFrame triangleFrame(const GLfloat* positions, size_t stride, const GLuint* corners, bool needAngles) {
+    Vec4 p0 = loadPosition(positions + corners[0] * stride);
+    Vec4 p1 = loadPosition(positions + corners[1] * stride);
+    Vec4 p2 = loadPosition(positions + corners[2] * stride);
+    Vec4 e01 = sub(p1, p0);
+    Vec4 e02 = sub(p2, p0);
+
+    TriangleFrame frame;
+    frame.normal = cross(e01, e02);
+    if (needAngles) {
+        Vec4 e12 = sub(p2, p1);
+        frame.angles[0] = angleBetween(e01, e02);
+        frame.angles[1] = angleBetween(sub(p0, p1), e12);
+        frame.angles[2] = std::max(0.0f, 3.14159265f - frame.angles[0] - frame.angles[1]);
+    }
+    return frame;
+}
+
+// Вклады вершин треугольника с учётом выбранного веса
+inline void cornerContributions(const TriangleFrame& frame, NormalWeighting weighting, Vec4 contributions[3]) {
+    if (weighting == NormalWeighting::Area) {
+        contributions[0] = contributions[1] = contributions[2] = frame.normal;
+        return;
+    }
+    float length = std::sqrt(dot(frame.normal, frame.normal));
+    Vec4 unit = length > 0.0f ? mulScalar(frame.normal, 1.0f / length) : frame.normal;
+    for (int k = 0; k < 3; ++k)
+        contributions[k] = mulScalar(unit, frame.angles[k]);
+}
+
+inline glm::vec3 normalizeOrUp(const glm::vec3& v) {
+    float length = glm::length(v);
+    return length > 0.0f ? v / length : glm::vec3(0.0f, 1.0f, 0.0f);
+}
+
+} // namespace
+
+void computeFaceNormals(const GLfloat* positions, size_t stride, const std::vector<GLuint>& indices, std::vector<glm::vec3>& faceNormals) {
+    size_t triangleCount = indices.size() / 3;
+    faceNormals.resize(triangleCount);
+    parallelFor(triangleCount, triangleGrain, [&](size_t begin, size_t end) {
+        for (size_t t = begin; t < end; ++t) {
+            TriangleFrame frame = triangleFrame(positions, stride, &indices[t * 3], false);
+            faceNormals[t] = normalizeOrUp(toVec3(frame.normal));
+        }
+    });
+}
+
+void computeVertexNormals(const GLfloat* positions, size_t stride, size_t vertexCount, const std::vector<GLuint>& indices,
+                          NormalWeighting weighting, GLfloat* normals, size_t normalStride) {
+    PROFILE_ZONE("Vertex normals");
+    size_t triangleCount = indices.size() / 3;
+    size_t slots = std::max<size_t>(1, std::min<size_t>(workerCount(), (triangleCount + triangleGrain - 1) / triangleGrain));
+    size_t trianglesPerSlot = (triangleCount + slots - 1) / slots;
+
+    // Свой буфер сумм на каждый кусок треугольников
+    std::vector<std::vector<float>> sums(slots, std::vector<float>(vertexCount * 4, 0.0f));
+    parallelFor(slots, 1, [&](size_t begin, size_t end) {
+        for (size_t slot = begin; slot < end; ++slot) {
+            float* sum = sums[slot].data();
+            size_t last = std::min(triangleCount, (slot + 1) * trianglesPerSlot);
+            for (size_t t = slot * trianglesPerSlot; t < last; ++t) {
+                const GLuint* corners = &indices[t * 3];
+                TriangleFrame frame = triangleFrame(positions, stride, corners, weighting == NormalWeighting::Angle);
+                Vec4 contributions[3];
+                cornerContributions(frame, weighting, contributions);
+                for (int k = 0; k < 3; ++k)
+                    accumulate(sum + corners[k] * 4, contributions[k]);
+            }
+        }
+    });
+
+    parallelFor(vertexCount, 1 << 14, [&](size_t begin, size_t end) {
+        for (size_t v = begin; v < end; ++v) {
+            glm::vec3 total(0.0f);
+            for (size_t slot = 0; slot < slots; ++slot)
+                total += glm::vec3(sums[slot][v * 4], sums[slot][v * 4 + 1], sums[slot][v * 4 + 2]);
+            glm::vec3 normal = normalizeOrUp(total);
+            normals[v * normalStride] = normal.x;
+            normals[v * normalStride + 1] = normal.y;
+            normals[v * normalStride + 2] = normal.z;
+        }
+    });
+}
+
+void computeVertexNormals(MeshData& mesh, NormalWeighting weighting) {
+    computeVertexNormals(mesh.vertices.data(), meshVertexFloats, mesh.vertices.size() / meshVertexFloats, mesh.indices,
+                         weighting, mesh.vertices.data() + 3, meshVertexFloats);
+}
+
+MeshData splitCreases(const MeshData& mesh, float creaseAngle, NormalWeighting weighting) {
+    PROFILE_ZONE("Split creases");
+    const GLfloat* positions = mesh.vertices.data();
+    size_t vertexCount = mesh.vertices.size() / meshVertexFloats;
+    size_t triangleCount = mesh.indices.size() / 3;
+
+    // Единичные нормали и веса граней при каждой вершине
+    std::vector<glm::vec3> faceNormals(triangleCount);
+    std::vector<glm::vec3> cornerWeights(triangleCount);
+    parallelFor(triangleCount, triangleGrain, [&](size_t begin, size_t end) {
+        for (size_t t = begin; t < end; ++t) {
+            TriangleFrame frame = triangleFrame(positions, meshVertexFloats, &mesh.indices[t * 3], weighting == NormalWeighting::Angle);
+            glm::vec3 normal = toVec3(frame.normal);
+            faceNormals[t] = normalizeOrUp(normal);
+            if (weighting == NormalWeighting::Area)
+                cornerWeights[t] = glm::vec3(glm::length(normal));
+            else
+                cornerWeights[t] = glm::vec3(frame.angles[0], frame.angles[1], frame.angles[2]);
+        }
+    });
+
+    // Треугольники при каждой вершине (CSR): номер угла = треугольник * 3 + позиция в нём
+    std::vector<GLuint> cornerOffset(vertexCount + 1, 0);
+    for (GLuint index : mesh.indices)
+        ++cornerOffset[index + 1];
+    for (size_t v = 0; v < vertexCount; ++v)
+        cornerOffset[v + 1] += cornerOffset[v];
+    std::vector<GLuint> incidentCorners(mesh.indices.size());
+    std::vector<GLuint> fill(cornerOffset.begin(), cornerOffset.end() - 1);
+    for (size_t corner = 0; corner < mesh.indices.size(); ++corner)
+        incidentCorners[fill[mesh.indices[corner]]++] = (GLuint)corner;
+
+    // Нормаль угла — сумма граней при вершине, которые не дальше creaseAngle от его грани.
+    // Углы одной вершины с одинаковой нормалью делят одну выходную вершину.
+    float cosCrease = std::cos(glm::radians(std::clamp(creaseAngle, 0.0f, 180.0f))) - 1e-5f;
+    std::vector<glm::vec3> cornerNormals(mesh.indices.size());
+    std::vector<GLuint> cornerSlot(mesh.indices.size());
+    std::vector<GLuint> vertexOffset(vertexCount + 1, 0);
+    parallelFor(vertexCount, 1 << 12, [&](size_t begin, size_t end) {
+        std::vector<glm::vec3> distinct;
+        for (size_t vertex = begin; vertex < end; ++vertex) {
+            distinct.clear();
+            for (GLuint c = cornerOffset[vertex]; c < cornerOffset[vertex + 1]; ++c) {
+                GLuint corner = incidentCorners[c];
+                const glm::vec3& faceNormal = faceNormals[corner / 3];
+                glm::vec3 sum(0.0f);
+                for (GLuint o = cornerOffset[vertex]; o < cornerOffset[vertex + 1]; ++o) {
+                    GLuint other = incidentCorners[o];
+                    const glm::vec3& otherNormal = faceNormals[other / 3];
+                    if (glm::dot(otherNormal, faceNormal) >= cosCrease)
+                        sum += otherNormal * cornerWeights[other / 3][other % 3];
+                }
+                glm::vec3 normal = glm::length(sum) > 0.0f ? glm::normalize(sum) : faceNormal;
+
+                GLuint slot = 0;
+                while (slot < distinct.size() && distinct[slot] != normal)
+                    ++slot;
+                if (slot == distinct.size())
+                    distinct.push_back(normal);
+                cornerNormals[corner] = normal;
+                cornerSlot[corner] = slot;
+            }
+            vertexOffset[vertex + 1] = (GLuint)distinct.size();
+        }
+    });
+    for (size_t v = 0; v < vertexCount; ++v)
+        vertexOffset[v + 1] += vertexOffset[v];
+
+    MeshData result;
+    result.vertices.resize(vertexOffset[vertexCount] * meshVertexFloats);
+    result.indices.resize(mesh.indices.size());
+    parallelFor(vertexCount, 1 << 12, [&](size_t begin, size_t end) {
+        for (size_t vertex = begin; vertex < end; ++vertex) {
+            for (GLuint c = cornerOffset[vertex]; c < cornerOffset[vertex + 1]; ++c) {
+                GLuint corner = incidentCorners[c];
+                GLuint output = vertexOffset[vertex] + cornerSlot[corner];
+                result.indices[corner] = output;
+
+                GLfloat* out = &result.vertices[output * meshVertexFloats];
+                std::copy(positions + vertex * meshVertexFloats, positions + vertex * meshVertexFloats + 3, out);
+                out[3] = cornerNormals[corner].x;
+                out[4] = cornerNormals[corner].y;
+                out[5] = cornerNormals[corner].z;
+            }
+        }
+    });
+
+    result.boundsMin = mesh.boundsMin;
+    result.boundsMax = mesh.boundsMax;
+    return result;
+}
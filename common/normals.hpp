@@ -0,0 +1,27 @@
+#pragma once
+
+#include "mesh_loader.hpp"
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include <vector>
+
+enum class NormalWeighting {
+    Area,  // вклад грани пропорционален её площади
+    Angle  // вклад грани пропорционален углу при вершине, не зависит от разбиения на треугольники
+};
+
+// Единичные нормали треугольников. Позиция вершины — первые три float из каждых stride.
+void computeFaceNormals(const GLfloat* positions, size_t stride, const std::vector<GLuint>& indices, std::vector<glm::vec3>& faceNormals);
+
+// Нормали вершин как взвешенная сумма нормалей граней. Треугольники делятся между потоками,
+// каждый поток копит суммы в своём буфере, затем буферы складываются по вершинам — без атомарных операций.
+void computeVertexNormals(const GLfloat* positions, size_t stride, size_t vertexCount, const std::vector<GLuint>& indices,
+                          NormalWeighting weighting, GLfloat* normals, size_t normalStride);
+
+// То же для меша с чередующимися атрибутами: нормали пишутся на место второго атрибута
+void computeVertexNormals(MeshData& mesh, NormalWeighting weighting = NormalWeighting::Area);
+
+// Пересчитывает нормали, разделяя вершины на рёбрах, где грани расходятся больше чем на
+// creaseAngle градусов: 0 даёт плоские грани, 180 — полностью гладкий меш.
+MeshData splitCreases(const MeshData& mesh, float creaseAngle, NormalWeighting weighting = NormalWeighting::Area);
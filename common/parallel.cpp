@@ -0,0 +1,110 @@
+#include "parallel.hpp"
+#include "job_system.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// Куски разбирают и вызывающий поток, и задачи пула. Вызывающий не ждёт задач, стоящих
+// в очереди, — он сам доделает все куски, поэтому вложенный parallelFor из задачи пула
+// не может заблокироваться. Ждать приходится только куски, уже взятые другими потоками.
+struct ParallelBatch {
+    const FunctionRef<void(size_t begin, size_t end)>* fn;
+    size_t count;
+    size_t chunkSize;
+    size_t chunks;
+    std::atomic<size_t> nextChunk{0};
+    std::atomic<size_t> finishedChunks{0};
+    std::mutex mutex;
+    std::condition_variable finished;
+    std::atomic<size_t> references{0}; // вызывающий и задачи в очереди
+
+    void runChunks() {
+        for (;;) {
+            size_t chunk = nextChunk.fetch_add(1);
+            if (chunk >= chunks)
+                return;
+            size_t begin = chunk * chunkSize;
+            (*fn)(begin, std::min(count, begin + chunkSize));
+            if (finishedChunks.fetch_add(1) + 1 == chunks) {
+                std::lock_guard<std::mutex> lock(mutex);
+                finished.notify_all();
+            }
+        }
+    }
+};
+
+// Задача из очереди может проснуться уже после возврата parallelFor, поэтому пакет
+// возвращается в пул только последней ссылкой. Пул растёт до глубины вложенности вызовов.
+std::mutex poolMutex;
+std::vector<ParallelBatch*> freeBatches;
+
+ParallelBatch* acquireBatch(size_t references) {
+    ParallelBatch* batch = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(poolMutex);
+        if (!freeBatches.empty()) {
+            batch = freeBatches.back();
+            freeBatches.pop_back();
+        }
+    }
+    if (!batch)
+        batch = new ParallelBatch();
+    batch->nextChunk = 0;
+    batch->finishedChunks = 0;
+    batch->references = references;
+    return batch;
+}
+
+void releaseBatch(ParallelBatch* batch) {
+    if (batch->references.fetch_sub(1) != 1)
+        return;
+    std::lock_guard<std::mutex> lock(poolMutex);
+    freeBatches.push_back(batch);
+}
+
+} // namespace
+
+unsigned workerCount() {
+    return std::max(1u, std::thread::hardware_concurrency());
+}
+
+void parallelFor(size_t count, size_t grain, FunctionRef<void(size_t begin, size_t end)> fn) {
+    if (count == 0)
+        return;
+
+    size_t chunks = std::min<size_t>(workerCount(), (count + std::max<size_t>(grain, 1) - 1) / std::max<size_t>(grain, 1));
+    if (chunks <= 1) {
+        fn(0, count);
+        return;
+    }
+
+    size_t chunkSize = (count + chunks - 1) / chunks;
+    chunks = (count + chunkSize - 1) / chunkSize;
+    ParallelBatch* batch = acquireBatch(chunks);
+    batch->fn = &fn;
+    batch->count = count;
+    batch->chunkSize = chunkSize;
+    batch->chunks = chunks;
+
+    // Задача, запущенная после завершения пакета, не найдёт свободных кусков и не тронет fn.
+    // Лямбда с одним указателем помещается в std::function без выделения памяти.
+    for (size_t i = 1; i < chunks; ++i) {
+        enqueueJob([batch]() {
+            batch->runChunks();
+            releaseBatch(batch);
+        });
+    }
+    batch->runChunks();
+
+    {
+        std::unique_lock<std::mutex> lock(batch->mutex);
+        batch->finished.wait(lock, [&]() { return batch->finishedChunks.load() == batch->chunks; });
+    }
+    releaseBatch(batch);
+}
@@ -0,0 +1,14 @@
+#pragma once
+
+#include "function_ref.hpp"
+
+#include <cstddef>
+
+// Число рабочих потоков (не меньше одного)
+unsigned workerCount();
+
+// Делит [0, count) на куски не меньше grain и обрабатывает их вызывающим потоком и пулом
+// задач (job_system.hpp). fn(begin, end) вызывается из разных потоков; возврат — после
+// завершения всех кусков. Можно вызывать и из задачи пула. Сам вызов кучу не трогает:
+// fn не копируется, а пакеты работы переиспользуются.
+void parallelFor(size_t count, size_t grain, FunctionRef<void(size_t begin, size_t end)> fn);
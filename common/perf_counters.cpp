@@ -0,0 +1,130 @@
+#include "perf_counters.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <string>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace {
+
+const char* counterNames[perfCounterCount] = {
+    "frame time us", "frames", "draw calls", "triangles", "uploaded bytes", "shader switches", "culled objects",
+    "heap allocations", "shaded samples",
+};
+
+const int readAttempts = 64;
+
+std::atomic<uint64_t> frameValues[perfCounterCount];
+PerfCounterBlock* block = nullptr;
+std::string segmentName;
+
+std::string segmentNameFor(int pid) {
+    return "/cglabs-perf-" + std::to_string(pid);
+}
+
+} // namespace
+
+void initPerfCounters() {
+    segmentName = segmentNameFor(getpid());
+    int fd = shm_open(segmentName.c_str(), O_CREAT | O_RDWR | O_TRUNC, 0644);
+    if (fd < 0) {
+        std::cerr << "Failed to create performance counter segment " << segmentName << std::endl;
+        return;
+    }
+    void* memory = MAP_FAILED;
+    if (ftruncate(fd, sizeof(PerfCounterBlock)) == 0)
+        memory = mmap(nullptr, sizeof(PerfCounterBlock), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (memory == MAP_FAILED) {
+        std::cerr << "Failed to map performance counter segment " << segmentName << std::endl;
+        shm_unlink(segmentName.c_str());
+        return;
+    }
+
+    // Свежий сегмент заполнен нулями, атомарные поля уже в начальном состоянии
+    block = static_cast<PerfCounterBlock*>(memory);
+    block->version = perfCounterVersion;
+    block->pid = getpid();
+    block->counterCount = perfCounterCount;
+    for (int i = 0; i < perfCounterCount; ++i)
+        std::snprintf(block->names[i], sizeof(block->names[i]), "%s", counterNames[i]);
+    // magic последним: читатель не примет сегмент, пока заголовок не заполнен
+    std::atomic_thread_fence(std::memory_order_release);
+    block->magic = perfCounterMagic;
+    std::cout << "Performance counters: " << segmentName << std::endl;
+}
+
+void destroyPerfCounters() {
+    if (!block)
+        return;
+    munmap(block, sizeof(PerfCounterBlock));
+    shm_unlink(segmentName.c_str());
+    block = nullptr;
+}
+
+void addPerfCounter(PerfCounter counter, uint64_t value) {
+    frameValues[(int)counter].fetch_add(value, std::memory_order_relaxed);
+}
+
+void publishPerfFrame(double frameMs) {
+    addPerfCounter(PerfCounter::FrameTime, (uint64_t)(frameMs * 1000.0));
+    addPerfCounter(PerfCounter::Frames, 1);
+
+    uint64_t values[perfCounterCount];
+    for (int i = 0; i < perfCounterCount; ++i)
+        values[i] = frameValues[i].exchange(0, std::memory_order_relaxed);
+    if (!block)
+        return;
+
+    uint64_t sequence = block->sequence.load(std::memory_order_relaxed);
+    block->sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    for (int i = 0; i < perfCounterCount; ++i) {
+        block->lastFrame[i].store(values[i], std::memory_order_relaxed);
+        block->totals[i].store(block->totals[i].load(std::memory_order_relaxed) + values[i], std::memory_order_relaxed);
+    }
+    block->sequence.store(sequence + 2, std::memory_order_release);
+}
+
+const PerfCounterBlock* attachPerfCounters(int pid) {
+    int fd = shm_open(segmentNameFor(pid).c_str(), O_RDONLY, 0);
+    if (fd < 0)
+        return nullptr;
+    void* memory = mmap(nullptr, sizeof(PerfCounterBlock), PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (memory == MAP_FAILED)
+        return nullptr;
+
+    const PerfCounterBlock* attached = static_cast<const PerfCounterBlock*>(memory);
+    if (attached->magic != perfCounterMagic || attached->version != perfCounterVersion ||
+        attached->counterCount != (uint32_t)perfCounterCount) {
+        munmap(memory, sizeof(PerfCounterBlock));
+        return nullptr;
+    }
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return attached;
+}
+
+void detachPerfCounters(const PerfCounterBlock* attached) {
+    if (attached)
+        munmap(const_cast<PerfCounterBlock*>(attached), sizeof(PerfCounterBlock));
+}
+
+bool readPerfCounters(const PerfCounterBlock& source, PerfSnapshot& snapshot) {
+    for (int attempt = 0; attempt < readAttempts; ++attempt) {
+        uint64_t before = source.sequence.load(std::memory_order_acquire);
+        if (before & 1)
+            continue;
+        for (int i = 0; i < perfCounterCount; ++i) {
+            snapshot.lastFrame[i] = source.lastFrame[i].load(std::memory_order_relaxed);
+            snapshot.totals[i] = source.totals[i].load(std::memory_order_relaxed);
+        }
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (source.sequence.load(std::memory_order_relaxed) == before)
+            return true;
+    }
+    return false;
+}
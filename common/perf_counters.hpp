@@ -0,0 +1,67 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// Счётчики производительности, видимые снаружи процесса. Значения копятся в памяти процесса
+// и в конце каждого кадра публикуются в разделяемый сегмент POSIX /cglabs-perf-<pid>,
+// откуда их читает tools/perftop, не останавливая и не перезапуская лабораторную.
+enum class PerfCounter {
+    FrameTime,      // мкс работы кадра
+    Frames,
+    DrawCalls,
+    Triangles,
+    UploadedBytes,  // байт, переданных в буферы GPU
+    ShaderSwitches,
+    CulledObjects,
+    HeapAllocations, // вызовов operator new за кадр во всех потоках
+    ShadedSamples,   // сэмплов, прошедших тест глубины в проходе затенения (GL_SAMPLES_PASSED)
+    Count
+};
+
+const int perfCounterCount = (int)PerfCounter::Count;
+const uint32_t perfCounterMagic = 0x46524550; // "PERF"
+const uint32_t perfCounterVersion = 3;
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "counters are shared between processes");
+
+// Раскладка сегмента. Один писатель — поток кадра — обновляет значения под счётчиком
+// последовательности: нечётное значение значит, что запись идёт, и читатель повторяет чтение.
+struct PerfCounterBlock {
+    uint32_t magic;
+    uint32_t version;
+    int32_t pid;
+    uint32_t counterCount;
+    char names[perfCounterCount][24];
+    std::atomic<uint64_t> sequence;
+    std::atomic<uint64_t> lastFrame[perfCounterCount]; // значения последнего кадра
+    std::atomic<uint64_t> totals[perfCounterCount];    // суммы с запуска
+};
+
+struct PerfSnapshot {
+    uint64_t lastFrame[perfCounterCount];
+    uint64_t totals[perfCounterCount];
+};
+
+// Создаёт сегмент. Если не вышло, счётчики работают как обычно, просто их никто не видит.
+void initPerfCounters();
+void destroyPerfCounters();
+
+// Из любого потока, без блокировок
+void addPerfCounter(PerfCounter counter, uint64_t value);
+
+inline void countDraw(size_t indexCount) {
+    addPerfCounter(PerfCounter::DrawCalls, 1);
+    addPerfCounter(PerfCounter::Triangles, indexCount / 3);
+}
+
+// Конец кадра: значения кадра уходят в сегмент и обнуляются
+void publishPerfFrame(double frameMs);
+
+// Чтение из другого процесса: сегмент лабораторной с данным pid или nullptr
+const PerfCounterBlock* attachPerfCounters(int pid);
+void detachPerfCounters(const PerfCounterBlock* block);
+
+// Согласованный снимок; false, если писатель так и не дал прочитать без гонки
+bool readPerfCounters(const PerfCounterBlock& block, PerfSnapshot& snapshot);
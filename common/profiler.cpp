@@ -0,0 +1,146 @@
+#include "profiler.hpp"
+
+#ifdef ENABLE_PROFILER
+
+#include "args.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace profiler {
+namespace {
+
+struct Event {
+    const char* name;
+    int64_t start;
+    int64_t duration;
+    int track;
+};
+
+const size_t chunkEvents = 4096;
+
+// Буфер событий потока — цепочка кусков фиксированного размера, которую пишет только
+// поток-владелец. Число событий в куске публикуется с release: запись трассы читает
+// буферы, не останавливая потоки, и видит только целиком записанные события.
+struct EventChunk {
+    Event events[chunkEvents];
+    std::atomic<size_t> count{0};
+    std::atomic<EventChunk*> next{nullptr};
+};
+
+struct ThreadBuffer {
+    int track = 0;
+    EventChunk* first = nullptr;
+    EventChunk* last = nullptr;
+};
+
+struct Profiler {
+    std::mutex mutex; // только регистрация потоков и дорожек и запись трассы
+    std::vector<ThreadBuffer*> buffers;
+    std::vector<std::string> trackNames;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    std::string tracePath = "trace.json";
+};
+
+// Не разрушается при выходе: рабочие потоки пула могут закрывать зоны до самого конца
+Profiler& state() {
+    static Profiler* profiler = new Profiler();
+    return *profiler;
+}
+
+ThreadBuffer& threadBuffer() {
+    thread_local ThreadBuffer* buffer = nullptr;
+    if (!buffer) {
+        Profiler& profiler = state();
+        std::lock_guard<std::mutex> lock(profiler.mutex);
+        buffer = new ThreadBuffer();
+        buffer->track = (int)profiler.trackNames.size();
+        buffer->first = buffer->last = new EventChunk();
+        profiler.trackNames.push_back("Thread " + std::to_string(buffer->track));
+        profiler.buffers.push_back(buffer);
+    }
+    return *buffer;
+}
+
+} // namespace
+
+int64_t now() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - state().start).count();
+}
+
+void recordEvent(const char* name, int64_t start, int64_t duration, int track) {
+    ThreadBuffer& buffer = threadBuffer();
+    EventChunk* chunk = buffer.last;
+    size_t count = chunk->count.load(std::memory_order_relaxed);
+    if (count == chunkEvents) {
+        EventChunk* next = new EventChunk();
+        chunk->next.store(next, std::memory_order_release);
+        buffer.last = chunk = next;
+        count = 0;
+    }
+    chunk->events[count] = { name, start, duration, track < 0 ? buffer.track : track };
+    chunk->count.store(count + 1, std::memory_order_release);
+}
+
+int createTrack(const char* name) {
+    Profiler& profiler = state();
+    std::lock_guard<std::mutex> lock(profiler.mutex);
+    profiler.trackNames.push_back(name);
+    return (int)profiler.trackNames.size() - 1;
+}
+
+void setThreadName(const char* name) {
+    ThreadBuffer& buffer = threadBuffer();
+    Profiler& profiler = state();
+    std::lock_guard<std::mutex> lock(profiler.mutex);
+    profiler.trackNames[buffer.track] = name;
+}
+
+void init(int argc, char** argv) {
+    state().tracePath = getArg(argc, argv, "--trace", "trace.json");
+    setThreadName("Main");
+}
+
+void shutdown() {
+    Profiler& profiler = state();
+    std::lock_guard<std::mutex> lock(profiler.mutex);
+
+    FILE* file = std::fopen(profiler.tracePath.c_str(), "w");
+    if (!file) {
+        std::cerr << "Failed to write profiler trace " << profiler.tracePath << std::endl;
+        return;
+    }
+
+    // Формат Trace Event: "X" — событие с длительностью, "M" — имя дорожки; время в микросекундах
+    std::fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    for (size_t track = 0; track < profiler.trackNames.size(); ++track) {
+        std::fprintf(file, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%zu,\"args\":{\"name\":\"%s\"}},\n",
+                     track, profiler.trackNames[track].c_str());
+    }
+    size_t eventCount = 0;
+    for (ThreadBuffer* buffer : profiler.buffers) {
+        for (EventChunk* chunk = buffer->first; chunk; chunk = chunk->next.load(std::memory_order_acquire)) {
+            size_t count = chunk->count.load(std::memory_order_acquire);
+            for (size_t i = 0; i < count; ++i) {
+                const Event& event = chunk->events[i];
+                std::fprintf(file, "{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f},\n",
+                             event.name, event.track, event.start / 1000.0, event.duration / 1000.0);
+            }
+            eventCount += count;
+        }
+    }
+    // Пустой объект в конце, чтобы после последнего события можно было оставить запятую
+    std::fprintf(file, "{}\n]}\n");
+    std::fclose(file);
+    std::cout << "Profiler trace: " << eventCount << " events written to " << profiler.tracePath << std::endl;
+}
+
+} // namespace profiler
+
+#endif
@@ -0,0 +1,72 @@
+#pragma once
+
+// Профилировщик кадра с выгрузкой в формат Chrome Trace Event (открывается в
+// chrome://tracing и ui.perfetto.dev). Включается сборкой с -DENABLE_PROFILER
+// (make PROFILE=1); без него все макросы раскрываются в пустоту и зоны ничего не стоят.
+//
+//   PROFILE_INIT(argc, argv)   — начало отсчёта; трасса пишется в --trace путь (trace.json)
+//   PROFILE_ZONE("name")       — зона процессора до конца области видимости
+//   PROFILE_GPU_ZONE("name")   — зона GPU по меткам GL_TIMESTAMP, только в потоке контекста
+//   PROFILE_FRAME()            — конец кадра: забирает готовые результаты GPU-запросов
+//   PROFILE_THREAD("name")     — имя текущего потока в трассе
+//   PROFILE_SHUTDOWN()         — запись трассы
+//
+// Имена зон — строковые литералы: хранятся указатели. У каждого потока свой буфер событий,
+// который пишет только он сам, поэтому запись зоны не берёт блокировок.
+
+#ifdef ENABLE_PROFILER
+
+#include <cstdint>
+
+namespace profiler {
+
+int64_t now();
+
+// Событие на дорожке track; track < 0 — дорожка текущего потока
+void recordEvent(const char* name, int64_t start, int64_t duration, int track = -1);
+
+// Отдельная дорожка трассы, не связанная с потоком (например, время GPU)
+int createTrack(const char* name);
+
+void setThreadName(const char* name);
+void init(int argc, char** argv);
+void shutdown();
+
+// Реализованы в gpu_profiler.cpp: лаборатории без OpenGL его не подключают
+void beginGpuZone(const char* name);
+void endGpuZone();
+void collectGpuZones();
+
+struct Zone {
+    const char* name;
+    int64_t start;
+    explicit Zone(const char* name) : name(name), start(now()) {}
+    ~Zone() { recordEvent(name, start, now() - start); }
+};
+
+struct GpuZone {
+    explicit GpuZone(const char* name) { beginGpuZone(name); }
+    ~GpuZone() { endGpuZone(); }
+};
+
+} // namespace profiler
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+#define PROFILE_ZONE(name) profiler::Zone PROFILE_CONCAT(profileZone, __LINE__)(name)
+#define PROFILE_GPU_ZONE(name) profiler::GpuZone PROFILE_CONCAT(profileGpuZone, __LINE__)(name)
+#define PROFILE_FRAME() profiler::collectGpuZones()
+#define PROFILE_THREAD(name) profiler::setThreadName(name)
+#define PROFILE_INIT(argc, argv) profiler::init(argc, argv)
+#define PROFILE_SHUTDOWN() profiler::shutdown()
+
+#else
+
+#define PROFILE_ZONE(name) ((void)0)
+#define PROFILE_GPU_ZONE(name) ((void)0)
+#define PROFILE_FRAME() ((void)0)
+#define PROFILE_THREAD(name) ((void)0)
+#define PROFILE_INIT(argc, argv) ((void)(argc), (void)(argv))
+#define PROFILE_SHUTDOWN() ((void)0)
+
+#endif
@@ -0,0 +1,184 @@
+#include "provoking_vertex.hpp"
+#include "normals.hpp"
+
+namespace {
+
+const float normalTolerance = 0.9999f; // косинус угла, при котором нормали считаются равными
+const int maxReassignDepth = 3;        // глубина поиска чередующихся цепочек переназначений
+
+// Назначение треугольникам провоцирующих вершин как паросочетание: вершина может
+// обслуживать сколько угодно треугольников, но только с одной нормалью
+struct ProvokingAssignment {
+    const std::vector<GLuint>& indices;
+    const std::vector<glm::vec3>& faceNormals;
+
+    std::vector<GLuint> provoking;             // вершина треугольника или noVertex
+    std::vector<std::vector<GLuint>> users;    // треугольники, назначенные вершине
+    std::vector<bool> visited;
+    std::vector<GLuint> visitedList;
+
+    struct Change { GLuint triangle, from, to; };
+    std::vector<Change> log;
+
+    static const GLuint noVertex = ~0u;
+
+    ProvokingAssignment(const std::vector<GLuint>& indices, const std::vector<glm::vec3>& faceNormals, size_t vertexCount)
+        : indices(indices), faceNormals(faceNormals),
+          provoking(faceNormals.size(), noVertex), users(vertexCount), visited(vertexCount, false) {}
+
+    bool accepts(GLuint vertex, GLuint triangle) const {
+        return users[vertex].empty() || glm::dot(faceNormals[users[vertex][0]], faceNormals[triangle]) >= normalTolerance;
+    }
+
+    void move(GLuint triangle, GLuint to, bool record = true) {
+        GLuint from = provoking[triangle];
+        if (from != noVertex) {
+            std::vector<GLuint>& list = users[from];
+            for (size_t i = 0; i < list.size(); ++i) {
+                if (list[i] == triangle) {
+                    list.erase(list.begin() + i);
+                    break;
+                }
+            }
+        }
+        if (to != noVertex)
+            users[to].push_back(triangle);
+        provoking[triangle] = to;
+        if (record)
+            log.push_back({ triangle, from, to });
+    }
+
+    void rollback(size_t mark) {
+        while (log.size() > mark) {
+            Change change = log.back();
+            log.pop_back();
+            move(change.triangle, change.from, false);
+        }
+    }
+
+    // Число ещё не назначенных треугольников при вершине с той же нормалью минус с другой:
+    // свободную вершину лучше отдать той грани, которой она нужнее
+    int score(GLuint vertex, GLuint triangle, const std::vector<std::vector<GLuint>>& incident) const {
+        int result = 0;
+        for (GLuint other : incident[vertex]) {
+            if (other == triangle || provoking[other] != noVertex)
+                continue;
+            result += glm::dot(faceNormals[other], faceNormals[triangle]) >= normalTolerance ? 4 : -1;
+        }
+        return result;
+    }
+
+    bool place(GLuint triangle, int depth, const std::vector<std::vector<GLuint>>& incident) {
+        const GLuint* corners = &indices[triangle * 3];
+
+        int best = -1;
+        int bestScore = 0;
+        for (int corner = 0; corner < 3; ++corner) {
+            GLuint vertex = corners[corner];
+            if (!accepts(vertex, triangle))
+                continue;
+            if (!users[vertex].empty()) {
+                best = corner;
+                break;
+            }
+            int vertexScore = score(vertex, triangle, incident);
+            if (best < 0 || vertexScore > bestScore) {
+                best = corner;
+                bestScore = vertexScore;
+            }
+        }
+        if (best >= 0) {
+            move(triangle, corners[best]);
+            return true;
+        }
+        if (depth == 0)
+            return false;
+
+        // Все углы заняты другими нормалями: пробуем переселить их треугольники
+        for (int corner = 0; corner < 3; ++corner) {
+            GLuint vertex = corners[corner];
+            if (visited[vertex])
+                continue;
+            visited[vertex] = true;
+            visitedList.push_back(vertex);
+
+            size_t mark = log.size();
+            std::vector<GLuint> evicted = users[vertex];
+            for (GLuint other : evicted)
+                move(other, noVertex);
+            move(triangle, vertex);
+
+            bool success = true;
+            for (GLuint other : evicted) {
+                if (!place(other, depth - 1, incident)) {
+                    success = false;
+                    break;
+                }
+            }
+            if (success)
+                return true;
+            rollback(mark);
+        }
+        return false;
+    }
+};
+
+} // namespace
+
+ProvokingVertexMesh buildProvokingVertexMesh(const std::vector<glm::vec3>& positions, const std::vector<GLuint>& indices) {
+    size_t triangleCount = indices.size() / 3;
+    size_t vertexCount = positions.size();
+
+    std::vector<glm::vec3> faceNormals;
+    computeFaceNormals(&positions[0].x, 3, indices, faceNormals);
+
+    std::vector<std::vector<GLuint>> incident(vertexCount);
+    for (size_t t = 0; t < triangleCount; ++t) {
+        for (int corner = 0; corner < 3; ++corner)
+            incident[indices[t * 3 + corner]].push_back((GLuint)t);
+    }
+
+    ProvokingAssignment assignment(indices, faceNormals, vertexCount);
+    std::vector<GLuint> unplaced;
+    for (size_t t = 0; t < triangleCount; ++t) {
+        if (!assignment.place((GLuint)t, maxReassignDepth, incident))
+            unplaced.push_back((GLuint)t);
+        assignment.log.clear();
+        for (GLuint vertex : assignment.visitedList)
+            assignment.visited[vertex] = false;
+        assignment.visitedList.clear();
+    }
+
+    ProvokingVertexMesh mesh;
+    mesh.positions = positions;
+    mesh.normals.assign(vertexCount, glm::vec3(0.0f));
+    mesh.indices.resize(indices.size());
+    for (size_t v = 0; v < vertexCount; ++v) {
+        if (!assignment.users[v].empty())
+            mesh.normals[v] = faceNormals[assignment.users[v][0]];
+    }
+
+    // Треугольникам без свободного угла достаётся копия последней вершины со своей нормалью
+    for (GLuint t : unplaced) {
+        GLuint copy = (GLuint)mesh.positions.size();
+        mesh.positions.push_back(positions[indices[t * 3 + 2]]);
+        mesh.normals.push_back(faceNormals[t]);
+        assignment.provoking[t] = copy;
+    }
+
+    // Циклический сдвиг ставит провоцирующий угол последним, не меняя обход
+    for (size_t t = 0; t < triangleCount; ++t) {
+        const GLuint* corners = &indices[t * 3];
+        GLuint provoking = assignment.provoking[t];
+        int chosen = 2;
+        for (int corner = 0; corner < 3; ++corner) {
+            if (corners[corner] == provoking)
+                chosen = corner;
+        }
+        for (int corner = 0; corner < 3; ++corner)
+            mesh.indices[t * 3 + corner] = corners[(chosen + 1 + corner) % 3];
+        mesh.indices[t * 3 + 2] = provoking;
+    }
+
+    return mesh;
+}
@@ -0,0 +1,19 @@
+#pragma once
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include <vector>
+
+// Меш для плоского затенения через flat-интерполяцию: нормаль грани хранится
+// в провоцирующей вершине треугольника (последней, GL_LAST_VERTEX_CONVENTION).
+struct ProvokingVertexMesh {
+    std::vector<glm::vec3> positions;
+    std::vector<glm::vec3> normals;
+    std::vector<GLuint> indices;
+};
+
+// Переставляет вершины каждого треугольника по кругу (обход сохраняется) так, чтобы
+// провоцирующей оказалась вершина, которой можно отдать нормаль грани. Одна вершина
+// обслуживает все треугольники с той же нормалью; копия вершины добавляется, только
+// если все три угла уже заняты другими нормалями.
+ProvokingVertexMesh buildProvokingVertexMesh(const std::vector<glm::vec3>& positions, const std::vector<GLuint>& indices);
@@ -0,0 +1,190 @@
+#include "render_queue.hpp"
+#include "gpu_memory.hpp"
+#include "perf_counters.hpp"
+#include "profiler.hpp"
+
+#include <algorithm>
+#include <numeric>
+
+namespace {
+
+const int keyBytes = 8;
+
+} // namespace
+
+uint64_t makeSortKey(uint32_t layer, GLuint program, GLuint vao, uint32_t material, float depth) {
+    uint64_t depthBits = (uint64_t)(std::clamp(depth, 0.0f, 1.0f) * (float)0xffffff);
+    return ((uint64_t)(layer & 0xf) << 60) | ((uint64_t)(program & 0xfff) << 48) |
+           ((uint64_t)(vao & 0xfff) << 36) | ((uint64_t)(material & 0xfff) << 24) | depthBits;
+}
+
+void sortRenderQueue(RenderQueue& queue) {
+    PROFILE_ZONE("Sort render queue");
+    size_t count = queue.items.size();
+    queue.order.resize(count);
+    queue.scratch.resize(count);
+    std::iota(queue.order.begin(), queue.order.end(), 0u);
+
+    // Гистограммы всех байтов за один проход по ключам
+    size_t histogram[keyBytes][256] = {};
+    for (const DrawItem& item : queue.items) {
+        for (int b = 0; b < keyBytes; ++b)
+            ++histogram[b][(item.key >> (b * 8)) & 0xff];
+    }
+
+    for (int b = 0; b < keyBytes; ++b) {
+        size_t* counts = histogram[b];
+        if (std::any_of(counts, counts + 256, [count](size_t c) { return c == count; }))
+            continue;
+
+        size_t offset = 0;
+        for (int digit = 0; digit < 256; ++digit) {
+            size_t c = counts[digit];
+            counts[digit] = offset;
+            offset += c;
+        }
+        for (uint32_t index : queue.order)
+            queue.scratch[counts[(queue.items[index].key >> (b * 8)) & 0xff]++] = index;
+        queue.order.swap(queue.scratch);
+    }
+}
+
+RenderStats submitRenderQueue(RenderQueue& queue, const std::function<void(GLuint program)>& bindProgram) {
+    PROFILE_ZONE("Submit render queue");
+    PROFILE_GPU_ZONE("Draw render queue");
+    sortRenderQueue(queue);
+
+    RenderStats stats;
+    GLuint program = 0;
+    GLuint vao = 0;
+    uint32_t material = 0;
+    bool materialBound = false;
+    GLint modelLocation = -1;
+    GLint albedoLocation = -1;
+
+    for (uint32_t index : queue.order) {
+        const DrawItem& item = queue.items[index];
+        if (item.program != program) {
+            program = item.program;
+            glUseProgram(program);
+            bindProgram(program);
+            modelLocation = glGetUniformLocation(program, "model");
+            albedoLocation = glGetUniformLocation(program, "albedo");
+            materialBound = false; // uniform-переменные у каждой программы свои
+            ++stats.programChanges;
+        }
+        if (item.vao != vao) {
+            vao = item.vao;
+            glBindVertexArray(vao);
+            ++stats.vaoChanges;
+        }
+        if (!materialBound || item.material != material) {
+            material = item.material;
+            materialBound = true;
+            glUniform3fv(albedoLocation, 1, &item.albedo[0]);
+            ++stats.materialChanges;
+        }
+        glUniformMatrix4fv(modelLocation, 1, GL_FALSE, &item.model[0][0]);
+        glDrawElementsBaseVertex(GL_TRIANGLES, item.indexCount, GL_UNSIGNED_INT,
+                                 (void*)(item.firstIndex * sizeof(GLuint)), item.baseVertex);
+        countDraw(item.indexCount);
+        ++stats.draws;
+    }
+
+    glBindVertexArray(0);
+    queue.items.clear();
+    addPerfCounter(PerfCounter::ShaderSwitches, stats.programChanges);
+    return stats;
+}
+
+bool multiDrawIndirectSupported() {
+    return GLEW_ARB_multi_draw_indirect && GLEW_ARB_shader_storage_buffer_object && GLEW_ARB_shader_draw_parameters;
+}
+
+void initIndirectDrawBuffers(IndirectDrawBuffers& buffers) {
+    genTrackedBuffers(1, &buffers.commandBuffer, GpuMemoryCategory::Geometry);
+    genTrackedBuffers(1, &buffers.drawDataBuffer, GpuMemoryCategory::Geometry);
+}
+
+void destroyIndirectDrawBuffers(IndirectDrawBuffers& buffers) {
+    deleteTrackedBuffers(1, &buffers.commandBuffer);
+    deleteTrackedBuffers(1, &buffers.drawDataBuffer);
+    buffers.commandBuffer = buffers.drawDataBuffer = 0;
+    buffers.capacity = 0;
+}
+
+RenderStats submitRenderQueueIndirect(RenderQueue& queue, IndirectDrawBuffers& buffers,
+                                      const std::function<void(GLuint program)>& bindProgram) {
+    PROFILE_ZONE("Submit render queue");
+    PROFILE_GPU_ZONE("Draw render queue");
+    sortRenderQueue(queue);
+
+    size_t count = queue.order.size();
+    buffers.commands.resize(count);
+    buffers.drawData.resize(count);
+    for (size_t i = 0; i < count; ++i) {
+        const DrawItem& item = queue.items[queue.order[i]];
+        buffers.commands[i] = { (GLuint)item.indexCount, 1, item.firstIndex, item.baseVertex, 0 };
+        buffers.drawData[i] = { item.model, glm::vec4(item.albedo, 1.0f) };
+        countDraw(item.indexCount);
+    }
+
+    RenderStats stats;
+    stats.draws = (int)count;
+    if (count == 0) {
+        queue.items.clear();
+        return stats;
+    }
+
+    if (count > buffers.capacity)
+        buffers.capacity = std::max(count, buffers.capacity * 2);
+    size_t commandBytes = buffers.capacity * sizeof(DrawElementsIndirectCommand);
+    size_t drawDataBytes = buffers.capacity * sizeof(DrawData);
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, buffers.commandBuffer);
+    trackedBufferData(GL_DRAW_INDIRECT_BUFFER, buffers.commandBuffer, commandBytes, nullptr, GL_STREAM_DRAW);
+    glBufferSubData(GL_DRAW_INDIRECT_BUFFER, 0, count * sizeof(DrawElementsIndirectCommand), buffers.commands.data());
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, buffers.drawDataBuffer);
+    trackedBufferData(GL_SHADER_STORAGE_BUFFER, buffers.drawDataBuffer, drawDataBytes, nullptr, GL_STREAM_DRAW);
+    glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, count * sizeof(DrawData), buffers.drawData.data());
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, drawDataBinding, buffers.drawDataBuffer);
+    addPerfCounter(PerfCounter::UploadedBytes, count * (sizeof(DrawElementsIndirectCommand) + sizeof(DrawData)));
+
+    GLuint program = 0;
+    GLuint vao = 0;
+    GLint drawBaseLocation = -1;
+    size_t begin = 0;
+    while (begin < count) {
+        const DrawItem& first = queue.items[queue.order[begin]];
+        size_t end = begin + 1;
+        while (end < count) {
+            const DrawItem& item = queue.items[queue.order[end]];
+            if (item.program != first.program || item.vao != first.vao)
+                break;
+            ++end;
+        }
+
+        if (first.program != program) {
+            program = first.program;
+            glUseProgram(program);
+            bindProgram(program);
+            drawBaseLocation = glGetUniformLocation(program, "drawBase");
+            ++stats.programChanges;
+        }
+        if (first.vao != vao) {
+            vao = first.vao;
+            glBindVertexArray(vao);
+            ++stats.vaoChanges;
+        }
+        glUniform1i(drawBaseLocation, (GLint)begin);
+        glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT,
+                                    (void*)(begin * sizeof(DrawElementsIndirectCommand)), (GLsizei)(end - begin), 0);
+        ++stats.multiDraws;
+        begin = end;
+    }
+
+    glBindVertexArray(0);
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+    queue.items.clear();
+    addPerfCounter(PerfCounter::ShaderSwitches, stats.programChanges);
+    return stats;
+}
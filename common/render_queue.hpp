@@ -0,0 +1,83 @@
+#pragma once
+
+#include "mesh_buffer.hpp"
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+// Один вызов glDrawElements со всем состоянием, которое ему нужно
+struct DrawItem {
+    uint64_t key = 0;
+    GLuint program = 0;
+    GLuint vao = 0;
+    GLsizei indexCount = 0;
+    GLuint firstIndex = 0;               // диапазон меша в общем буфере (MeshRange)
+    GLint baseVertex = 0;
+    uint32_t material = 0;               // номер материала: одинаковые номера — одинаковый albedo
+    glm::vec3 albedo = glm::vec3(1.0f);
+    glm::mat4 model = glm::mat4(1.0f);
+};
+
+struct RenderQueue {
+    std::vector<DrawItem> items;
+    std::vector<uint32_t> order;    // индексы items после сортировки
+    std::vector<uint32_t> scratch;
+};
+
+// Сколько раз пришлось действительно менять состояние за последнюю отправку
+struct RenderStats {
+    int draws = 0;
+    int programChanges = 0;
+    int vaoChanges = 0;
+    int materialChanges = 0;
+    int multiDraws = 0; // вызовы glMultiDrawElementsIndirect, каждый рисует пакет draws
+};
+
+// Данные одного рисования для шейдера, читаются по gl_DrawID (раскладка std430)
+struct DrawData {
+    glm::mat4 model;
+    glm::vec4 albedo;
+};
+
+// Команды и данные рисований кадра. Буферы пересоздаются (orphaning) каждую отправку
+// и растут вдвое, когда очередь в них не помещается.
+struct IndirectDrawBuffers {
+    GLuint commandBuffer = 0;  // GL_DRAW_INDIRECT_BUFFER
+    GLuint drawDataBuffer = 0; // GL_SHADER_STORAGE_BUFFER, точка привязки drawDataBinding
+    size_t capacity = 0;       // рисований
+    std::vector<DrawElementsIndirectCommand> commands;
+    std::vector<DrawData> drawData;
+};
+
+const GLuint drawDataBinding = 0;
+
+// Ключ сортировки, старшие поля важнее:
+//   63..60 слой (проход), 59..48 программа, 47..36 VAO, 35..24 материал, 23..0 глубина
+// Имена GL и номера материалов обрезаются до 12 бит: совпадение ключей лишь ухудшает
+// группировку, лишние смены состояния всё равно отсекаются при отправке.
+// depth — расстояние, делённое на дальнюю плоскость; ближние объекты идут первыми.
+uint64_t makeSortKey(uint32_t layer, GLuint program, GLuint vao, uint32_t material, float depth);
+
+// Поразрядная сортировка по ключу (8 проходов по байту, одинаковые во всех ключах байты пропускаются)
+void sortRenderQueue(RenderQueue& queue);
+
+// Сортирует и рисует очередь, вызывая glUseProgram, glBindVertexArray и загрузку albedo только
+// при смене значения. bindProgram вызывается после каждой смены программы для общих
+// uniform-переменных кадра; model и albedo очередь загружает сама. Очередь очищается.
+RenderStats submitRenderQueue(RenderQueue& queue, const std::function<void(GLuint program)>& bindProgram);
+
+// glMultiDrawElementsIndirect, gl_DrawID и буферы хранения шейдера (GL 4.3 + ARB_shader_draw_parameters)
+bool multiDrawIndirectSupported();
+
+void initIndirectDrawBuffers(IndirectDrawBuffers& buffers);
+void destroyIndirectDrawBuffers(IndirectDrawBuffers& buffers);
+
+// Как submitRenderQueue, но подряд идущие рисования с одной программой и VAO уходят одним
+// glMultiDrawElementsIndirect. model и albedo лежат в буфере DrawData, шейдер читает
+// draws[drawBase + gl_DrawID]: uniform drawBase — номер первого рисования пакета.
+// Смена материала больше не меняет состояние, materialChanges остаётся нулём.
+RenderStats submitRenderQueueIndirect(RenderQueue& queue, IndirectDrawBuffers& buffers,
+                                      const std::function<void(GLuint program)>& bindProgram);
@@ -0,0 +1,184 @@
+#include "render_thread.hpp"
+#include "allocation_counter.hpp"
+#include "frame_arena.hpp"
+#include "gpu_memory.hpp"
+#include "input.hpp"
+#include "perf_counters.hpp"
+#include "profiler.hpp"
+#include "spsc_queue.hpp"
+
+#include <GL/glew.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+const auto eventPollInterval = std::chrono::milliseconds(1);
+
+struct WindowMessage {
+    enum Type { Keys, Resize, Close, Pointer, Click };
+    Type type = Keys;
+    KeyState keys;
+    float time = 0.0f;
+    int width = 0;
+    int height = 0;
+    int x = 0; // мышь для Pointer и Click
+    int y = 0;
+};
+
+struct RenderThreadState {
+    SpscQueue<WindowMessage, 256> messages;
+    std::atomic<bool> running{true};
+    Clock::time_point start;
+};
+
+float secondsSince(Clock::time_point start) {
+    return std::chrono::duration<float>(Clock::now() - start).count();
+}
+
+void pushMessage(RenderThreadState& state, const WindowMessage& message) {
+    // Очередь полна, только если поток отрисовки стоит; нажатия не теряем, а ждём
+    while (!state.messages.tryPush(message) && state.running.load())
+        std::this_thread::yield();
+}
+
+void renderThreadMain(sf::Window& window, FramePacer& pacer, const RenderLoop& loop, RenderThreadState& state) {
+    PROFILE_THREAD("Render");
+    window.setActive(true);
+    glewInit();
+    loop.init();
+
+    float inputTime = secondsSince(state.start); // до этого момента ввод уже учтён
+    while (state.running.load()) {
+        {
+            PROFILE_ZONE("Frame pacing");
+            waitForNextFrame(pacer);
+        }
+        PROFILE_ZONE("Frame");
+        Clock::time_point frameStart = Clock::now();
+        uint64_t allocationsBefore = heapAllocationCount();
+        {
+            PROFILE_ZONE("Update");
+            loop.update();
+        }
+
+        // Позднее снятие ввода: всё, что пришло из потока окна к этому моменту
+        bool live = isLiveInput();
+        bool pointerMoved = false;
+        int pointerX = 0, pointerY = 0;
+        WindowMessage message;
+        while (state.messages.tryPop(message)) {
+            if (message.type == WindowMessage::Close) {
+                state.running = false;
+            } else if (message.type == WindowMessage::Resize) {
+                loop.resize(message.width, message.height);
+            } else if (message.type == WindowMessage::Pointer) {
+                pointerMoved = true;
+                pointerX = message.x;
+                pointerY = message.y;
+            } else if (message.type == WindowMessage::Click) {
+                if (loop.pointer)
+                    loop.pointer(message.x, message.y, true);
+            } else {
+                // Прежние клавиши были зажаты до момента снимка
+                if (live && message.time > inputTime) {
+                    loop.stepInput(message.time, std::min(message.time - inputTime, pacer.maxFrameDelta));
+                    inputTime = message.time;
+                }
+                submitInputKeys(message.keys);
+            }
+        }
+        if (!state.running.load())
+            break;
+        if (pointerMoved && loop.pointer)
+            loop.pointer(pointerX, pointerY, false);
+
+        float now = std::max(secondsSince(state.start), inputTime);
+        {
+            PROFILE_ZONE("Input");
+            loop.stepInput(now, std::min(now - inputTime, pacer.maxFrameDelta));
+        }
+        inputTime = now;
+        if (inputReplayFinished()) {
+            state.running = false;
+            break;
+        }
+
+        loop.render();
+        {
+            PROFILE_ZONE("Present");
+            window.display();
+        }
+        PROFILE_FRAME();
+        addPerfCounter(PerfCounter::HeapAllocations, heapAllocationCount() - allocationsBefore);
+        publishPerfFrame(std::chrono::duration<double, std::milli>(Clock::now() - frameStart).count());
+        resetFrameArena(frameArena());
+        updateGpuMemory();
+    }
+
+    loop.shutdown();
+    // После shutdown всё созданное лабораторной должно быть удалено
+    GpuMemoryStats leaked = gpuMemoryStats();
+    if (leaked.totalBytes() > 0 || leaked.buffers + leaked.textures + leaked.renderbuffers + leaked.vertexArrays > 0)
+        printGpuMemory("Warning: GPU objects left after shutdown");
+    window.setActive(false);
+}
+
+} // namespace
+
+void runRenderThread(sf::Window& window, FramePacer& pacer, const RenderLoop& loop) {
+    RenderThreadState state;
+    state.start = Clock::now();
+
+    window.setActive(false);
+    std::thread renderThread(renderThreadMain, std::ref(window), std::ref(pacer), std::cref(loop), std::ref(state));
+
+    KeyState keys;
+    KeyState sentKeys;
+    while (state.running.load()) {
+        sf::Event event;
+        while (window.pollEvent(event)) {
+            WindowMessage message;
+            message.time = secondsSince(state.start);
+            if (event.type == sf::Event::Closed) {
+                message.type = WindowMessage::Close;
+                pushMessage(state, message);
+            } else if (event.type == sf::Event::Resized) {
+                message.type = WindowMessage::Resize;
+                message.width = event.size.width;
+                message.height = event.size.height;
+                pushMessage(state, message);
+            } else if (event.type == sf::Event::KeyPressed || event.type == sf::Event::KeyReleased) {
+                if (event.key.code >= 0 && event.key.code < sf::Keyboard::KeyCount)
+                    keys[event.key.code] = event.type == sf::Event::KeyPressed;
+            } else if (event.type == sf::Event::MouseMoved) {
+                message.type = WindowMessage::Pointer;
+                message.x = event.mouseMove.x;
+                message.y = event.mouseMove.y;
+                pushMessage(state, message);
+            } else if (event.type == sf::Event::MouseButtonPressed && event.mouseButton.button == sf::Mouse::Left) {
+                message.type = WindowMessage::Click;
+                message.x = event.mouseButton.x;
+                message.y = event.mouseButton.y;
+                pushMessage(state, message);
+            } else if (event.type == sf::Event::LostFocus) {
+                keys.reset(); // отпускание клавиш вне окна не придёт
+            }
+
+            if (keys != sentKeys) {
+                message.type = WindowMessage::Keys;
+                message.keys = keys;
+                pushMessage(state, message);
+                sentKeys = keys;
+            }
+        }
+        std::this_thread::sleep_for(eventPollInterval);
+    }
+
+    renderThread.join();
+    window.close();
+}
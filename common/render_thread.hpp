@@ -0,0 +1,27 @@
+#pragma once
+
+#include "frame_pacer.hpp"
+
+#include <SFML/Window.hpp>
+#include <functional>
+
+// Части кадра, которые поток отрисовки вызывает со своим GL-контекстом
+struct RenderLoop {
+    std::function<void()> init;
+    std::function<void(int width, int height)> resize;
+    std::function<void()> update; // работа кадра, не зависящая от камеры: шейдеры, загрузка данных
+    std::function<void(float wallTime, float wallDelta)> stepInput;
+    std::function<void()> render;
+    // Мышь над окном (x, y в пикселях) или нажатие левой кнопки в этой точке; необязательно.
+    // Перемещения за кадр сливаются в последнее, нажатия приходят все. В запись ввода не попадает.
+    std::function<void(int x, int y, bool click)> pointer;
+    std::function<void()> shutdown; // удаление GL-объектов, пока контекст ещё активен
+};
+
+// Главный поток только разбирает события окна: нажатия, изменение размера и закрытие идут
+// через очередь без блокировок в поток отрисовки, который забирает контекст через setActive.
+// Ввод снимается как можно позже — после update, прямо перед render. При живом вводе камера
+// сдвигается по каждому снимку клавиш со своим интервалом, поэтому долгий кадр не теряет
+// короткие нажатия, а медленный разбор событий не задерживает отрисовку.
+// Возвращает, когда окно закрыто или кончилась запись ввода.
+void runRenderThread(sf::Window& window, FramePacer& pacer, const RenderLoop& loop);
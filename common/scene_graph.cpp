@@ -0,0 +1,126 @@
+#include "scene_graph.hpp"
+#include "parallel.hpp"
+#include "profiler.hpp"
+#include "transforms.hpp"
+
+#include <algorithm>
+#include <atomic>
+
+namespace {
+
+const size_t nodeGrain = 2048;
+
+void markDirty(SceneGraph& graph, uint32_t node) {
+    if (!graph.dirty[node]) {
+        graph.dirty[node] = 1;
+        ++graph.dirtyCount;
+    }
+}
+
+// Пересчитывает узел, если он сам или его родитель изменились; родитель уже обновлён
+bool updateNode(SceneGraph& graph, size_t node) {
+    uint32_t parent = graph.parent[node];
+    bool recompute = graph.dirty[node] || (parent != noSceneParent && graph.changed[parent]);
+    graph.changed[node] = recompute;
+    if (!recompute)
+        return false;
+
+    glm::mat4 local = trsMatrix(graph.translation[node], graph.rotation[node], graph.scale[node]);
+    graph.world[node] = parent == noSceneParent ? local : graph.world[parent] * local;
+    graph.dirty[node] = 0;
+
+    const glm::vec4& bounds = graph.localBounds[node];
+    if (bounds.w < 0.0f) {
+        graph.worldBounds[node] = bounds;
+        return true;
+    }
+    const glm::mat4& world = graph.world[node];
+    float maxScale = std::max(glm::length(glm::vec3(world[0])), std::max(glm::length(glm::vec3(world[1])), glm::length(glm::vec3(world[2]))));
+    graph.worldBounds[node] = glm::vec4(glm::vec3(world * glm::vec4(glm::vec3(bounds), 1.0f)), bounds.w * maxScale);
+    return true;
+}
+
+} // namespace
+
+uint32_t addSceneNode(SceneGraph& graph, uint32_t parent, const glm::vec3& translation, const glm::vec3& rotation,
+                      const glm::vec3& scale) {
+    uint32_t node = (uint32_t)graph.parent.size();
+    uint32_t depth = parent == noSceneParent ? 0 : graph.depth[parent] + 1;
+    if (depth == graph.levelStart.size())
+        graph.levelStart.push_back(node);
+    else if (depth + 1 != graph.levelStart.size())
+        graph.levelOrdered = false;
+
+    graph.parent.push_back(parent);
+    graph.depth.push_back(depth);
+    graph.translation.push_back(translation);
+    graph.rotation.push_back(rotation);
+    graph.scale.push_back(scale);
+    graph.localBounds.push_back(glm::vec4(0.0f, 0.0f, 0.0f, -1.0f));
+    graph.world.push_back(glm::mat4(1.0f));
+    graph.worldBounds.push_back(glm::vec4(0.0f, 0.0f, 0.0f, -1.0f));
+    graph.dirty.push_back(0);
+    graph.changed.push_back(0);
+    markDirty(graph, node);
+    return node;
+}
+
+void setNodeTranslation(SceneGraph& graph, uint32_t node, const glm::vec3& translation) {
+    graph.translation[node] = translation;
+    markDirty(graph, node);
+}
+
+void setNodeRotation(SceneGraph& graph, uint32_t node, const glm::vec3& rotation) {
+    graph.rotation[node] = rotation;
+    markDirty(graph, node);
+}
+
+void setNodeScale(SceneGraph& graph, uint32_t node, const glm::vec3& scale) {
+    graph.scale[node] = scale;
+    markDirty(graph, node);
+}
+
+void setNodeBounds(SceneGraph& graph, uint32_t node, const glm::vec3& center, float radius) {
+    graph.localBounds[node] = glm::vec4(center, radius);
+    markDirty(graph, node);
+}
+
+void clearSceneGraph(SceneGraph& graph) {
+    graph = SceneGraph();
+}
+
+size_t updateSceneGraph(SceneGraph& graph) {
+    if (graph.dirtyCount == 0) {
+        // Флаги прошлого обновления читаются до следующего, потом гасятся
+        if (graph.changedCount > 0)
+            std::fill(graph.changed.begin(), graph.changed.end(), 0);
+        graph.changedCount = 0;
+        return 0;
+    }
+
+    PROFILE_ZONE("Update scene graph");
+    size_t nodeCount = graph.parent.size();
+    size_t updated = 0;
+    if (!graph.levelOrdered) {
+        for (size_t node = 0; node < nodeCount; ++node)
+            updated += updateNode(graph, node);
+    } else {
+        // Узлы уровня зависят только от предыдущего уровня, внутри уровня — независимы
+        std::atomic<size_t> levelUpdated(0);
+        for (size_t level = 0; level < graph.levelStart.size(); ++level) {
+            size_t first = graph.levelStart[level];
+            size_t last = level + 1 < graph.levelStart.size() ? graph.levelStart[level + 1] : nodeCount;
+            parallelFor(last - first, nodeGrain, [&](size_t begin, size_t end) {
+                size_t count = 0;
+                for (size_t node = first + begin; node < first + end; ++node)
+                    count += updateNode(graph, node);
+                levelUpdated += count;
+            });
+        }
+        updated = levelUpdated;
+    }
+
+    graph.dirtyCount = 0;
+    graph.changedCount = updated;
+    return updated;
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+const uint32_t noSceneParent = ~0u;
+
+// Иерархия узлов в виде параллельных массивов, родитель всегда раньше детей. Локальные
+// перенос, поворот и масштаб меняются через setNode*, которые помечают узел; мировые
+// матрицы и сферы пересчитываются в updateSceneGraph только для помеченных поддеревьев.
+// Если узлы добавлялись по уровням (все узлы глубины d раньше узлов глубины d + 1),
+// уровни обновляются параллельно; иначе — одним последовательным проходом.
+struct SceneGraph {
+    std::vector<uint32_t> parent;
+    std::vector<uint32_t> depth;
+    std::vector<glm::vec3> translation;
+    std::vector<glm::vec3> rotation;      // углы Эйлера в радианах, как в trsMatrix
+    std::vector<glm::vec3> scale;
+    std::vector<glm::vec4> localBounds;   // сфера в координатах узла: центр, радиус; радиус < 0 — без геометрии
+
+    std::vector<glm::mat4> world;
+    std::vector<glm::vec4> worldBounds;   // сфера в мировых координатах, для отсечения
+    std::vector<uint8_t> dirty;           // локальное преобразование изменилось после обновления
+    std::vector<uint8_t> changed;         // мировая матрица пересчитана последним обновлением
+
+    std::vector<uint32_t> levelStart;     // первый узел каждого уровня
+    bool levelOrdered = true;
+    size_t dirtyCount = 0;
+    size_t changedCount = 0;
+};
+
+// Добавляет узел под parent (или корень при noSceneParent) и возвращает его номер
+uint32_t addSceneNode(SceneGraph& graph, uint32_t parent, const glm::vec3& translation,
+                      const glm::vec3& rotation = glm::vec3(0.0f), const glm::vec3& scale = glm::vec3(1.0f));
+
+void setNodeTranslation(SceneGraph& graph, uint32_t node, const glm::vec3& translation);
+void setNodeRotation(SceneGraph& graph, uint32_t node, const glm::vec3& rotation);
+void setNodeScale(SceneGraph& graph, uint32_t node, const glm::vec3& scale);
+void setNodeBounds(SceneGraph& graph, uint32_t node, const glm::vec3& center, float radius);
+
+void clearSceneGraph(SceneGraph& graph);
+
+// Пересчитывает помеченные узлы и всех их потомков, возвращает число пересчитанных узлов
+size_t updateSceneGraph(SceneGraph& graph);
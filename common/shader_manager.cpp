@@ -0,0 +1,303 @@
+#include "shader_manager.hpp"
+#include "profiler.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+namespace {
+
+struct ShaderProgramEntry {
+    GLuint program = 0;
+    std::string vertexPath;
+    std::string fragmentPath;
+    std::vector<std::string> defines;
+    std::filesystem::file_time_type vertexTime;
+    std::filesystem::file_time_type fragmentTime;
+};
+
+std::vector<ShaderProgramEntry> programs;
+std::string cacheDirectory = ".shader_cache";
+bool hotReload = false;
+std::chrono::steady_clock::time_point lastReloadCheck;
+
+const uint32_t cacheMagic = 0x42504c47; // "GLPB"
+
+uint64_t hashBytes(uint64_t hash, const std::string& data) {
+    // FNV-1a
+    for (unsigned char c : data) {
+        hash ^= c;
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+bool readFile(const std::string& path, std::string& contents) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        std::cerr << "Failed to open shader " << path << std::endl;
+        return false;
+    }
+    std::stringstream buffer;
+    buffer << file.rdbuf();
+    contents = buffer.str();
+    return true;
+}
+
+std::filesystem::file_time_type modificationTime(const std::string& path) {
+    std::error_code error;
+    return std::filesystem::last_write_time(path, error);
+}
+
+// Вставляет #define после строки #version, #line сохраняет номера строк в сообщениях об ошибках.
+// VERTEX_SHADER / FRAGMENT_SHADER позволяют держать обе стадии в одном файле.
+std::string applyDefines(const std::string& source, const std::vector<std::string>& defines, const char* stage) {
+    size_t versionPos = source.find("#version");
+    size_t insertPos = versionPos == std::string::npos ? 0 : source.find('\n', versionPos);
+    if (insertPos == std::string::npos)
+        insertPos = source.size();
+    else if (versionPos != std::string::npos)
+        ++insertPos;
+
+    int versionLine = 0;
+    for (size_t i = 0; i < insertPos; ++i) {
+        if (source[i] == '\n')
+            ++versionLine;
+    }
+
+    std::string header = std::string("#define ") + stage + "\n";
+    for (const std::string& define : defines)
+        header += "#define " + define + "\n";
+    header += "#line " + std::to_string(versionLine + 1) + "\n";
+
+    return source.substr(0, insertPos) + header + source.substr(insertPos);
+}
+
+GLuint compileShader(const std::string& source, GLenum shaderType, const std::string& name) {
+    PROFILE_ZONE("Compile shader");
+    GLuint shader = glCreateShader(shaderType);
+    const char* src = source.c_str();
+    glShaderSource(shader, 1, &src, nullptr);
+    glCompileShader(shader);
+
+    GLint success;
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+    if (!success) {
+        GLint logLength = 0;
+        glGetShaderiv(shader, GL_INFO_LOG_LENGTH, &logLength);
+        std::string infoLog(std::max(logLength, 1), '\0');
+        glGetShaderInfoLog(shader, logLength, nullptr, &infoLog[0]);
+        std::cerr << "Shader compilation error in " << name << ": " << infoLog.c_str() << std::endl;
+        glDeleteShader(shader);
+        return 0;
+    }
+    return shader;
+}
+
+bool linkProgram(GLuint program, GLuint vertexShader, GLuint fragmentShader, const std::string& name) {
+    PROFILE_ZONE("Link program");
+    GLint attachedCount = 0;
+    GLuint attached[8];
+    glGetAttachedShaders(program, 8, &attachedCount, attached);
+    for (GLint i = 0; i < attachedCount; ++i)
+        glDetachShader(program, attached[i]);
+
+    glAttachShader(program, vertexShader);
+    glAttachShader(program, fragmentShader);
+    if (GLEW_ARB_get_program_binary)
+        glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    glLinkProgram(program);
+    glDetachShader(program, vertexShader);
+    glDetachShader(program, fragmentShader);
+
+    GLint success;
+    glGetProgramiv(program, GL_LINK_STATUS, &success);
+    if (!success) {
+        GLint logLength = 0;
+        glGetProgramiv(program, GL_INFO_LOG_LENGTH, &logLength);
+        std::string infoLog(std::max(logLength, 1), '\0');
+        glGetProgramInfoLog(program, logLength, nullptr, &infoLog[0]);
+        std::cerr << "Shader program linking error in " << name << ": " << infoLog.c_str() << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool binaryCacheEnabled() {
+    if (cacheDirectory.empty() || !GLEW_ARB_get_program_binary)
+        return false;
+    GLint formats = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+    return formats > 0;
+}
+
+std::string cachePath(uint64_t hash) {
+    char name[32];
+    std::snprintf(name, sizeof(name), "%016llx.bin", (unsigned long long)hash);
+    return cacheDirectory + "/" + name;
+}
+
+bool loadProgramBinary(GLuint program, uint64_t hash) {
+    std::ifstream file(cachePath(hash), std::ios::binary);
+    if (!file)
+        return false;
+
+    uint32_t magic = 0;
+    GLenum format = 0;
+    uint32_t length = 0;
+    file.read((char*)&magic, sizeof(magic));
+    file.read((char*)&format, sizeof(format));
+    file.read((char*)&length, sizeof(length));
+    if (!file || magic != cacheMagic || length == 0)
+        return false;
+
+    std::vector<char> binary(length);
+    file.read(binary.data(), length);
+    if (!file)
+        return false;
+
+    // Бинарник мог устареть после обновления драйвера, тогда просто собираем заново
+    glProgramBinary(program, format, binary.data(), length);
+    GLint success;
+    glGetProgramiv(program, GL_LINK_STATUS, &success);
+    return success;
+}
+
+void saveProgramBinary(GLuint program, uint64_t hash) {
+    GLint length = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0)
+        return;
+
+    std::vector<char> binary(length);
+    GLenum format = 0;
+    glGetProgramBinary(program, length, nullptr, &format, binary.data());
+
+    std::error_code error;
+    std::filesystem::create_directories(cacheDirectory, error);
+    std::ofstream file(cachePath(hash), std::ios::binary);
+    if (!file)
+        return;
+
+    uint32_t size = (uint32_t)length;
+    file.write((const char*)&cacheMagic, sizeof(cacheMagic));
+    file.write((const char*)&format, sizeof(format));
+    file.write((const char*)&size, sizeof(size));
+    file.write(binary.data(), length);
+}
+
+// Собирает программу entry.program из исходников. При useCache сначала пробует бинарный кэш.
+bool buildProgram(ShaderProgramEntry& entry, bool useCache) {
+    PROFILE_ZONE("Build shader program");
+    std::string vertexSource, fragmentSource;
+    if (!readFile(entry.vertexPath, vertexSource) || !readFile(entry.fragmentPath, fragmentSource))
+        return false;
+    entry.vertexTime = modificationTime(entry.vertexPath);
+    entry.fragmentTime = modificationTime(entry.fragmentPath);
+
+    vertexSource = applyDefines(vertexSource, entry.defines, "VERTEX_SHADER");
+    fragmentSource = applyDefines(fragmentSource, entry.defines, "FRAGMENT_SHADER");
+
+    bool cacheEnabled = binaryCacheEnabled();
+    uint64_t hash = 14695981039346656037ull;
+    if (cacheEnabled) {
+        hash = hashBytes(hash, (const char*)glGetString(GL_RENDERER));
+        hash = hashBytes(hash, (const char*)glGetString(GL_VERSION));
+        hash = hashBytes(hash, vertexSource);
+        hash = hashBytes(hash, std::string(1, '\0'));
+        hash = hashBytes(hash, fragmentSource);
+    }
+
+    if (cacheEnabled && useCache && loadProgramBinary(entry.program, hash))
+        return true;
+
+    GLuint vertexShader = compileShader(vertexSource, GL_VERTEX_SHADER, entry.vertexPath);
+    GLuint fragmentShader = compileShader(fragmentSource, GL_FRAGMENT_SHADER, entry.fragmentPath);
+    bool success = vertexShader && fragmentShader;
+
+    if (success && useCache) {
+        success = linkProgram(entry.program, vertexShader, fragmentShader, entry.vertexPath);
+    } else if (success) {
+        // Горячая перезагрузка: проверяем линковку на временной программе, чтобы
+        // не испортить рабочую, если в новом исходнике ошибка
+        GLuint scratch = glCreateProgram();
+        success = linkProgram(scratch, vertexShader, fragmentShader, entry.vertexPath);
+        glDeleteProgram(scratch);
+        if (success)
+            success = linkProgram(entry.program, vertexShader, fragmentShader, entry.vertexPath);
+    }
+
+    glDeleteShader(vertexShader);
+    glDeleteShader(fragmentShader);
+
+    if (success && cacheEnabled)
+        saveProgramBinary(entry.program, hash);
+    return success;
+}
+
+} // namespace
+
+GLuint loadShaderProgram(const std::string& vertexPath, const std::string& fragmentPath,
+                         const std::vector<std::string>& defines) {
+    for (const ShaderProgramEntry& entry : programs) {
+        if (entry.vertexPath == vertexPath && entry.fragmentPath == fragmentPath && entry.defines == defines)
+            return entry.program;
+    }
+
+    ShaderProgramEntry entry;
+    entry.program = glCreateProgram();
+    entry.vertexPath = vertexPath;
+    entry.fragmentPath = fragmentPath;
+    entry.defines = defines;
+
+    if (!buildProgram(entry, true)) {
+        glDeleteProgram(entry.program);
+        return 0;
+    }
+
+    programs.push_back(entry);
+    return entry.program;
+}
+
+void setShaderCacheDirectory(const std::string& directory) {
+    cacheDirectory = directory;
+}
+
+void setShaderHotReload(bool enabled) {
+    hotReload = enabled;
+}
+
+bool reloadChangedShaders() {
+    if (!hotReload)
+        return false;
+
+    // Опрашиваем файловую систему не чаще двух раз в секунду
+    auto now = std::chrono::steady_clock::now();
+    if (now - lastReloadCheck < std::chrono::milliseconds(500))
+        return false;
+    lastReloadCheck = now;
+
+    bool reloaded = false;
+    for (ShaderProgramEntry& entry : programs) {
+        if (modificationTime(entry.vertexPath) == entry.vertexTime &&
+            modificationTime(entry.fragmentPath) == entry.fragmentTime)
+            continue;
+
+        if (buildProgram(entry, false)) {
+            std::cout << "Reloaded shader program " << entry.vertexPath << " + " << entry.fragmentPath << std::endl;
+            reloaded = true;
+        }
+    }
+    return reloaded;
+}
+
+void deleteShaderPrograms() {
+    for (const ShaderProgramEntry& entry : programs)
+        glDeleteProgram(entry.program);
+    programs.clear();
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <GL/glew.h>
+#include <string>
+#include <vector>
+
+// Загружает программу из файлов. Каждая строка defines превращается в "#define <строка>"
+// сразу после #version, вместе с VERTEX_SHADER или FRAGMENT_SHADER для текущей стадии.
+// Повторный вызов с теми же аргументами возвращает ту же программу.
+// Слинкованные программы сохраняются через glGetProgramBinary и при следующем запуске
+// загружаются без компиляции. Возвращает 0 при ошибке.
+GLuint loadShaderProgram(const std::string& vertexPath, const std::string& fragmentPath,
+                         const std::vector<std::string>& defines = {});
+
+// Каталог кэша бинарников программ, пустая строка отключает кэш
+void setShaderCacheDirectory(const std::string& directory);
+
+void setShaderHotReload(bool enabled);
+
+// Перекомпилирует программы, чьи исходники изменились на диске. Идентификаторы программ
+// не меняются; при ошибке компиляции остаётся старая версия. Возвращает true, если
+// хотя бы одна программа была пересобрана.
+bool reloadChangedShaders();
+
+void deleteShaderPrograms();
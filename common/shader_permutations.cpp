@@ -0,0 +1,33 @@
+#include "shader_permutations.hpp"
+#include "shader_manager.hpp"
+
+#include <bit>
+#include <iostream>
+
+std::vector<std::string> permutationDefines(const ShaderPermutationSet& set, uint32_t key) {
+    std::vector<std::string> defines;
+    for (const ShaderFeature& feature : set.features) {
+        uint32_t value = (key & feature.mask) >> std::countr_zero(feature.mask);
+        // Нулевое значение поля оставляет значение по умолчанию из самого шейдера
+        if (value == 0)
+            continue;
+        if (std::popcount(feature.mask) == 1)
+            defines.push_back(feature.define);
+        else
+            defines.push_back(feature.define + " " + std::to_string(value));
+    }
+    return defines;
+}
+
+GLuint getShaderPermutation(ShaderPermutationSet& set, uint32_t key) {
+    auto it = set.programs.find(key);
+    if (it != set.programs.end())
+        return it->second;
+
+    GLuint program = loadShaderProgram(set.vertexPath, set.fragmentPath, permutationDefines(set, key));
+    if (program == 0)
+        std::cerr << "Failed to build shader permutation 0x" << std::hex << key << std::dec << std::endl;
+
+    set.programs[key] = program;
+    return program;
+}
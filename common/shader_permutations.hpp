@@ -0,0 +1,27 @@
+#pragma once
+
+#include <GL/glew.h>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Поле ключа перестановки. Поле из одного бита даёт "#define name", если бит выставлен;
+// многобитовое поле даёт "#define name <значение поля>", если значение не ноль.
+struct ShaderFeature {
+    std::string define;
+    uint32_t mask;
+};
+
+// Набор вариантов одной программы, специализированных через #define
+struct ShaderPermutationSet {
+    std::string vertexPath;
+    std::string fragmentPath;
+    std::vector<ShaderFeature> features;
+    std::unordered_map<uint32_t, GLuint> programs;
+};
+
+// Возвращает вариант для ключа, компилируя его при первом обращении
+GLuint getShaderPermutation(ShaderPermutationSet& set, uint32_t key);
+
+std::vector<std::string> permutationDefines(const ShaderPermutationSet& set, uint32_t key);
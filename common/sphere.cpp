@@ -0,0 +1,75 @@
+#include "sphere.hpp"
+#include "profiler.hpp"
+
+#include <cmath>
+
+void generateSphere(std::vector<GLfloat>& vertices, std::vector<GLuint>& indices, float radius, int sectorCount, int stackCount) {
+    PROFILE_ZONE("generateSphere");
+    float x, y, z, xy;
+    float nx, ny, nz;
+    float lengthInv = 1.0f / radius;
+
+    float sectorStep = 2 * M_PI / sectorCount;
+    float stackStep = M_PI / stackCount;
+    float sectorAngle, stackAngle;
+
+    for (int i = 0; i <= stackCount; ++i) {
+        stackAngle = M_PI / 2 - i * stackStep;
+        xy = radius * cosf(stackAngle);
+        z = radius * sinf(stackAngle);
+
+        for (int j = 0; j <= sectorCount; ++j) {
+            sectorAngle = j * sectorStep;
+
+            x = xy * cosf(sectorAngle);
+            y = xy * sinf(sectorAngle);
+            vertices.push_back(x);
+            vertices.push_back(y);
+            vertices.push_back(z);
+
+            nx = x * lengthInv;
+            ny = y * lengthInv;
+            nz = z * lengthInv;
+            vertices.push_back(nx);
+            vertices.push_back(ny);
+            vertices.push_back(nz);
+        }
+    }
+
+    int k1, k2;
+    for (int i = 0; i < stackCount; ++i) {
+        k1 = i * (sectorCount + 1);
+        k2 = k1 + sectorCount + 1;
+
+        for (int j = 0; j < sectorCount; ++j, ++k1, ++k2) {
+            if (i != 0) {
+                indices.push_back(k1);
+                indices.push_back(k2);
+                indices.push_back(k1 + 1);
+            }
+
+            if (i != (stackCount - 1)) {
+                indices.push_back(k1 + 1);
+                indices.push_back(k2);
+                indices.push_back(k2 + 1);
+            }
+        }
+    }
+}
+
+std::vector<float> generateSphereVertices(float radius, int numSegments) {
+    std::vector<float> vertices;
+    for (int i = 0; i <= numSegments; ++i) {
+        float theta = i * M_PI / numSegments;
+        for (int j = 0; j <= numSegments; ++j) {
+            float phi = j * 2 * M_PI / numSegments;
+            float x = radius * sin(theta) * cos(phi);
+            float y = radius * sin(theta) * sin(phi);
+            float z = radius * cos(theta);
+            vertices.push_back(x);
+            vertices.push_back(y);
+            vertices.push_back(z);
+        }
+    }
+    return vertices;
+}
@@ -0,0 +1,11 @@
+#pragma once
+
+#include <GL/glew.h>
+#include <vector>
+
+// UV-сфера: stackCount поясов по широте, sectorCount секторов по долготе. В vertices
+// дописываются позиция и нормаль (6 float на вершину), в indices — треугольники.
+void generateSphere(std::vector<GLfloat>& vertices, std::vector<GLuint>& indices, float radius, int sectorCount, int stackCount);
+
+// Только позиции (3 float на вершину) на сетке numSegments x numSegments, без индексов
+std::vector<float> generateSphereVertices(float radius, int numSegments);
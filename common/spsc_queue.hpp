@@ -0,0 +1,36 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+
+// Очередь без блокировок на одного писателя и одного читателя. Индексы только растут,
+// ячейка выбирается по маске, поэтому Capacity — степень двойки. Каждый поток пишет только
+// свой индекс; индексы лежат в разных кэш-линиях, чтобы потоки не сбрасывали друг другу кэш.
+template <typename T, size_t Capacity>
+struct SpscQueue {
+    static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "capacity must be a power of two");
+
+    T slots[Capacity];
+    alignas(64) std::atomic<size_t> head{0}; // следующая ячейка для чтения, пишет читатель
+    alignas(64) std::atomic<size_t> tail{0}; // следующая ячейка для записи, пишет писатель
+
+    // Только из потока-писателя. false, если очередь заполнена.
+    bool tryPush(const T& value) {
+        size_t position = tail.load(std::memory_order_relaxed);
+        if (position - head.load(std::memory_order_acquire) == Capacity)
+            return false;
+        slots[position & (Capacity - 1)] = value;
+        tail.store(position + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Только из потока-читателя. false, если очередь пуста.
+    bool tryPop(T& value) {
+        size_t position = head.load(std::memory_order_relaxed);
+        if (position == tail.load(std::memory_order_acquire))
+            return false;
+        value = slots[position & (Capacity - 1)];
+        head.store(position + 1, std::memory_order_release);
+        return true;
+    }
+};
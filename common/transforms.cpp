@@ -0,0 +1,70 @@
+#include "transforms.hpp"
+
+#include <cmath>
+
+glm::mat4 scaleMatrix(float scaleX, float scaleY, float scaleZ) {
+    glm::mat4 scale = glm::mat4(1.0f);
+    scale[0][0] = scaleX;
+    scale[1][1] = scaleY;
+    scale[2][2] = scaleZ;
+    return scale;
+}
+
+glm::mat4 translateMatrix(const glm::vec3& translation) {
+    glm::mat4 translationMatrix = glm::mat4(1.0f);
+    translationMatrix[3][0] = translation.x;
+    translationMatrix[3][1] = translation.y;
+    translationMatrix[3][2] = translation.z;
+    return translationMatrix;
+}
+
+glm::mat4 trsMatrix(const glm::vec3& translation, const glm::vec3& rotation, const glm::vec3& scale) {
+    float sx = sin(rotation.x), cx = cos(rotation.x);
+    float sy = sin(rotation.y), cy = cos(rotation.y);
+    float sz = sin(rotation.z), cz = cos(rotation.z);
+
+    // Столбцы Rz * Ry * Rx, умноженные на масштаб по своей оси
+    glm::mat4 trs = glm::mat4(1.0f);
+    trs[0] = glm::vec4(cy * cz, cy * sz, -sy, 0.0f) * scale.x;
+    trs[1] = glm::vec4(sx * sy * cz - cx * sz, sx * sy * sz + cx * cz, sx * cy, 0.0f) * scale.y;
+    trs[2] = glm::vec4(cx * sy * cz + sx * sz, cx * sy * sz - sx * cz, cx * cy, 0.0f) * scale.z;
+    trs[3] = glm::vec4(translation, 1.0f);
+    return trs;
+}
+
+glm::mat4 lookAt(const glm::vec3& eye, const glm::vec3& target, const glm::vec3& up) {
+    glm::vec3 forward = glm::normalize(target - eye);
+    glm::vec3 right = glm::normalize(glm::cross(forward, up));
+    glm::vec3 newUp = glm::cross(right, forward);
+
+    glm::mat4 view = glm::mat4(1.0f);
+    view[0][0] = right.x;
+    view[1][0] = right.y;
+    view[2][0] = right.z;
+    view[0][1] = newUp.x;
+    view[1][1] = newUp.y;
+    view[2][1] = newUp.z;
+    view[0][2] = -forward.x;
+    view[1][2] = -forward.y;
+    view[2][2] = -forward.z;
+    view[3][0] = -glm::dot(right, eye);
+    view[3][1] = -glm::dot(newUp, eye);
+    view[3][2] = glm::dot(forward, eye);
+
+    return view;
+}
+
+glm::mat4 perspective(float fov, float aspect, float near, float far) {
+    float tanHalfFov = tan(fov / 2.0f);
+    glm::mat4 projection = glm::mat4(0.0f);
+    projection[0][0] = 1.0f / (aspect * tanHalfFov);
+    projection[1][1] = 1.0f / tanHalfFov;
+    projection[2][2] = -(far + near) / (far - near);
+    projection[2][3] = -1.0f;
+    projection[3][2] = -(2.0f * far * near) / (far - near);
+    return projection;
+}
+
+glm::mat3 normalMatrix(const glm::mat4& model) {
+    return glm::transpose(glm::inverse(glm::mat3(model)));
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+glm::mat4 scaleMatrix(float scaleX, float scaleY, float scaleZ);
+glm::mat4 translateMatrix(const glm::vec3& translation);
+
+// Перенос * поворот * масштаб. Поворот — углы Эйлера в радианах, сначала вокруг X, затем Y, затем Z
+glm::mat4 trsMatrix(const glm::vec3& translation, const glm::vec3& rotation, const glm::vec3& scale);
+
+// Матрица вида правой системы: камера в eye смотрит на target
+glm::mat4 lookAt(const glm::vec3& eye, const glm::vec3& target, const glm::vec3& up);
+
+// Перспективная проекция в NDC [-1, 1] по глубине; fov — по вертикали, в радианах
+glm::mat4 perspective(float fov, float aspect, float near, float far);
+
+// Матрица нормалей: обратная транспонированная к линейной части model
+glm::mat3 normalMatrix(const glm::mat4& model);
+
+// Преобразования одной вершины; позиция и нормаль — первые три float по указателю
+inline glm::vec3 transformPosition(const glm::mat4& model, const GLfloat* p) {
+    return glm::vec3(model * glm::vec4(p[0], p[1], p[2], 1.0f));
+}
+
+// Нулевая нормаль остаётся нулевой, остальные нормируются
+inline glm::vec3 transformNormal(const glm::mat3& normalMatrix, const GLfloat* n) {
+    glm::vec3 normal = normalMatrix * glm::vec3(n[0], n[1], n[2]);
+    float length = glm::length(normal);
+    return length > 0.0f ? normal / length : glm::vec3(0.0f);
+}
@@ -2,21 +2,8 @@
 #include <vector>
 #include <cmath>
 #include <iostream>
-
-sf::Vector2f calculateBezierPoint(float t, const sf::Vector2f& p0, const sf::Vector2f& p1, const sf::Vector2f& p2, const sf::Vector2f& p3) {
-    float u = 1 - t;
-    float tt = t * t;
-    float uu = u * u;
-    float uuu = uu * u;
-    float ttt = tt * t;
-
-    sf::Vector2f p = uuu * p0;
-    p += 3 * uu * t * p1;     
-    p += 3 * u * tt * p2;    
-    p += ttt * p3;           
-
-    return p;
-}
+#include "../common/bezier.hpp"
+#include "../common/profiler.hpp"
 
 float distance(const sf::Vector2f& p1, const sf::Vector2f& p2) {
     return std::sqrt((p1.x - p2.x) * (p1.x - p2.x) + (p1.y - p2.y) * (p1.y - p2.y));
@@ -28,7 +15,8 @@ sf::Vector2f clampPointToWindow(const sf::Vector2f& point, const sf::RenderWindo
     return {x, y};
 }
 
-int main() {
+int main(int argc, char** argv) {
+    PROFILE_INIT(argc, argv);
     sf::RenderWindow window(sf::VideoMode(800, 600), "Кубическая кривая Безье");
 
     std::vector<sf::CircleShape> controlPoints;
@@ -56,7 +44,16 @@ int main() {
     sf::Clock clock;
     bool animationMode = false;
 
+    // Кривая и анимированная точка создаются один раз, в кадре меняются только вершины,
+    // поэтому кадр не выделяет память под массивы вершин
+    sf::VertexArray curve(sf::LinesStrip, numPoints);
+    for (int i = 0; i < numPoints; ++i)
+        curve[i].color = sf::Color::Blue;
+    sf::CircleShape animCircle(5);
+    animCircle.setFillColor(sf::Color::Green);
+
     while (window.isOpen()) {
+        PROFILE_ZONE("Frame");
         sf::Event event;
         while (window.pollEvent(event)) {
             if (event.type == sf::Event::Closed)
@@ -135,13 +132,14 @@ int main() {
             window.draw(circle);
         }
 
-        sf::VertexArray curve(sf::LinesStrip, numPoints);
-        for (int i = 0; i < numPoints; ++i) {
-            float t = static_cast<float>(i) / 99.0f;
-            //float t = static_cast<float>(i) / 4.0f; для 4 линий
-            sf::Vector2f point = calculateBezierPoint(t, points[0], points[1], points[2], points[3]);
-            curve[i].position = point;
-            curve[i].color = sf::Color::Blue;
+        {
+            PROFILE_ZONE("Bezier curve");
+            for (int i = 0; i < numPoints; ++i) {
+                float t = static_cast<float>(i) / 99.0f;
+                //float t = static_cast<float>(i) / 4.0f; для 4 линий
+                sf::Vector2f point = calculateBezierPoint(t, points[0], points[1], points[2], points[3]);
+                curve[i].position = point;
+            }
         }
         window.draw(curve);
 
@@ -163,14 +161,14 @@ int main() {
 
             sf::Vector2f animatedPoint = calculateBezierPoint(t, points[0], points[1], points[2], points[3]);
             animatedPoint = clampPointToWindow(animatedPoint, window);
-            sf::CircleShape animCircle(5);
             animCircle.setPosition(animatedPoint - sf::Vector2f(5, 5));
-            animCircle.setFillColor(sf::Color::Green);
             window.draw(animCircle);
         }
 
+        PROFILE_ZONE("Present");
         window.display();
     }
 
+    PROFILE_SHUTDOWN();
     return 0;
 }
\ No newline at end of file
@@ -3,7 +3,10 @@
 #include <GL/glew.h>
 #include <vector>
 #include <cmath>
+#include <future>
 #include <iostream>
+#include "../common/job_system.hpp"
+#include "../common/sphere.hpp"
 
 // Константы
 const int numSegments = 50; // Количество сегментов для сферы
@@ -12,24 +15,6 @@ float cameraDistance = 5.0f; // Начальное расстояние каме
 float cameraTheta = 0.0f;   // Угол поворота камеры по вертикали
 float cameraPhi = 0.0f;     // Угол поворота камеры по горизонтали
 
-// Функция для генерации вершин сферы
-std::vector<float> generateSphereVertices(float radius, int numSegments) {
-    std::vector<float> vertices;
-    for (int i = 0; i <= numSegments; ++i) {
-        float theta = i * M_PI / numSegments;
-        for (int j = 0; j <= numSegments; ++j) {
-            float phi = j * 2 * M_PI / numSegments;
-            float x = radius * sin(theta) * cos(phi);
-            float y = radius * sin(theta) * sin(phi);
-            float z = radius * cos(theta);
-            vertices.push_back(x);
-            vertices.push_back(y);
-            vertices.push_back(z);
-        }
-    }
-    return vertices;
-}
-
 // Функция для вычисления матрицы перспективной проекции
 void setPerspectiveProjection(float fov, float aspect, float zNear, float zFar) {
     float f = 1.0f / tan(fov / 2.0f * M_PI / 180.0f);
@@ -112,13 +97,19 @@ int main() {
         return -1;
     }
 
-    // Генерация вершин сферы
+    // Генерация вершин сферы. Буферов два: новая сфера загружается в тот, из которого
+    // GPU сейчас не читает, и кадр не ждёт окончания отрисовки предыдущего
     std::vector<float> vertices = generateSphereVertices(radius, numSegments);
-    GLuint vbo;
-    glGenBuffers(1, &vbo);
-    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+    GLuint vbos[2];
+    int frontBuffer = 0;
+    glGenBuffers(2, vbos);
+    glBindBuffer(GL_ARRAY_BUFFER, vbos[frontBuffer]);
     glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), vertices.data(), GL_STATIC_DRAW);
 
+    // Пересчёт сферы идёт в пуле потоков; пока он не готов, рисуется прежняя сфера
+    std::future<std::vector<float>> pendingVertices;
+    bool radiusChanged = false;
+
     // Включение теста глубины
     glEnable(GL_DEPTH_TEST);
 
@@ -145,16 +136,12 @@ int main() {
         }
         if (sf::Keyboard::isKeyPressed(sf::Keyboard::W)) {
             radius += 0.01f;
-            vertices = generateSphereVertices(radius, numSegments);
-            glBindBuffer(GL_ARRAY_BUFFER, vbo);
-            glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), vertices.data(), GL_STATIC_DRAW);
+            radiusChanged = true;
         }
         if (sf::Keyboard::isKeyPressed(sf::Keyboard::S)) {
             radius -= 0.01f;
             if (radius < 0.01f) radius = 0.01f;
-            vertices = generateSphereVertices(radius, numSegments);
-            glBindBuffer(GL_ARRAY_BUFFER, vbo);
-            glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), vertices.data(), GL_STATIC_DRAW);
+            radiusChanged = true;
         }
         if (sf::Keyboard::isKeyPressed(sf::Keyboard::A)) {
             cameraDistance -= 0.05f;
@@ -163,6 +150,19 @@ int main() {
             cameraDistance += 0.05f;
         }
 
+        // Готовая сфера загружается во второй буфер и становится текущей
+        if (isReady(pendingVertices)) {
+            vertices = pendingVertices.get();
+            frontBuffer = 1 - frontBuffer;
+            glBindBuffer(GL_ARRAY_BUFFER, vbos[frontBuffer]);
+            glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), vertices.data(), GL_STATIC_DRAW);
+        }
+        // Одновременно строится одна сфера, с последним радиусом на момент запуска
+        if (radiusChanged && !pendingVertices.valid()) {
+            pendingVertices = submitJob([r = radius]() { return generateSphereVertices(r, numSegments); });
+            radiusChanged = false;
+        }
+
         // Очистка экрана
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
@@ -173,7 +173,7 @@ int main() {
         setCamera(cameraDistance, cameraTheta, cameraPhi);
 
         // Отрисовка сферы
-        glBindBuffer(GL_ARRAY_BUFFER, vbo);
+        glBindBuffer(GL_ARRAY_BUFFER, vbos[frontBuffer]);
         glVertexPointer(3, GL_FLOAT, 0, (void*)0);
         glEnableClientState(GL_VERTEX_ARRAY);
 
@@ -187,8 +187,10 @@ int main() {
         window.display();
     }
 
-    // Удаление буфера
-    glDeleteBuffers(1, &vbo);
+    // Удаление буферов
+    if (pendingVertices.valid())
+        pendingVertices.wait();
+    glDeleteBuffers(2, vbos);
 
     return 0;
 }
\ No newline at end of file
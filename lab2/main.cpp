@@ -3,10 +3,40 @@
 #include <GL/glew.h>
 #include <glm/glm.hpp>
 #include <glm/gtc/type_ptr.hpp>
+#include <algorithm>
+#include <cmath>
+#include <future>
 #include <iostream>
 #include <vector>
+#include "../common/args.hpp"
+#include "../common/dynamic_resolution.hpp"
+#include "../common/frame_pacer.hpp"
+#include "../common/gpu_memory.hpp"
+#include "../common/headless.hpp"
+#include "../common/input.hpp"
+#include "../common/job_system.hpp"
+#include "../common/perf_counters.hpp"
+#include "../common/profiler.hpp"
+#include "../common/render_thread.hpp"
+#include "../common/shader_manager.hpp"
+#include "../common/sphere.hpp"
+#include "../common/transforms.hpp"
 
 GLuint VAO, VBO, CBO, EBO;
+GLsizei sphereIndexCount = 0;
+
+// Детализация сферы: [ и ] вдвое меняют число секторов и слоёв. Новая сфера строится в пуле
+// потоков и загружается во второй комплект буферов, пока рисуется прежняя, — кадры не ждут генерации.
+struct SphereMesh {
+    std::vector<GLfloat> vertices;
+    std::vector<GLuint> indices;
+};
+GLuint backVAO, backVBO, backEBO;
+int sphereDetail = 0;
+const int minSphereDetail = -2;
+const int maxSphereDetail = 5;
+bool sphereDetailChanged = false;
+std::future<SphereMesh> pendingSphere;
 float scale = 1.0f;
 const float minScale = 0.05f;
 const float maxScale = 6.0f;
@@ -14,172 +44,36 @@ const float maxScale = 6.0f;
 glm::mat4 viewMatrix;
 glm::mat4 projectionMatrix;
 
+// Отрисовка в уменьшенный буфер под бюджет времени кадра (--frame-budget мс)
+DynamicResolution dynamicResolution;
+
+// Ограничение частоты кадров в окне (--fps, 0 — без ограничения)
+FramePacer framePacer;
+
 GLuint shaderProgram;
 
 glm::vec3 cameraPosition = glm::vec3(0.0f, 1.0f, 5.0f);
 glm::vec3 cameraTarget = glm::vec3(0.0f, 0.0f, 0.0f);
 glm::vec3 cameraUp = glm::vec3(0.0f, 1.0f, 0.0f);
-float cameraSpeed = 0.01f;
+float cameraSpeed = 2.0f; // единиц в секунду
 
 
 float yaw = -90.0f; 
 float pitch = 0.0f; 
-float rotationSpeed = 0.01f; 
-
-GLuint compileShader(const std::string& source, GLenum shaderType) {
-    GLuint shader = glCreateShader(shaderType);
-    const char* src = source.c_str();
-    glShaderSource(shader, 1, &src, nullptr);
-    glCompileShader(shader);
-
-    GLint success;
-    glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
-    if (!success) {
-        char infoLog[512];
-        glGetShaderInfoLog(shader, 512, nullptr, infoLog);
-        std::cerr << "Shader compilation error: " << infoLog << std::endl;
-    }
-    return shader;
-}
-
-
-void createShaderProgram() {
-    std::string vertexShaderSource = R"(
-        #version 330 core
-        layout(location = 0) in vec3 aPos;
-        layout(location = 1) in vec3 aColor;
-        out vec3 ourColor;
-        uniform mat4 model;
-        uniform mat4 view;
-        uniform mat4 projection;
-        void main() {
-            gl_Position = projection * view * model * vec4(aPos, 1.0);
-            ourColor = aColor;
-        }
-    )";
-
-    std::string fragmentShaderSource = R"(
-        #version 330 core
-        in vec3 ourColor;
-        out vec4 FragColor;
-        void main() {
-            FragColor = vec4(ourColor, 1.0f);
-        }
-    )";
-
-    GLuint vertexShader = compileShader(vertexShaderSource, GL_VERTEX_SHADER);
-    GLuint fragmentShader = compileShader(fragmentShaderSource, GL_FRAGMENT_SHADER);
-
-    shaderProgram = glCreateProgram();
-    glAttachShader(shaderProgram, vertexShader);
-    glAttachShader(shaderProgram, fragmentShader);
-    glLinkProgram(shaderProgram);
-
-    GLint success;
-    glGetProgramiv(shaderProgram, GL_LINK_STATUS, &success);
-    if (!success) {
-        char infoLog[512];
-        glGetProgramInfoLog(shaderProgram, 512, nullptr, infoLog);
-        std::cerr << "Shader program linking error: " << infoLog << std::endl;
-    }
-
-    glDeleteShader(vertexShader);
-    glDeleteShader(fragmentShader);
-}
-
-glm::mat4 scaleMatrix(float scaleX, float scaleY, float scaleZ) {
-    glm::mat4 scale = glm::mat4(1.0f);
-    scale[0][0] = scaleX;
-    scale[1][1] = scaleY;
-    scale[2][2] = scaleZ;
-    return scale;
-}
-
-glm::mat4 translateMatrix(const glm::vec3& translation) {
-    glm::mat4 translationMatrix = glm::mat4(1.0f);
-    translationMatrix[3][0] = translation.x;
-    translationMatrix[3][1] = translation.y;
-    translationMatrix[3][2] = translation.z;
-    return translationMatrix;
-}
-
-glm::mat4 lookAt(const glm::vec3& eye, const glm::vec3& target, const glm::vec3& up) {
-    glm::vec3 forward = glm::normalize(target - eye);
-    glm::vec3 right = glm::normalize(glm::cross(forward, up));
-    glm::vec3 newUp = glm::cross(right, forward);
-
-    glm::mat4 view = glm::mat4(1.0f);
-    view[0][0] = right.x;
-    view[1][0] = right.y;
-    view[2][0] = right.z;
-    view[0][1] = newUp.x;
-    view[1][1] = newUp.y;
-    view[2][1] = newUp.z;
-    view[0][2] = -forward.x;
-    view[1][2] = -forward.y;
-    view[2][2] = -forward.z;
-    view[3][0] = -glm::dot(right, eye);
-    view[3][1] = -glm::dot(newUp, eye);
-    view[3][2] = glm::dot(forward, eye);
-
-    return view;
-}
-
-glm::mat4 perspective(float fov, float aspect, float near, float far) {
-    float tanHalfFov = tan(fov / 2.0f);
-    glm::mat4 projection = glm::mat4(0.0f);
-    projection[0][0] = 1.0f / (aspect * tanHalfFov);
-    projection[1][1] = 1.0f / tanHalfFov;
-    projection[2][2] = -(far + near) / (far - near);
-    projection[2][3] = -1.0f;
-    projection[3][2] = -(2.0f * far * near) / (far - near);
-    return projection;
-}
+float rotationSpeed = 60.0f; // градусов в секунду
+float scaleSpeed = 0.5f; // изменение масштаба в секунду
 
 void initOpenGL() {
     glEnable(GL_DEPTH_TEST);
     glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
 
-    createShaderProgram();
+    shaderProgram = loadShaderProgram("../common/shaders/vertex_color.vert", "../common/shaders/vertex_color.frag");
 
     viewMatrix = lookAt(cameraPosition, cameraTarget, cameraUp);
     projectionMatrix = perspective(glm::radians(45.0f), 800.0f / 600.0f, 0.1f, 100.0f);
 }
 
-void processInput(sf::Window& window) {
-    if (sf::Keyboard::isKeyPressed(sf::Keyboard::R)) {
-        scale += 0.01f;
-    }
-    if (sf::Keyboard::isKeyPressed(sf::Keyboard::F)) {
-        scale -= 0.01f;
-    }
-
-    if (sf::Keyboard::isKeyPressed(sf::Keyboard::W))
-        cameraPosition += cameraSpeed * glm::normalize(cameraTarget - cameraPosition);
-    if (sf::Keyboard::isKeyPressed(sf::Keyboard::S))
-        cameraPosition -= cameraSpeed * glm::normalize(cameraTarget - cameraPosition);
-    if (sf::Keyboard::isKeyPressed(sf::Keyboard::A))
-        cameraPosition -= glm::normalize(glm::cross(cameraTarget - cameraPosition, cameraUp)) * cameraSpeed;
-    if (sf::Keyboard::isKeyPressed(sf::Keyboard::D))
-        cameraPosition += glm::normalize(glm::cross(cameraTarget - cameraPosition, cameraUp)) * cameraSpeed;
-    if (sf::Keyboard::isKeyPressed(sf::Keyboard::Q))
-        cameraPosition.y += cameraSpeed;
-    if (sf::Keyboard::isKeyPressed(sf::Keyboard::E))
-        cameraPosition.y -= cameraSpeed;
-
-    if (sf::Keyboard::isKeyPressed(sf::Keyboard::Left)) {
-        yaw -= rotationSpeed;
-    }
-    if (sf::Keyboard::isKeyPressed(sf::Keyboard::Right)) {
-        yaw += rotationSpeed;
-    }
-    if (sf::Keyboard::isKeyPressed(sf::Keyboard::Up)) {
-        pitch += rotationSpeed;
-    }
-    if (sf::Keyboard::isKeyPressed(sf::Keyboard::Down)) {
-        pitch -= rotationSpeed;
-    }
-
+void updateViewMatrix() {
     if (pitch > 89.0f)
         pitch = 89.0f;
     if (pitch < -89.0f)
@@ -192,136 +86,245 @@ void processInput(sf::Window& window) {
     cameraTarget = cameraPosition + glm::normalize(direction);
 
     viewMatrix = lookAt(cameraPosition, cameraTarget, cameraUp);
-
-    std::cout << "Current sphere scale: " << scale << std::endl;
-    std::cout << "Camera position: (" << cameraPosition.x << ", " << cameraPosition.y << ", " << cameraPosition.z << ")" << std::endl;
 }
 
-void resizeCallback(sf::Window& window, int width, int height) {
-    glViewport(0, 0, width, height);
-    projectionMatrix = perspective(glm::radians(45.0f), (float)width / (float)height, 0.1f, 100.0f);
-}
-
-void generateSphere(std::vector<GLfloat>& vertices, std::vector<GLuint>& indices, float radius, int sectorCount, int stackCount) {
-    float x, y, z, xy;
-    float nx, ny, nz;
-    float lengthInv = 1.0f / radius;
-
-    float sectorStep = 2 * M_PI / sectorCount;
-    float stackStep = M_PI / stackCount;
-    float sectorAngle, stackAngle;
-
-    for (int i = 0; i <= stackCount; ++i) {
-        stackAngle = M_PI / 2 - i * stackStep;
-        xy = radius * cosf(stackAngle);
-        z = radius * sinf(stackAngle);
-
-        for (int j = 0; j <= sectorCount; ++j) {
-            sectorAngle = j * sectorStep;
-
-            x = xy * cosf(sectorAngle);
-            y = xy * sinf(sectorAngle);
-            vertices.push_back(x);
-            vertices.push_back(y);
-            vertices.push_back(z);
-
-            nx = x * lengthInv;
-            ny = y * lengthInv;
-            nz = z * lengthInv;
-            vertices.push_back(nx);
-            vertices.push_back(ny);
-            vertices.push_back(nz);
-        }
+void processInput(float deltaTime) {
+    if (isKeyDown(sf::Keyboard::R)) {
+        scale += scaleSpeed * deltaTime;
+    }
+    if (isKeyDown(sf::Keyboard::F)) {
+        scale -= scaleSpeed * deltaTime;
     }
 
-    int k1, k2;
-    for (int i = 0; i < stackCount; ++i) {
-        k1 = i * (sectorCount + 1);
-        k2 = k1 + sectorCount + 1;
-
-        for (int j = 0; j < sectorCount; ++j, ++k1, ++k2) {
-            if (i != 0) {
-                indices.push_back(k1);
-                indices.push_back(k2);
-                indices.push_back(k1 + 1);
-            }
-
-            if (i != (stackCount - 1)) {
-                indices.push_back(k1 + 1);
-                indices.push_back(k2);
-                indices.push_back(k2 + 1);
-            }
-        }
+    if (isKeyDown(sf::Keyboard::W))
+        cameraPosition += cameraSpeed * deltaTime * glm::normalize(cameraTarget - cameraPosition);
+    if (isKeyDown(sf::Keyboard::S))
+        cameraPosition -= cameraSpeed * deltaTime * glm::normalize(cameraTarget - cameraPosition);
+    if (isKeyDown(sf::Keyboard::A))
+        cameraPosition -= glm::normalize(glm::cross(cameraTarget - cameraPosition, cameraUp)) * cameraSpeed * deltaTime;
+    if (isKeyDown(sf::Keyboard::D))
+        cameraPosition += glm::normalize(glm::cross(cameraTarget - cameraPosition, cameraUp)) * cameraSpeed * deltaTime;
+    if (isKeyDown(sf::Keyboard::Q))
+        cameraPosition.y += cameraSpeed * deltaTime;
+    if (isKeyDown(sf::Keyboard::E))
+        cameraPosition.y -= cameraSpeed * deltaTime;
+
+    if (isKeyDown(sf::Keyboard::Left)) {
+        yaw -= rotationSpeed * deltaTime;
+    }
+    if (isKeyDown(sf::Keyboard::Right)) {
+        yaw += rotationSpeed * deltaTime;
+    }
+    if (isKeyDown(sf::Keyboard::Up)) {
+        pitch += rotationSpeed * deltaTime;
+    }
+    if (isKeyDown(sf::Keyboard::Down)) {
+        pitch -= rotationSpeed * deltaTime;
     }
-}
 
-int main() {
-    sf::ContextSettings settings;
-    settings.depthBits = 24;
-    settings.stencilBits = 8;
-    settings.majorVersion = 3;
-    settings.minorVersion = 3;
+    updateViewMatrix();
 
-    sf::Window window(sf::VideoMode(800, 600), "Lab 2", sf::Style::Default, settings);
-    window.setActive(true);
+    static bool detailKeyPressed = false;
+    bool detailDown = isKeyDown(sf::Keyboard::LBracket);
+    bool detailUp = isKeyDown(sf::Keyboard::RBracket);
+    if ((detailDown || detailUp) && !detailKeyPressed) {
+        sphereDetail = std::clamp(sphereDetail + (detailUp ? 1 : -1), minSphereDetail, maxSphereDetail);
+        sphereDetailChanged = true;
+    }
+    detailKeyPressed = detailDown || detailUp;
 
-    glewInit();
-    initOpenGL();
+    std::cout << "Current sphere scale: " << scale << std::endl;
+    std::cout << "Camera position: (" << cameraPosition.x << ", " << cameraPosition.y << ", " << cameraPosition.z << ")" << std::endl;
+}
 
-    std::vector<GLfloat> sphereVertices;
-    std::vector<GLuint> sphereIndices;
-    generateSphere(sphereVertices, sphereIndices, 1.0f, 36, 18);
+void setViewport(int width, int height) {
+    glViewport(0, 0, width, height);
+    projectionMatrix = perspective(glm::radians(45.0f), (float)width / (float)height, 0.1f, 100.0f);
+    resizeDynamicResolution(dynamicResolution, width, height);
+}
 
-    glGenVertexArrays(1, &VAO);
-    glGenBuffers(1, &VBO);
-    glGenBuffers(1, &EBO);
+// Не трогает GL, поэтому может выполняться в любом потоке
+SphereMesh buildSphere(int detail) {
+    float factor = std::pow(2.0f, (float)detail);
+    SphereMesh mesh;
+    generateSphere(mesh.vertices, mesh.indices, 1.0f, std::max(3, (int)(36 * factor)), std::max(2, (int)(18 * factor)));
+    return mesh;
+}
 
-    glBindVertexArray(VAO);
+void uploadSphere(const SphereMesh& mesh, GLuint vao, GLuint vbo, GLuint ebo) {
+    PROFILE_ZONE("Upload sphere");
+    glBindVertexArray(vao);
 
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glBufferData(GL_ARRAY_BUFFER, sphereVertices.size() * sizeof(GLfloat), &sphereVertices[0], GL_STATIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+    trackedBufferData(GL_ARRAY_BUFFER, vbo, mesh.vertices.size() * sizeof(GLfloat), &mesh.vertices[0], GL_STATIC_DRAW);
     glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(GLfloat), (void*)0);
     glEnableVertexAttribArray(0);
 
     glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(GLfloat), (void*)(3 * sizeof(GLfloat)));
     glEnableVertexAttribArray(1);
 
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sphereIndices.size() * sizeof(GLuint), &sphereIndices[0], GL_STATIC_DRAW);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
+    trackedBufferData(GL_ELEMENT_ARRAY_BUFFER, ebo, mesh.indices.size() * sizeof(GLuint), &mesh.indices[0], GL_STATIC_DRAW);
+    addPerfCounter(PerfCounter::UploadedBytes, mesh.vertices.size() * sizeof(GLfloat) + mesh.indices.size() * sizeof(GLuint));
 
     glBindVertexArray(0);
+}
+
+void initSphere() {
+    genTrackedVertexArrays(1, &VAO);
+    genTrackedBuffers(1, &VBO, GpuMemoryCategory::Geometry);
+    genTrackedBuffers(1, &EBO, GpuMemoryCategory::Geometry);
+    genTrackedVertexArrays(1, &backVAO);
+    genTrackedBuffers(1, &backVBO, GpuMemoryCategory::Geometry);
+    genTrackedBuffers(1, &backEBO, GpuMemoryCategory::Geometry);
+
+    SphereMesh mesh = buildSphere(sphereDetail);
+    sphereIndexCount = mesh.indices.size();
+    uploadSphere(mesh, VAO, VBO, EBO);
+}
 
-    while (window.isOpen()) {
-        sf::Event event;
-        while (window.pollEvent(event)) {
-            if (event.type == sf::Event::Closed)
-                window.close();
-            if (event.type == sf::Event::Resized) {
-                resizeCallback(window, event.size.width, event.size.height);
-            }
-        }
+// Забирает готовую сферу и запускает следующую сборку, если детализация менялась.
+// Одновременно строится одна сфера — с последней детализацией на момент запуска.
+void updateSphere() {
+    // При воспроизведении сфера подменяется на следующем кадре после запроса, а не когда успеет
+    // задача: иначе прогоны одной записи давали бы разные кадры
+    if (isReplayingInput() && pendingSphere.valid())
+        pendingSphere.wait();
+    if (isReady(pendingSphere)) {
+        SphereMesh mesh = pendingSphere.get();
+        uploadSphere(mesh, backVAO, backVBO, backEBO);
+        std::swap(VAO, backVAO);
+        std::swap(VBO, backVBO);
+        std::swap(EBO, backEBO);
+        sphereIndexCount = mesh.indices.size();
+        std::cout << "Sphere detail: " << mesh.vertices.size() / 6 << " vertices, " << sphereIndexCount / 3 << " triangles" << std::endl;
+    }
+    if (sphereDetailChanged && !pendingSphere.valid()) {
+        pendingSphere = submitJob([detail = sphereDetail]() { return buildSphere(detail); });
+        sphereDetailChanged = false;
+    }
+}
 
-        processInput(window);
+void renderScene() {
+    PROFILE_ZONE("Render scene");
+    PROFILE_GPU_ZONE("Scene");
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    glm::mat4 modelMatrix = scaleMatrix(scale, scale, scale);
 
-        glm::mat4 modelMatrix = scaleMatrix(scale, scale, scale);
+    glUseProgram(shaderProgram);
+    glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "model"), 1, GL_FALSE, &modelMatrix[0][0]);
+    glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "view"), 1, GL_FALSE, &viewMatrix[0][0]);
+    glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "projection"), 1, GL_FALSE, &projectionMatrix[0][0]);
+
+    glBindVertexArray(VAO);
+    glDrawElements(GL_TRIANGLES, sphereIndexCount, GL_UNSIGNED_INT, 0);
+    countDraw(sphereIndexCount);
+    addPerfCounter(PerfCounter::ShaderSwitches, 1);
+    glBindVertexArray(0);
+}
+
+void applyCameraKey(const CameraKey& key) {
+    cameraPosition = key.position;
+    yaw = key.yaw;
+    pitch = key.pitch;
+    scale = key.scale;
+    updateViewMatrix();
+}
 
-        glUseProgram(shaderProgram);
-        glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "model"), 1, GL_FALSE, &modelMatrix[0][0]);
-        glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "view"), 1, GL_FALSE, &viewMatrix[0][0]);
-        glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "projection"), 1, GL_FALSE, &projectionMatrix[0][0]);
+CameraKey currentCameraKey() {
+    CameraKey key;
+    key.position = cameraPosition;
+    key.yaw = yaw;
+    key.pitch = pitch;
+    key.scale = scale;
+    return key;
+}
 
-        glBindVertexArray(VAO);
-        glDrawElements(GL_TRIANGLES, sphereIndices.size(), GL_UNSIGNED_INT, 0);
-        glBindVertexArray(0);
+// Кадр ввода: клавиатура или запись (--replay), затем камера уходит в запись или сверяется с ней
+void stepInput(float wallTime, float wallDelta) {
+    beginInputFrame(wallTime);
+    processInput(inputDeltaTime(wallDelta));
+    endInputFrame(currentCameraKey());
+}
 
-        window.display();
+int main(int argc, char** argv) {
+    PROFILE_INIT(argc, argv);
+    initPerfCounters();
+    HeadlessOptions headless;
+    if (!parseHeadlessArgs(argc, argv, headless) || !initInput(argc, argv))
+        return 1;
+    setShaderHotReload(hasArg(argc, argv, "--hot-reload"));
+    dynamicResolution.targetMs = (float)std::atof(getArg(argc, argv, "--frame-budget", "0").c_str());
+    dynamicResolution.enabled = dynamicResolution.targetMs > 0.0f;
+    framePacer.targetFps = (float)std::atof(getArg(argc, argv, "--fps", "60").c_str());
+
+    if (headless.enabled) {
+        int result = runHeadless(headless,
+            [](int width, int height) {
+                initOpenGL();
+                initDynamicResolution(dynamicResolution, width, height);
+                initSphere();
+                setViewport(width, height);
+            },
+            [](const CameraKey& key) {
+                // Тот же порядок, что в окне: готовая сфера подменяется до ввода кадра
+                updateSphere();
+                if (isReplayingInput())
+                    stepInput(key.time, inputTimestep);
+                else
+                    applyCameraKey(key);
+                beginDynamicResolutionFrame(dynamicResolution);
+                renderScene();
+                endDynamicResolutionFrame(dynamicResolution);
+            });
+        finishInput();
+        PROFILE_SHUTDOWN();
+        destroyPerfCounters();
+        return result;
     }
 
-    glDeleteVertexArrays(1, &VAO);
-    glDeleteBuffers(1, &VBO);
-    glDeleteBuffers(1, &EBO);
+    sf::ContextSettings settings;
+    settings.depthBits = 24;
+    settings.stencilBits = 8;
+    settings.majorVersion = 3;
+    settings.minorVersion = 3;
+
+    sf::Window window(sf::VideoMode(800, 600), "Lab 2", sf::Style::Default, settings);
+    RenderLoop loop;
+    loop.init = []() {
+        initOpenGL();
+        initDynamicResolution(dynamicResolution, 800, 600);
+        initSphere();
+    };
+    loop.resize = setViewport;
+    loop.update = []() {
+        reloadChangedShaders();
+        updateSphere();
+    };
+    loop.stepInput = stepInput;
+    loop.render = []() {
+        beginDynamicResolutionFrame(dynamicResolution);
+        renderScene();
+        endDynamicResolutionFrame(dynamicResolution);
+    };
+    loop.shutdown = []() {
+        if (pendingSphere.valid())
+            pendingSphere.wait();
+        deleteTrackedVertexArrays(1, &VAO);
+        deleteTrackedBuffers(1, &VBO);
+        deleteTrackedBuffers(1, &EBO);
+        deleteTrackedVertexArrays(1, &backVAO);
+        deleteTrackedBuffers(1, &backVBO);
+        deleteTrackedBuffers(1, &backEBO);
+        destroyDynamicResolution(dynamicResolution);
+        deleteShaderPrograms();
+    };
+
+    runRenderThread(window, framePacer, loop);
+    finishInput();
+    PROFILE_SHUTDOWN();
+    destroyPerfCounters();
 
     return 0;
 }
\ No newline at end of file
@@ -4,6 +4,18 @@
 #include <glm/glm.hpp>
 #include <iostream>
 #include <string>
+#include "../common/args.hpp"
+#include "../common/dynamic_resolution.hpp"
+#include "../common/frame_pacer.hpp"
+#include "../common/gpu_memory.hpp"
+#include "../common/headless.hpp"
+#include "../common/input.hpp"
+#include "../common/mesh_loader.hpp"
+#include "../common/perf_counters.hpp"
+#include "../common/profiler.hpp"
+#include "../common/render_thread.hpp"
+#include "../common/shader_manager.hpp"
+#include "../common/transforms.hpp"
 
 const GLfloat pyramidVertices[] = {
     -1.0f, -1.0f, -1.0f, 
@@ -31,6 +43,12 @@ const GLuint pyramidIndices[] = {
 };
 
 GLuint VAO, VBO, CBO, EBO;
+
+// Модель из файла (--mesh) вместо пирамиды, цвет вершины берётся из нормали
+MeshData modelMesh;
+bool meshLoaded = false;
+GLuint meshVAO, meshVBO, meshEBO;
+glm::mat4 meshFit = glm::mat4(1.0f);
 float scale = 1.0f;
 const float minScale = 0.05f;
 const float maxScale = 6.0f;
@@ -38,180 +56,50 @@ const float maxScale = 6.0f;
 glm::mat4 viewMatrix;
 glm::mat4 projectionMatrix;
 
+// Отрисовка в уменьшенный буфер под бюджет времени кадра (--frame-budget мс)
+DynamicResolution dynamicResolution;
+
+// Ограничение частоты кадров в окне (--fps, 0 — без ограничения)
+FramePacer framePacer;
+
 GLuint shaderProgram;
 
 glm::vec3 cameraPosition = glm::vec3(0.0f, 1.0f, 5.0f);
 glm::vec3 cameraTarget = glm::vec3(0.0f, 0.0f, 0.0f);
 glm::vec3 cameraUp = glm::vec3(0.0f, 1.0f, 0.0f);
-float cameraSpeed = 0.01f;
+float cameraSpeed = 2.0f; // единиц в секунду
 
 float yaw = -90.0f; 
 float pitch = 0.0f; 
-float rotationSpeed = 0.01f; 
-
-GLuint compileShader(const std::string& source, GLenum shaderType) {
-    GLuint shader = glCreateShader(shaderType);
-    const char* src = source.c_str();
-    glShaderSource(shader, 1, &src, nullptr);
-    glCompileShader(shader);
-
-    GLint success;
-    glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
-    if (!success) {
-        char infoLog[512];
-        glGetShaderInfoLog(shader, 512, nullptr, infoLog);
-        std::cerr << "Shader compilation error: " << infoLog << std::endl;
-    }
-    return shader;
-}
-
-
-void createShaderProgram() {
-    std::string vertexShaderSource = R"(
-        #version 330 core
-        layout(location = 0) in vec3 aPos;
-        layout(location = 1) in vec3 aColor;
-        out vec3 ourColor;
-        uniform mat4 model;
-        uniform mat4 view;
-        uniform mat4 projection;
-        void main() {
-            gl_Position = projection * view * model * vec4(aPos, 1.0);
-            ourColor = aColor;
-        }
-    )";
-
-    std::string fragmentShaderSource = R"(
-        #version 330 core
-        in vec3 ourColor;
-        out vec4 FragColor;
-        void main() {
-            FragColor = vec4(ourColor, 1.0f);
-        }
-    )";
-
-    GLuint vertexShader = compileShader(vertexShaderSource, GL_VERTEX_SHADER);
-    GLuint fragmentShader = compileShader(fragmentShaderSource, GL_FRAGMENT_SHADER);
-
-    shaderProgram = glCreateProgram();
-    glAttachShader(shaderProgram, vertexShader);
-    glAttachShader(shaderProgram, fragmentShader);
-    glLinkProgram(shaderProgram);
-
-    GLint success;
-    glGetProgramiv(shaderProgram, GL_LINK_STATUS, &success);
-    if (!success) {
-        char infoLog[512];
-        glGetProgramInfoLog(shaderProgram, 512, nullptr, infoLog);
-        std::cerr << "Shader program linking error: " << infoLog << std::endl;
-    }
-
-    glDeleteShader(vertexShader);
-    glDeleteShader(fragmentShader);
-}
-
-glm::mat4 scaleMatrix(float scaleX, float scaleY, float scaleZ) {
-    glm::mat4 scale = glm::mat4(1.0f);
-    scale[0][0] = scaleX;
-    scale[1][1] = scaleY;
-    scale[2][2] = scaleZ;
-    return scale;
-}
-
-glm::mat4 translateMatrix(const glm::vec3& translation) {
-    glm::mat4 translationMatrix = glm::mat4(1.0f);
-    translationMatrix[3][0] = translation.x;
-    translationMatrix[3][1] = translation.y;
-    translationMatrix[3][2] = translation.z;
-    return translationMatrix;
-}
-
-glm::mat4 lookAt(const glm::vec3& eye, const glm::vec3& target, const glm::vec3& up) {
-    glm::vec3 forward = glm::normalize(target - eye);
-    glm::vec3 right = glm::normalize(glm::cross(forward, up));
-    glm::vec3 newUp = glm::cross(right, forward);
-
-    glm::mat4 view = glm::mat4(1.0f);
-    view[0][0] = right.x;
-    view[1][0] = right.y;
-    view[2][0] = right.z;
-    view[0][1] = newUp.x;
-    view[1][1] = newUp.y;
-    view[2][1] = newUp.z;
-    view[0][2] = -forward.x;
-    view[1][2] = -forward.y;
-    view[2][2] = -forward.z;
-    view[3][0] = -glm::dot(right, eye);
-    view[3][1] = -glm::dot(newUp, eye);
-    view[3][2] = glm::dot(forward, eye);
-
-    return view;
-}
-
-glm::mat4 perspective(float fov, float aspect, float near, float far) {
-    float tanHalfFov = tan(fov / 2.0f);
-    glm::mat4 projection = glm::mat4(0.0f);
-    projection[0][0] = 1.0f / (aspect * tanHalfFov);
-    projection[1][1] = 1.0f / tanHalfFov;
-    projection[2][2] = -(far + near) / (far - near);
-    projection[2][3] = -1.0f;
-    projection[3][2] = -(2.0f * far * near) / (far - near);
-    return projection;
-}
+float rotationSpeed = 60.0f; // градусов в секунду
+float scaleSpeed = 0.5f; // изменение масштаба в секунду
 
 void initOpenGL() {
     glEnable(GL_DEPTH_TEST);
     glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
 
-    createShaderProgram();
+    shaderProgram = loadShaderProgram("../common/shaders/vertex_color.vert", "../common/shaders/vertex_color.frag");
 
     viewMatrix = lookAt(cameraPosition, cameraTarget, cameraUp);
     projectionMatrix = perspective(glm::radians(45.0f), 800.0f / 600.0f, 0.1f, 100.0f);
 }
 
 void drawPyramid() {
+    if (meshLoaded) {
+        glBindVertexArray(meshVAO);
+        glDrawElements(GL_TRIANGLES, (GLsizei)modelMesh.indices.size(), GL_UNSIGNED_INT, 0);
+        countDraw(modelMesh.indices.size());
+        glBindVertexArray(0);
+        return;
+    }
+
     glBindVertexArray(VAO);
     glDrawElements(GL_TRIANGLES, 18, GL_UNSIGNED_INT, 0);
-    glDrawElements(GL_TRIANGLES, 15, GL_UNSIGNED_INT, 0);
+    countDraw(18);
     glBindVertexArray(0);
 }
 
-void processInput(sf::Window& window) {
-    if (sf::Keyboard::isKeyPressed(sf::Keyboard::R)) {
-        scale += 0.01f;
-        scale = std::min(scale, maxScale);
-    }
-    if (sf::Keyboard::isKeyPressed(sf::Keyboard::F)) {
-        scale -= 0.01f;
-        scale = std::max(scale, minScale);
-    }
-
-    if (sf::Keyboard::isKeyPressed(sf::Keyboard::W))
-        cameraPosition += cameraSpeed * glm::normalize(cameraTarget - cameraPosition);
-    if (sf::Keyboard::isKeyPressed(sf::Keyboard::S))
-        cameraPosition -= cameraSpeed * glm::normalize(cameraTarget - cameraPosition);
-    if (sf::Keyboard::isKeyPressed(sf::Keyboard::A))
-        cameraPosition -= glm::normalize(glm::cross(cameraTarget - cameraPosition, cameraUp)) * cameraSpeed;
-    if (sf::Keyboard::isKeyPressed(sf::Keyboard::D))
-        cameraPosition += glm::normalize(glm::cross(cameraTarget - cameraPosition, cameraUp)) * cameraSpeed;
-    if (sf::Keyboard::isKeyPressed(sf::Keyboard::Q))
-        cameraPosition.y += cameraSpeed;
-    if (sf::Keyboard::isKeyPressed(sf::Keyboard::E))
-        cameraPosition.y -= cameraSpeed;
-
-    if (sf::Keyboard::isKeyPressed(sf::Keyboard::Left)) {
-        yaw -= rotationSpeed;
-    }
-    if (sf::Keyboard::isKeyPressed(sf::Keyboard::Right)) {
-        yaw += rotationSpeed;
-    }
-    if (sf::Keyboard::isKeyPressed(sf::Keyboard::Up)) {
-        pitch += rotationSpeed;
-    }
-    if (sf::Keyboard::isKeyPressed(sf::Keyboard::Down)) {
-        pitch -= rotationSpeed;
-    }
-
+void updateViewMatrix() {
     if (pitch > 89.0f)
         pitch = 89.0f;
     if (pitch < -89.0f)
@@ -224,81 +112,241 @@ void processInput(sf::Window& window) {
     cameraTarget = cameraPosition + glm::normalize(direction);
 
     viewMatrix = lookAt(cameraPosition, cameraTarget, cameraUp);
+}
+
+void processInput(float deltaTime) {
+    if (isKeyDown(sf::Keyboard::R)) {
+        scale += scaleSpeed * deltaTime;
+        scale = std::min(scale, maxScale);
+    }
+    if (isKeyDown(sf::Keyboard::F)) {
+        scale -= scaleSpeed * deltaTime;
+        scale = std::max(scale, minScale);
+    }
+
+    if (isKeyDown(sf::Keyboard::W))
+        cameraPosition += cameraSpeed * deltaTime * glm::normalize(cameraTarget - cameraPosition);
+    if (isKeyDown(sf::Keyboard::S))
+        cameraPosition -= cameraSpeed * deltaTime * glm::normalize(cameraTarget - cameraPosition);
+    if (isKeyDown(sf::Keyboard::A))
+        cameraPosition -= glm::normalize(glm::cross(cameraTarget - cameraPosition, cameraUp)) * cameraSpeed * deltaTime;
+    if (isKeyDown(sf::Keyboard::D))
+        cameraPosition += glm::normalize(glm::cross(cameraTarget - cameraPosition, cameraUp)) * cameraSpeed * deltaTime;
+    if (isKeyDown(sf::Keyboard::Q))
+        cameraPosition.y += cameraSpeed * deltaTime;
+    if (isKeyDown(sf::Keyboard::E))
+        cameraPosition.y -= cameraSpeed * deltaTime;
+
+    if (isKeyDown(sf::Keyboard::Left)) {
+        yaw -= rotationSpeed * deltaTime;
+    }
+    if (isKeyDown(sf::Keyboard::Right)) {
+        yaw += rotationSpeed * deltaTime;
+    }
+    if (isKeyDown(sf::Keyboard::Up)) {
+        pitch += rotationSpeed * deltaTime;
+    }
+    if (isKeyDown(sf::Keyboard::Down)) {
+        pitch -= rotationSpeed * deltaTime;
+    }
+
+    updateViewMatrix();
 
     std::cout << "Current pyramid scale: " << scale << std::endl;
     std::cout << "Camera position: (" << cameraPosition.x << ", " << cameraPosition.y << ", " << cameraPosition.z << ")" << std::endl;
 }
 
-void resizeCallback(sf::Window& window, int width, int height) {
+void setViewport(int width, int height) {
     glViewport(0, 0, width, height);
     projectionMatrix = perspective(glm::radians(45.0f), (float)width / (float)height, 0.1f, 100.0f);
+    resizeDynamicResolution(dynamicResolution, width, height);
 }
 
-int main() {
-    sf::ContextSettings settings;
-    settings.depthBits = 24;
-    settings.stencilBits = 8;
-    settings.majorVersion = 3;
-    settings.minorVersion = 3;
-
-    sf::Window window(sf::VideoMode(800, 600), "Lab 3", sf::Style::Default, settings);
-    window.setActive(true);
-
-    glewInit();
-    initOpenGL();
-
-    glGenVertexArrays(1, &VAO);
-    glGenBuffers(1, &VBO);
-    glGenBuffers(1, &CBO);
-    glGenBuffers(1, &EBO);
+void initPyramid() {
+    genTrackedVertexArrays(1, &VAO);
+    genTrackedBuffers(1, &VBO, GpuMemoryCategory::Geometry);
+    genTrackedBuffers(1, &CBO, GpuMemoryCategory::Geometry);
+    genTrackedBuffers(1, &EBO, GpuMemoryCategory::Geometry);
 
     glBindVertexArray(VAO);
 
     glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(pyramidVertices), pyramidVertices, GL_STATIC_DRAW);
+    trackedBufferData(GL_ARRAY_BUFFER, VBO, sizeof(pyramidVertices), pyramidVertices, GL_STATIC_DRAW);
     glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(GLfloat), (void*)0);
     glEnableVertexAttribArray(0);
 
     glBindBuffer(GL_ARRAY_BUFFER, CBO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(pyramidColors), pyramidColors, GL_STATIC_DRAW);
+    trackedBufferData(GL_ARRAY_BUFFER, CBO, sizeof(pyramidColors), pyramidColors, GL_STATIC_DRAW);
     glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(GLfloat), (void*)0);
     glEnableVertexAttribArray(1);
 
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(pyramidIndices), pyramidIndices, GL_STATIC_DRAW);
+    trackedBufferData(GL_ELEMENT_ARRAY_BUFFER, EBO, sizeof(pyramidIndices), pyramidIndices, GL_STATIC_DRAW);
+    addPerfCounter(PerfCounter::UploadedBytes, sizeof(pyramidVertices) + sizeof(pyramidColors) + sizeof(pyramidIndices));
 
     glBindVertexArray(0);
+}
 
-    while (window.isOpen()) {
-        sf::Event event;
-        while (window.pollEvent(event)) {
-            if (event.type == sf::Event::Closed)
-                window.close();
-            if (event.type == sf::Event::Resized) {
-                resizeCallback(window, event.size.width, event.size.height);
-            }
-        }
+bool loadModelMesh(const std::string& path) {
+    if (!loadMesh(path, modelMesh))
+        return false;
+    meshLoaded = true;
+    meshFit = meshFitMatrix(modelMesh);
+    std::cout << "Loaded " << path << ": " << modelMesh.vertices.size() / meshVertexFloats << " vertices, "
+              << modelMesh.indices.size() / 3 << " triangles" << std::endl;
+
+    // Нормаль [-1, 1] -> цвет [0, 1] на месте второго атрибута
+    for (size_t i = 0; i < modelMesh.vertices.size(); i += meshVertexFloats) {
+        for (int k = 3; k < 6; ++k)
+            modelMesh.vertices[i + k] = modelMesh.vertices[i + k] * 0.5f + 0.5f;
+    }
+    return true;
+}
+
+void initMesh() {
+    if (!meshLoaded)
+        return;
+
+    genTrackedVertexArrays(1, &meshVAO);
+    genTrackedBuffers(1, &meshVBO, GpuMemoryCategory::Geometry);
+    genTrackedBuffers(1, &meshEBO, GpuMemoryCategory::Geometry);
+
+    glBindVertexArray(meshVAO);
+
+    glBindBuffer(GL_ARRAY_BUFFER, meshVBO);
+    trackedBufferData(GL_ARRAY_BUFFER, meshVBO, modelMesh.vertices.size() * sizeof(GLfloat), modelMesh.vertices.data(), GL_STATIC_DRAW);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, meshVertexFloats * sizeof(GLfloat), (void*)0);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, meshVertexFloats * sizeof(GLfloat), (void*)(3 * sizeof(GLfloat)));
+    glEnableVertexAttribArray(1);
+
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, meshEBO);
+    trackedBufferData(GL_ELEMENT_ARRAY_BUFFER, meshEBO, modelMesh.indices.size() * sizeof(GLuint), modelMesh.indices.data(), GL_STATIC_DRAW);
+    addPerfCounter(PerfCounter::UploadedBytes, modelMesh.vertices.size() * sizeof(GLfloat) + modelMesh.indices.size() * sizeof(GLuint));
+
+    glBindVertexArray(0);
+}
+
+void renderScene() {
+    PROFILE_ZONE("Render scene");
+    PROFILE_GPU_ZONE("Scene");
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-        processInput(window);
+    glm::mat4 modelMatrix = scaleMatrix(scale, scale, scale) * meshFit;
 
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    glUseProgram(shaderProgram);
+    glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "model"), 1, GL_FALSE, &modelMatrix[0][0]);
+    glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "view"), 1, GL_FALSE, &viewMatrix[0][0]);
+    glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "projection"), 1, GL_FALSE, &projectionMatrix[0][0]);
 
-        glm::mat4 modelMatrix = scaleMatrix(scale, scale, scale);
+    addPerfCounter(PerfCounter::ShaderSwitches, 1);
+    drawPyramid();
+}
+
+void applyCameraKey(const CameraKey& key) {
+    cameraPosition = key.position;
+    yaw = key.yaw;
+    pitch = key.pitch;
+    scale = key.scale;
+    updateViewMatrix();
+}
 
-        glUseProgram(shaderProgram);
-        glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "model"), 1, GL_FALSE, &modelMatrix[0][0]);
-        glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "view"), 1, GL_FALSE, &viewMatrix[0][0]);
-        glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "projection"), 1, GL_FALSE, &projectionMatrix[0][0]);
+CameraKey currentCameraKey() {
+    CameraKey key;
+    key.position = cameraPosition;
+    key.yaw = yaw;
+    key.pitch = pitch;
+    key.scale = scale;
+    return key;
+}
 
-        drawPyramid();
+// Кадр ввода: клавиатура или запись (--replay), затем камера уходит в запись или сверяется с ней
+void stepInput(float wallTime, float wallDelta) {
+    beginInputFrame(wallTime);
+    processInput(inputDeltaTime(wallDelta));
+    endInputFrame(currentCameraKey());
+}
 
-        window.display();
+int main(int argc, char** argv) {
+    PROFILE_INIT(argc, argv);
+    initPerfCounters();
+    HeadlessOptions headless;
+    if (!parseHeadlessArgs(argc, argv, headless) || !initInput(argc, argv))
+        return 1;
+    setShaderHotReload(hasArg(argc, argv, "--hot-reload"));
+    dynamicResolution.targetMs = (float)std::atof(getArg(argc, argv, "--frame-budget", "0").c_str());
+    dynamicResolution.enabled = dynamicResolution.targetMs > 0.0f;
+    framePacer.targetFps = (float)std::atof(getArg(argc, argv, "--fps", "60").c_str());
+    std::string meshPath = getArg(argc, argv, "--mesh", "");
+    if (!meshPath.empty() && !loadModelMesh(meshPath))
+        return 1;
+
+    if (headless.enabled) {
+        int result = runHeadless(headless,
+            [](int width, int height) {
+                initOpenGL();
+                initDynamicResolution(dynamicResolution, width, height);
+                initPyramid();
+                initMesh();
+                setViewport(width, height);
+            },
+            [](const CameraKey& key) {
+                if (isReplayingInput())
+                    stepInput(key.time, inputTimestep);
+                else
+                    applyCameraKey(key);
+                beginDynamicResolutionFrame(dynamicResolution);
+                renderScene();
+                endDynamicResolutionFrame(dynamicResolution);
+            });
+        finishInput();
+        PROFILE_SHUTDOWN();
+        destroyPerfCounters();
+        return result;
     }
 
-    glDeleteVertexArrays(1, &VAO);
-    glDeleteBuffers(1, &VBO);
-    glDeleteBuffers(1, &CBO);
-    glDeleteBuffers(1, &EBO);
+    sf::ContextSettings settings;
+    settings.depthBits = 24;
+    settings.stencilBits = 8;
+    settings.majorVersion = 3;
+    settings.minorVersion = 3;
+
+    sf::Window window(sf::VideoMode(800, 600), "Lab 3", sf::Style::Default, settings);
+    RenderLoop loop;
+    loop.init = []() {
+        initOpenGL();
+        initDynamicResolution(dynamicResolution, 800, 600);
+        initPyramid();
+        initMesh();
+    };
+    loop.resize = setViewport;
+    loop.update = []() {
+        reloadChangedShaders();
+    };
+    loop.stepInput = stepInput;
+    loop.render = []() {
+        beginDynamicResolutionFrame(dynamicResolution);
+        renderScene();
+        endDynamicResolutionFrame(dynamicResolution);
+    };
+    loop.shutdown = []() {
+        deleteTrackedVertexArrays(1, &VAO);
+        deleteTrackedBuffers(1, &VBO);
+        deleteTrackedBuffers(1, &CBO);
+        deleteTrackedBuffers(1, &EBO);
+        if (meshLoaded) {
+            deleteTrackedVertexArrays(1, &meshVAO);
+            deleteTrackedBuffers(1, &meshVBO);
+            deleteTrackedBuffers(1, &meshEBO);
+        }
+        destroyDynamicResolution(dynamicResolution);
+        deleteShaderPrograms();
+    };
+
+    runRenderThread(window, framePacer, loop);
+    finishInput();
+    PROFILE_SHUTDOWN();
+    destroyPerfCounters();
 
     return 0;
 }
\ No newline at end of file
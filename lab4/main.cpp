@@ -3,8 +3,37 @@
 #include <GL/glew.h>
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
+#include <algorithm>
+#include <chrono>
 #include <iostream>
+#include <random>
 #include <string>
+#include <vector>
+#include "../common/args.hpp"
+#include "../common/bvh.hpp"
+#include "../common/clustered_lights.hpp"
+#include "../common/command_buffer.hpp"
+#include "../common/deferred_renderer.hpp"
+#include "../common/dynamic_resolution.hpp"
+#include "../common/frame_arena.hpp"
+#include "../common/frame_pacer.hpp"
+#include "../common/frustum.hpp"
+#include "../common/gpu_memory.hpp"
+#include "../common/headless.hpp"
+#include "../common/input.hpp"
+#include "../common/light_bake.hpp"
+#include "../common/mesh_buffer.hpp"
+#include "../common/mesh_loader.hpp"
+#include "../common/normals.hpp"
+#include "../common/perf_counters.hpp"
+#include "../common/profiler.hpp"
+#include "../common/provoking_vertex.hpp"
+#include "../common/render_queue.hpp"
+#include "../common/render_thread.hpp"
+#include "../common/scene_graph.hpp"
+#include "../common/shader_manager.hpp"
+#include "../common/shader_permutations.hpp"
+#include "../common/transforms.hpp"
 
 const GLfloat cubeVertices[] = {
     // Front face
@@ -81,361 +110,1079 @@ const GLuint cubeIndices[] = {
     20, 21, 22, 22, 23, 20  // Bottom
 };
 
-GLuint VAO, VBO, NBO, EBO;
+// Тот же куб без дублирования вершин: нормали граней раздаются провоцирующим вершинам
+const GLfloat cubeCorners[] = {
+    -1.0f, -1.0f,  1.0f,
+     1.0f, -1.0f,  1.0f,
+     1.0f,  1.0f,  1.0f,
+    -1.0f,  1.0f,  1.0f,
+    -1.0f, -1.0f, -1.0f,
+     1.0f, -1.0f, -1.0f,
+     1.0f,  1.0f, -1.0f,
+    -1.0f,  1.0f, -1.0f,
+};
+
+const GLuint cubeCornerIndices[] = {
+    0, 1, 2, 2, 3, 0,   // Front
+    5, 4, 7, 7, 6, 5,   // Back
+    1, 5, 6, 6, 2, 1,   // Right
+    4, 0, 3, 3, 7, 4,   // Left
+    3, 2, 6, 6, 7, 3,   // Top
+    4, 5, 1, 1, 0, 4    // Bottom
+};
+
+// Все варианты модели лежат в одном буфере вершин и индексов с общим VAO
+MeshBuffer meshBuffer;
+uint32_t cubeMeshId, sharedMeshId, facetedMeshId, smoothMeshId;
+
+// Модель из файла (--mesh) вместо куба
+MeshData modelMesh;     // гладкий вариант для Гуро
+MeshData facetedMesh;   // плоские грани для плоского затенения
+MeshData meshTopology;  // вершины, слитые по позиции: из неё строятся оба варианта
+bool meshLoaded = false;
+float creaseAngle = -1.0f; // порог разделения нормалей в градусах (--crease), <0 — нормали из файла
+const float creaseStep = 15.0f;
+glm::mat4 meshFit = glm::mat4(1.0f);
 float scale = 1.0f;
 const float minScale = 0.05f;
 const float maxScale = 6.0f;
 
 glm::mat4 viewMatrix;
 glm::mat4 projectionMatrix;
-
-GLuint flatShaderProgram, gouraudShaderProgram;
+int viewportWidth = 800;
+int viewportHeight = 600;
+
+// Отрисовка в уменьшенный буфер под бюджет времени кадра (--frame-budget мс)
+DynamicResolution dynamicResolution;
+
+// Ограничение частоты кадров в окне (--fps, 0 — без ограничения)
+FramePacer framePacer;
+const float farPlane = 100.0f;
+
+// Биты ключа перестановки шейдера освещения
+const uint32_t SHADING_GOURAUD_BIT = 1u << 0;
+const uint32_t LIGHT_DIRECTIONAL_BIT = 1u << 1;
+const uint32_t LIGHTING_CLUSTERED_BIT = 1u << 2;
+const uint32_t DEFERRED_GEOMETRY_BIT = 1u << 3;
+const uint32_t DEFERRED_LIGHTING_BIT = 1u << 4;
+const uint32_t SHADING_PROVOKING_BIT = 1u << 5;
+const uint32_t SHADING_UNLIT_BIT = 1u << 6;
+const uint32_t MULTI_DRAW_BIT = 1u << 7;
+const uint32_t LIGHT_COUNT_MASK = 0xffu << 8;
+const uint32_t DEPTH_ONLY_BIT = 1u << 16;
+const uint32_t DEPTH_PREPASS_BIT = 1u << 17;
+const uint32_t OVERDRAW_BIT = 1u << 18;
+
+ShaderPermutationSet lightingShaders = {
+    "shaders/lighting.glsl", "shaders/lighting.glsl",
+    {
+        { "SHADING_GOURAUD", SHADING_GOURAUD_BIT },
+        { "LIGHT_DIRECTIONAL", LIGHT_DIRECTIONAL_BIT },
+        { "LIGHTING_CLUSTERED", LIGHTING_CLUSTERED_BIT },
+        { "DEFERRED_GEOMETRY", DEFERRED_GEOMETRY_BIT },
+        { "DEFERRED_LIGHTING", DEFERRED_LIGHTING_BIT },
+        { "SHADING_PROVOKING", SHADING_PROVOKING_BIT },
+        { "SHADING_UNLIT", SHADING_UNLIT_BIT },
+        { "MULTI_DRAW", MULTI_DRAW_BIT },
+        { "LIGHT_COUNT", LIGHT_COUNT_MASK },
+        { "DEPTH_ONLY", DEPTH_ONLY_BIT },
+        { "DEPTH_PREPASS", DEPTH_PREPASS_BIT },
+        { "OVERDRAW", OVERDRAW_BIT },
+    },
+    {}
+};
 GLuint currentShaderProgram;
+GLuint geometryShaderProgram; // геометрический проход отложенного освещения
+GLuint alternateShaderProgram, alternateGeometryProgram; // противоположное затенение для клеток сетки
+GLuint depthShaderProgram; // предварительный проход глубины
 
 glm::vec3 cameraPosition = glm::vec3(0.0f, 1.0f, 5.0f);
 glm::vec3 cameraTarget = glm::vec3(0.0f, 0.0f, 0.0f);
 glm::vec3 cameraUp = glm::vec3(0.0f, 1.0f, 0.0f);
-float cameraSpeed = 0.01f;
+float cameraSpeed = 2.0f; // единиц в секунду
 
 float yaw = -90.0f; 
 float pitch = 0.0f; 
-float rotationSpeed = 0.01f; 
+float rotationSpeed = 60.0f; // градусов в секунду
+float scaleSpeed = 0.5f; // изменение масштаба в секунду
 
 bool flatShading = true; // Флаг для переключения между плоским и гладким затенением
+bool provokingVertexShading = false; // Плоское затенение на кубе из 8 вершин через flat-нормали
+bool directionalLights = false; // Точечные источники или направленные (из начала координат на источник)
 
-GLuint compileShader(const std::string& source, GLenum shaderType) {
-    GLuint shader = glCreateShader(shaderType);
-    const char* src = source.c_str();
-    glShaderSource(shader, 1, &src, nullptr);
-    glCompileShader(shader);
+std::vector<glm::vec3> lights = {
+    glm::vec3(1.5f, 2.0f, 3.0f),
+    glm::vec3(-1.5f, 2.0f, -3.0f),
+};
 
-    GLint success;
-    glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
-    if (!success) {
-        char infoLog[512];
-        glGetShaderInfoLog(shader, 512, nullptr, infoLog);
-        std::cerr << "Shader compilation error: " << infoLog << std::endl;
-    }
-    return shader;
+// Кластерное освещение: много движущихся точечных источников
+bool clusteredLighting = false;
+int pointLightCount = 1024;
+std::vector<PointLight> pointLights;
+std::vector<glm::vec4> pointLightOrbits; // радиус орбиты, высота, начальный угол, угловая скорость
+ClusterGrid clusterGrid;
+float sceneTime = 0.0f;
+
+// Отложенное освещение: каждый видимый пиксель освещается один раз, плоское и Гуро остаются запасными
+bool deferredShading = false;
+GBuffer gbuffer;
+
+// Предварительный проход глубины (--depth-prepass): модели сначала рисуются только в буфер
+// глубины, затем затеняются с GL_EQUAL без записи глубины. Фрагментный шейдер освещения
+// работает один раз на пиксель, а не на каждый перекрывающийся слой. Только прямой рендер.
+bool depthPrepass = false;
+
+// Карта перерисовки (--overdraw): закрашенные фрагменты складываются аддитивным смешиванием
+bool overdrawView = false;
+// Сэмплы прохода затенения (GL_SAMPLES_PASSED), запрос прошлого кадра читается без ожидания
+GLuint shadedSampleQueries[2] = {};
+int shadedSampleFrame = 0;
+bool overdrawReported = false;
+
+// Запечённое освещение: пока источники и модель неподвижны, цвета вершин считаются на CPU один раз
+bool lightBaking = false;
+
+struct BakedColors {
+    bool valid = false;
+    StaticLighting lighting; // освещение, при котором запечены цвета
+};
+BakedColors cubeBake, meshBake, facetedBake;
+// Цвета всех мешей в одном буфере параллельно вершинам meshBuffer (location 2 общего VAO)
+GLuint bakedColorBuffer = 0;
+size_t bakedColorVertices = 0;
+
+// Сетка gridSize × gridSize моделей (--grid): клетки в шахматном порядке чередуют плоское
+// затенение и Гуро, материалы тоже чередуются. Все вызовы рисования идут через очередь.
+int gridSize = 1;
+const float gridSpacing = 2.5f;
+const std::vector<glm::vec3> gridMaterials = {
+    glm::vec3(1.0f, 1.0f, 1.0f),
+    glm::vec3(1.0f, 0.55f, 0.45f),
+    glm::vec3(0.5f, 0.8f, 1.0f),
+    glm::vec3(0.6f, 1.0f, 0.5f),
+};
+RenderQueue renderQueue;
+CommandRecorder commandRecorder;
+// Граф сцены: корень, под ним клетки сетки (перенос), под каждой клеткой модель (масштаб и
+// вписывание меша). Клетки неподвижны, после первого кадра пересчитываются только узлы
+// моделей и только при смене масштаба. Сферы узлов моделей идут в отсечение.
+SceneGraph sceneGraph;
+std::vector<uint32_t> modelNodes; // узел модели клетки, в порядке клеток
+float sceneScale = -1.0f;         // масштаб, записанный в узлы моделей
+
+// Выбор мышью: луч из камеры проверяется с боксами моделей (BVH над клетками), затем с
+// треугольниками меша в координатах модели (BVH над треугольниками, один на все клетки).
+// При смене масштаба иерархия клеток подгоняется (refit) перед следующим выбором.
+Bvh sceneBvh;
+std::vector<Aabb> modelBounds; // в мировых координатах, по клеткам
+bool sceneBvhStale = true;
+Bvh meshBvh;
+Aabb meshBounds;
+const GLfloat* pickPositions = nullptr; // куб из общих вершин или слитые вершины модели
+size_t pickStride = 3;
+const GLuint* pickIndices = nullptr;
+int hoveredCell = -1;
+int selectedCell = -1;
+// Подсветка клеток: номера материалов за пределами gridMaterials
+const glm::vec3 hoverAlbedo = glm::vec3(1.0f, 1.0f, 0.6f);
+const glm::vec3 selectionAlbedo = glm::vec3(1.0f, 0.75f, 0.2f);
+// Очередь уходит пакетами glMultiDrawElementsIndirect (--multi-draw), если драйвер умеет
+bool multiDraw = false;
+IndirectDrawBuffers indirectDrawBuffers;
+size_t culledModels = 0;
+bool renderStatsReported = false;
+
+// Кластерные источники движутся каждый кадр, запекание для них бесполезно.
+// В сетке у каждой клетки своё преобразование, а цвета запекаются на меш.
+bool useBakedLighting() {
+    return lightBaking && !clusteredLighting && gridSize == 1;
+}
+
+// Гуро нужны нормали во всех вершинах, а запечённым цветам — своя вершина на каждую грань,
+// поэтому оба рисуют куб с дублированными вершинами
+bool useSharedCube(bool flat) {
+    return provokingVertexShading && (deferredShading || flat) && !useBakedLighting();
+}
+
+// Запечённые цвета рисуются прямым проходом и при включённом отложенном освещении
+bool useForwardShading() {
+    return !deferredShading || useBakedLighting();
 }
 
-void createFlatShaderProgram() {
-    std::string vertexShaderSource = R"(
-        #version 330 core
-        layout(location = 0) in vec3 aPos;
-        layout(location = 1) in vec3 aNormal;
+uint32_t lightingKey(bool flat) {
+    if (useBakedLighting())
+        return SHADING_UNLIT_BIT;
+
+    uint32_t key = 0;
+    if (deferredShading)
+        key |= DEFERRED_LIGHTING_BIT;
+    else if (!flat)
+        key |= SHADING_GOURAUD_BIT;
+    else if (useSharedCube(flat))
+        key |= SHADING_PROVOKING_BIT;
+    if (clusteredLighting)
+        return key | LIGHTING_CLUSTERED_BIT;
+
+    key |= (uint32_t)lights.size() << 8;
+    if (directionalLights)
+        key |= LIGHT_DIRECTIONAL_BIT;
+    return key;
+}
 
-        out vec3 FragPos;
-        out vec3 Normal;
+void createPointLights(int count) {
+    std::mt19937 random(42);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+    pointLights.resize(count);
+    pointLightOrbits.resize(count);
+    for (int i = 0; i < count; ++i) {
+        pointLightOrbits[i] = glm::vec4(1.8f + 4.0f * unit(random), -3.0f + 6.0f * unit(random),
+                                        6.2831853f * unit(random), 0.2f + 0.8f * unit(random));
+        pointLights[i].radius = 1.0f + 1.5f * unit(random);
+        pointLights[i].color = glm::vec3(unit(random), unit(random), unit(random)) * 0.6f;
+    }
+}
 
-        uniform mat4 model;
-        uniform mat4 view;
-        uniform mat4 projection;
+void updatePointLights(float time) {
+    for (size_t i = 0; i < pointLights.size(); ++i) {
+        const glm::vec4& orbit = pointLightOrbits[i];
+        float angle = orbit.z + orbit.w * time;
+        pointLights[i].position = glm::vec3(orbit.x * cos(angle), orbit.y, orbit.x * sin(angle));
+    }
+}
 
-        void main() {
-            FragPos = vec3(model * vec4(aPos, 1.0));
-            Normal = mat3(transpose(inverse(model))) * aNormal;
-            gl_Position = projection * view * vec4(FragPos, 1.0);
-        }
-    )";
-
-    std::string fragmentShaderSource = R"(
-        #version 330 core
-        in vec3 FragPos;
-        in vec3 Normal;
-
-        out vec4 FragColor;
-
-        uniform vec3 lightPos;
-        uniform vec3 lightPos2;
-        uniform vec3 viewPos;
-        uniform vec3 lightColor;
-
-        void main() {
-            vec3 norm = normalize(Normal);
-            vec3 lightDir = normalize(lightPos - FragPos);
-            vec3 lightDir2 = normalize(lightPos2 - FragPos);
-            float diff = max(dot(norm, lightDir), 0.0);
-            float diff2 = max(dot(norm, lightDir2), 0.0);
-            vec3 diffuse = diff * lightColor * 1.25;
-            vec3 diffuse2 = diff2 * lightColor * 1.25;
-
-            vec3 result = diffuse + diffuse2;
-            FragColor = vec4(result, 1.0f);
-        }
-    )";
+uint32_t geometryKey(bool flat) {
+    return DEFERRED_GEOMETRY_BIT | (useSharedCube(flat) ? SHADING_PROVOKING_BIT : 0);
+}
 
-    GLuint vertexShader = compileShader(vertexShaderSource, GL_VERTEX_SHADER);
-    GLuint fragmentShader = compileShader(fragmentShaderSource, GL_FRAGMENT_SHADER);
+void selectLightingShader() {
+    // Проход освещения G-буфера рисует полноэкранный треугольник мимо очереди
+    uint32_t queueBits = multiDraw ? MULTI_DRAW_BIT : 0;
+    uint32_t lightingBits = 0;
+    if (useForwardShading())
+        lightingBits = queueBits | (depthPrepass ? DEPTH_PREPASS_BIT : 0) | (overdrawView ? OVERDRAW_BIT : 0);
+    currentShaderProgram = getShaderPermutation(lightingShaders, lightingKey(flatShading) | lightingBits);
+    if (gridSize > 1)
+        alternateShaderProgram = getShaderPermutation(lightingShaders, lightingKey(!flatShading) | lightingBits);
+    if (deferredShading) {
+        geometryShaderProgram = getShaderPermutation(lightingShaders, geometryKey(flatShading) | queueBits);
+        if (gridSize > 1)
+            alternateGeometryProgram = getShaderPermutation(lightingShaders, geometryKey(!flatShading) | queueBits);
+    }
+    if (depthPrepass && useForwardShading())
+        depthShaderProgram = getShaderPermutation(lightingShaders, DEPTH_ONLY_BIT | queueBits);
+}
 
-    flatShaderProgram = glCreateProgram();
-    glAttachShader(flatShaderProgram, vertexShader);
-    glAttachShader(flatShaderProgram, fragmentShader);
-    glLinkProgram(flatShaderProgram);
+void initOpenGL() {
+    glEnable(GL_DEPTH_TEST);
+    glGenQueries(2, shadedSampleQueries);
 
-    GLint success;
-    glGetProgramiv(flatShaderProgram, GL_LINK_STATUS, &success);
-    if (!success) {
-        char infoLog[512];
-        glGetProgramInfoLog(flatShaderProgram, 512, nullptr, infoLog);
-        std::cerr << "Flat shader program linking error: " << infoLog << std::endl;
+    if (multiDraw && !multiDrawIndirectSupported()) {
+        std::cout << "Multi-draw indirect is not supported, drawing one call per model" << std::endl;
+        multiDraw = false;
     }
+    if (multiDraw)
+        initIndirectDrawBuffers(indirectDrawBuffers);
+    selectLightingShader();
+    initClusterGrid(clusterGrid, 16, 9, 24, 0.1f, farPlane);
+    createPointLights(pointLightCount);
+    initGBuffer(gbuffer, 800, 600);
 
-    glDeleteShader(vertexShader);
-    glDeleteShader(fragmentShader);
+    viewMatrix = lookAt(cameraPosition, cameraTarget, cameraUp);
+    projectionMatrix = perspective(glm::radians(45.0f), 800.0f / 600.0f, 0.1f, farPlane);
 }
 
-void createGouraudShaderProgram() {
-    std::string vertexShaderSource = R"(
-        #version 330 core
-        layout(location = 0) in vec3 aPos;
-        layout(location = 1) in vec3 aNormal;
+const MeshRange& modelGeometry(bool flat) {
+    if (useSharedCube(flat))
+        return meshBuffer.meshes[sharedMeshId];
+    if (meshLoaded && flat)
+        return meshBuffer.meshes[facetedMeshId];
+    if (meshLoaded)
+        return meshBuffer.meshes[smoothMeshId];
+    return meshBuffer.meshes[cubeMeshId];
+}
 
-        out vec3 FragColor;
+void updateViewMatrix() {
+    if (pitch > 89.0f)
+        pitch = 89.0f;
+    if (pitch < -89.0f)
+        pitch = -89.0f;
+
+    glm::vec3 direction;
+    direction.x = cos(glm::radians(yaw)) * cos(glm::radians(pitch));
+    direction.y = sin(glm::radians(pitch));
+    direction.z = sin(glm::radians(yaw)) * cos(glm::radians(pitch));
+    cameraTarget = cameraPosition + glm::normalize(direction);
 
-        uniform mat4 model;
-        uniform mat4 view;
-        uniform mat4 projection;
-        uniform vec3 lightPos;
-        uniform vec3 lightPos2;
-        uniform vec3 viewPos;
-        uniform vec3 lightColor;
+    viewMatrix = lookAt(cameraPosition, cameraTarget, cameraUp);
+}
 
-        void main() {
-            vec3 FragPos = vec3(model * vec4(aPos, 1.0));
-            vec3 Normal = mat3(transpose(inverse(model))) * aNormal;
-            vec3 norm = normalize(Normal);
+bool mKeyPressed = false;
+bool tKeyPressed = false;
+bool lKeyPressed = false;
+bool gKeyPressed = false;
+bool pKeyPressed = false;
+bool bKeyPressed = false;
+bool zKeyPressed = false;
+bool oKeyPressed = false;
+bool creaseKeyPressed = false;
+
+void rebuildSmoothMesh();
+
+void processInput(float deltaTime) {
+    if (isKeyDown(sf::Keyboard::R)) {
+        scale += scaleSpeed * deltaTime;
+        scale = std::min(scale, maxScale);
+    }
+    if (isKeyDown(sf::Keyboard::F)) {
+        scale -= scaleSpeed * deltaTime;
+        scale = std::max(scale, minScale);
+    }
 
-            // Освещение от первого источника света
-            vec3 lightDir = normalize(lightPos - FragPos);
-            float diff = max(dot(norm, lightDir), 0.0);
-            vec3 diffuse = diff * lightColor;
+    if (isKeyDown(sf::Keyboard::W))
+        cameraPosition += cameraSpeed * deltaTime * glm::normalize(cameraTarget - cameraPosition);
+    if (isKeyDown(sf::Keyboard::S))
+        cameraPosition -= cameraSpeed * deltaTime * glm::normalize(cameraTarget - cameraPosition);
+    if (isKeyDown(sf::Keyboard::A))
+        cameraPosition -= glm::normalize(glm::cross(cameraTarget - cameraPosition, cameraUp)) * cameraSpeed * deltaTime;
+    if (isKeyDown(sf::Keyboard::D))
+        cameraPosition += glm::normalize(glm::cross(cameraTarget - cameraPosition, cameraUp)) * cameraSpeed * deltaTime;
+    if (isKeyDown(sf::Keyboard::Q))
+        cameraPosition.y += cameraSpeed * deltaTime;
+    if (isKeyDown(sf::Keyboard::E))
+        cameraPosition.y -= cameraSpeed * deltaTime;
+
+    if (isKeyDown(sf::Keyboard::Left)) {
+        yaw -= rotationSpeed * deltaTime;
+    }
+    if (isKeyDown(sf::Keyboard::Right)) {
+        yaw += rotationSpeed * deltaTime;
+    }
+    if (isKeyDown(sf::Keyboard::Up)) {
+        pitch += rotationSpeed * deltaTime;
+    }
+    if (isKeyDown(sf::Keyboard::Down)) {
+        pitch -= rotationSpeed * deltaTime;
+    }
 
-            // Освещение от второго источника света
-            vec3 lightDir2 = normalize(lightPos2 - FragPos);
-            float diff2 = max(dot(norm, lightDir2), 0.0);
-            vec3 diffuse2 = diff2 * lightColor;
+    updateViewMatrix();
 
-            // Суммарное освещение
-            FragColor = diffuse + diffuse2;
+    if (isKeyDown(sf::Keyboard::M) && !mKeyPressed) {
+        flatShading = !flatShading;
+        selectLightingShader();
+        std::cout << "Shading mode: " << (flatShading ? "Flat" : "Gouraud") << std::endl;
+        mKeyPressed = true;
+    }
+    if (!isKeyDown(sf::Keyboard::M)) {
+        mKeyPressed = false;
+    }
 
-            gl_Position = projection * view * vec4(FragPos, 1.0);
-        }
-    )";
+    if (isKeyDown(sf::Keyboard::T) && !tKeyPressed) {
+        directionalLights = !directionalLights;
+        selectLightingShader();
+        std::cout << "Light type: " << (directionalLights ? "Directional" : "Point") << std::endl;
+        tKeyPressed = true;
+    }
+    if (!isKeyDown(sf::Keyboard::T)) {
+        tKeyPressed = false;
+    }
 
-    std::string fragmentShaderSource = R"(
-        #version 330 core
-        in vec3 FragColor;
+    if (isKeyDown(sf::Keyboard::L) && !lKeyPressed) {
+        clusteredLighting = !clusteredLighting;
+        selectLightingShader();
+        std::cout << "Lighting: " << (clusteredLighting ? "Clustered, " + std::to_string(pointLights.size()) + " point lights" : "Two lights") << std::endl;
+        lKeyPressed = true;
+    }
+    if (!isKeyDown(sf::Keyboard::L)) {
+        lKeyPressed = false;
+    }
 
-        out vec4 FragColorOut;
+    if (isKeyDown(sf::Keyboard::G) && !gKeyPressed) {
+        deferredShading = !deferredShading;
+        selectLightingShader();
+        std::cout << "Renderer: " << (deferredShading ? "Deferred" : flatShading ? "Forward, flat" : "Forward, Gouraud") << std::endl;
+        gKeyPressed = true;
+    }
+    if (!isKeyDown(sf::Keyboard::G)) {
+        gKeyPressed = false;
+    }
 
-        void main() {
-            FragColorOut = vec4(FragColor, 1.0f);
-        }
-    )";
+    if (isKeyDown(sf::Keyboard::P) && !pKeyPressed) {
+        provokingVertexShading = !provokingVertexShading;
+        selectLightingShader();
+        std::cout << "Flat normals: " << (provokingVertexShading ? "Provoking vertex, shared vertices" : "Duplicated vertices") << std::endl;
+        pKeyPressed = true;
+    }
+    if (!isKeyDown(sf::Keyboard::P)) {
+        pKeyPressed = false;
+    }
 
-    GLuint vertexShader = compileShader(vertexShaderSource, GL_VERTEX_SHADER);
-    GLuint fragmentShader = compileShader(fragmentShaderSource, GL_FRAGMENT_SHADER);
+    if (isKeyDown(sf::Keyboard::B) && !bKeyPressed) {
+        lightBaking = !lightBaking;
+        selectLightingShader();
+        std::cout << "Lighting: " << (!lightBaking ? "Live" : clusteredLighting ? "Live, clustered lights cannot be baked" : "Baked") << std::endl;
+        bKeyPressed = true;
+    }
+    if (!isKeyDown(sf::Keyboard::B)) {
+        bKeyPressed = false;
+    }
 
-    gouraudShaderProgram = glCreateProgram();
-    glAttachShader(gouraudShaderProgram, vertexShader);
-    glAttachShader(gouraudShaderProgram, fragmentShader);
-    glLinkProgram(gouraudShaderProgram);
+    if (isKeyDown(sf::Keyboard::Z) && !zKeyPressed) {
+        depthPrepass = !depthPrepass;
+        selectLightingShader();
+        std::cout << "Depth pre-pass: " << (!depthPrepass ? "Off" : useForwardShading() ? "On" : "On, forward renderer only") << std::endl;
+        zKeyPressed = true;
+    }
+    if (!isKeyDown(sf::Keyboard::Z)) {
+        zKeyPressed = false;
+    }
 
-    GLint success;
-    glGetProgramiv(gouraudShaderProgram, GL_LINK_STATUS, &success);
-    if (!success) {
-        char infoLog[512];
-        glGetProgramInfoLog(gouraudShaderProgram, 512, nullptr, infoLog);
-        std::cerr << "Gouraud shader program linking error: " << infoLog << std::endl;
+    if (isKeyDown(sf::Keyboard::O) && !oKeyPressed) {
+        overdrawView = !overdrawView;
+        overdrawReported = false;
+        selectLightingShader();
+        std::cout << "Overdraw view: " << (!overdrawView ? "Off" : useForwardShading() ? "On" : "On, forward renderer only") << std::endl;
+        oKeyPressed = true;
+    }
+    if (!isKeyDown(sf::Keyboard::O)) {
+        oKeyPressed = false;
     }
 
-    glDeleteShader(vertexShader);
-    glDeleteShader(fragmentShader);
+    bool creaseDown = isKeyDown(sf::Keyboard::LBracket);
+    bool creaseUp = isKeyDown(sf::Keyboard::RBracket);
+    if (meshLoaded && (creaseDown || creaseUp) && !creaseKeyPressed) {
+        float current = creaseAngle < 0.0f ? 180.0f : creaseAngle;
+        creaseAngle = std::clamp(current + (creaseUp ? creaseStep : -creaseStep), 0.0f, 180.0f);
+        rebuildSmoothMesh();
+        creaseKeyPressed = true;
+    }
+    if (!creaseDown && !creaseUp) {
+        creaseKeyPressed = false;
+    }
 }
 
-glm::mat4 scaleMatrix(float scaleX, float scaleY, float scaleZ) {
-    glm::mat4 scale = glm::mat4(1.0f);
-    scale[0][0] = scaleX;
-    scale[1][1] = scaleY;
-    scale[2][2] = scaleZ;
-    return scale;
+void setViewport(int width, int height) {
+    viewportWidth = width;
+    viewportHeight = height;
+    glViewport(0, 0, width, height);
+    projectionMatrix = perspective(glm::radians(45.0f), (float)width / (float)height, 0.1f, farPlane);
+    resizeGBuffer(gbuffer, width, height);
+    resizeDynamicResolution(dynamicResolution, width, height);
 }
 
-glm::mat4 translateMatrix(const glm::vec3& translation) {
-    glm::mat4 translationMatrix = glm::mat4(1.0f);
-    translationMatrix[3][0] = translation.x;
-    translationMatrix[3][1] = translation.y;
-    translationMatrix[3][2] = translation.z;
-    return translationMatrix;
+// Позиции и нормали из отдельных массивов в вершины MeshData
+MeshData interleaveMesh(const GLfloat* positions, const GLfloat* normals, size_t vertexCount, const GLuint* indices, size_t indexCount) {
+    MeshData mesh;
+    mesh.vertices.resize(vertexCount * meshVertexFloats);
+    for (size_t i = 0; i < vertexCount; ++i) {
+        std::copy_n(&positions[i * 3], 3, &mesh.vertices[i * meshVertexFloats]);
+        std::copy_n(&normals[i * 3], 3, &mesh.vertices[i * meshVertexFloats + 3]);
+    }
+    mesh.indices.assign(indices, indices + indexCount);
+    return mesh;
 }
 
-glm::mat4 lookAt(const glm::vec3& eye, const glm::vec3& target, const glm::vec3& up) {
-    return glm::lookAt(eye, target, up);
+uint32_t addSharedMesh(const std::vector<glm::vec3>& positions, const std::vector<GLuint>& indices, size_t duplicatedVertexCount) {
+    ProvokingVertexMesh mesh = buildProvokingVertexMesh(positions, indices);
+    std::cout << "Provoking-vertex mesh: " << mesh.positions.size() << " vertices instead of " << duplicatedVertexCount << std::endl;
+    return addMesh(meshBuffer, interleaveMesh(&mesh.positions[0].x, &mesh.normals[0].x, mesh.positions.size(),
+                                              mesh.indices.data(), mesh.indices.size()));
 }
 
-glm::mat4 perspective(float fov, float aspect, float near, float far) {
-    return glm::perspective(fov, aspect, near, far);
+// Куб с дублированными вершинами, куб или модель из общих вершин, затем варианты модели.
+// Гладкий вариант последний: его перестроение по --crease не сдвигает остальные диапазоны.
+void initMeshes() {
+    initMeshBuffer(meshBuffer);
+    cubeMeshId = addMesh(meshBuffer, interleaveMesh(cubeVertices, cubeNormals, 24, cubeIndices, 36));
+
+    if (meshLoaded) {
+        std::vector<glm::vec3> positions(meshTopology.vertices.size() / meshVertexFloats);
+        for (size_t i = 0; i < positions.size(); ++i)
+            positions[i] = glm::vec3(meshTopology.vertices[i * meshVertexFloats], meshTopology.vertices[i * meshVertexFloats + 1], meshTopology.vertices[i * meshVertexFloats + 2]);
+        sharedMeshId = addSharedMesh(positions, meshTopology.indices, meshTopology.indices.size());
+        facetedMeshId = addMesh(meshBuffer, facetedMesh);
+        smoothMeshId = addMesh(meshBuffer, modelMesh);
+    } else {
+        std::vector<glm::vec3> corners(8);
+        for (int i = 0; i < 8; ++i)
+            corners[i] = glm::vec3(cubeCorners[i * 3], cubeCorners[i * 3 + 1], cubeCorners[i * 3 + 2]);
+        std::vector<GLuint> indices(cubeCornerIndices, cubeCornerIndices + 36);
+        sharedMeshId = addSharedMesh(corners, indices, 24);
+    }
+    uploadMeshBuffer(meshBuffer);
 }
 
-void initOpenGL() {
-    glEnable(GL_DEPTH_TEST);
-    glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
+// Плоский вариант и, при --crease, гладкий строятся из вершин, слитых по позиции:
+// у файла с нормалями вершины на рёбрах уже разделены и не знают о соседях
+void buildModelVariants() {
+    PROFILE_ZONE("Build model variants");
+    auto start = std::chrono::steady_clock::now();
+    meshTopology = modelMesh;
+    for (size_t i = 0; i < meshTopology.vertices.size(); i += meshVertexFloats)
+        std::fill_n(&meshTopology.vertices[i + 3], 3, 0.0f);
+    weldVertices(meshTopology);
+    facetedMesh = splitCreases(meshTopology, 0.0f);
+    if (creaseAngle >= 0.0f)
+        modelMesh = splitCreases(meshTopology, creaseAngle);
+    auto end = std::chrono::steady_clock::now();
+    std::cout << "Normals: " << facetedMesh.vertices.size() / meshVertexFloats << " faceted, "
+              << modelMesh.vertices.size() / meshVertexFloats << " smooth vertices in "
+              << std::chrono::duration<double, std::milli>(end - start).count() << " ms" << std::endl;
+}
 
-    createFlatShaderProgram();
-    createGouraudShaderProgram();
+bool loadModelMesh(const std::string& path) {
+    if (!loadMesh(path, modelMesh))
+        return false;
+    meshLoaded = true;
+    meshFit = meshFitMatrix(modelMesh);
+    std::cout << "Loaded " << path << ": " << modelMesh.vertices.size() / meshVertexFloats << " vertices, "
+              << modelMesh.indices.size() / 3 << " triangles" << std::endl;
+    buildModelVariants();
+    return true;
+}
 
-    currentShaderProgram = flatShaderProgram;
+// Куб из общих вершин как модель, чтобы порог --crease работал и без файла
+void loadCubeModel() {
+    modelMesh.vertices.clear();
+    for (int i = 0; i < 8; ++i) {
+        modelMesh.vertices.insert(modelMesh.vertices.end(), &cubeCorners[i * 3], &cubeCorners[i * 3 + 3]);
+        modelMesh.vertices.insert(modelMesh.vertices.end(), 3, 0.0f);
+    }
+    modelMesh.indices.assign(cubeCornerIndices, cubeCornerIndices + 36);
+    modelMesh.boundsMin = glm::vec3(-1.0f);
+    modelMesh.boundsMax = glm::vec3(1.0f);
+    meshLoaded = true;
+    buildModelVariants();
+}
 
-    viewMatrix = lookAt(cameraPosition, cameraTarget, cameraUp);
-    projectionMatrix = perspective(glm::radians(45.0f), 800.0f / 600.0f, 0.1f, 100.0f);
+void rebuildSmoothMesh() {
+    auto start = std::chrono::steady_clock::now();
+    modelMesh = splitCreases(meshTopology, creaseAngle);
+    replaceMesh(meshBuffer, smoothMeshId, modelMesh);
+    uploadMeshBuffer(meshBuffer);
+    meshBake.valid = false;
+    auto end = std::chrono::steady_clock::now();
+    std::cout << "Crease angle: " << creaseAngle << " degrees, " << modelMesh.vertices.size() / meshVertexFloats
+              << " vertices in " << std::chrono::duration<double, std::milli>(end - start).count() << " ms" << std::endl;
 }
 
-void drawCube() {
-    glBindVertexArray(VAO);
-    glDrawElements(GL_TRIANGLES, 36, GL_UNSIGNED_INT, 0);
-    glBindVertexArray(0);
+void setCameraUniforms(GLuint program) {
+    glUniformMatrix4fv(glGetUniformLocation(program, "view"), 1, GL_FALSE, &viewMatrix[0][0]);
+    glUniformMatrix4fv(glGetUniformLocation(program, "projection"), 1, GL_FALSE, &projectionMatrix[0][0]);
 }
 
-bool mKeyPressed = false;
+// Кластеры строятся раз в кадр, а привязываются к каждой программе, что их читает
+void updateLights() {
+    if (!clusteredLighting)
+        return;
+    PROFILE_ZONE("Update lights");
+    updatePointLights(sceneTime);
+    buildClusters(clusterGrid, pointLights, viewMatrix, projectionMatrix);
+}
 
-void processInput(sf::Window& window) {
-    if (sf::Keyboard::isKeyPressed(sf::Keyboard::R)) {
-        scale += 0.01f;
-        scale = std::min(scale, maxScale);
-    }
-    if (sf::Keyboard::isKeyPressed(sf::Keyboard::F)) {
-        scale -= 0.01f;
-        scale = std::max(scale, minScale);
+void setLightUniforms(GLuint program) {
+    if (clusteredLighting) {
+        bindClusters(clusterGrid, program, 0);
+    } else {
+        glUniform3fv(glGetUniformLocation(program, "lights"), lights.size(), &lights[0][0]);
+        glUniform3f(glGetUniformLocation(program, "lightColor"), 1.0f, 1.0f, 1.0f);
     }
+}
 
-    if (sf::Keyboard::isKeyPressed(sf::Keyboard::W))
-        cameraPosition += cameraSpeed * glm::normalize(cameraTarget - cameraPosition);
-    if (sf::Keyboard::isKeyPressed(sf::Keyboard::S))
-        cameraPosition -= cameraSpeed * glm::normalize(cameraTarget - cameraPosition);
-    if (sf::Keyboard::isKeyPressed(sf::Keyboard::A))
-        cameraPosition -= glm::normalize(glm::cross(cameraTarget - cameraPosition, cameraUp)) * cameraSpeed;
-    if (sf::Keyboard::isKeyPressed(sf::Keyboard::D))
-        cameraPosition += glm::normalize(glm::cross(cameraTarget - cameraPosition, cameraUp)) * cameraSpeed;
-    if (sf::Keyboard::isKeyPressed(sf::Keyboard::Q))
-        cameraPosition.y += cameraSpeed;
-    if (sf::Keyboard::isKeyPressed(sf::Keyboard::E))
-        cameraPosition.y -= cameraSpeed;
+// Заполняется каждый кадр заново: копия источников переиспользует память вектора
+StaticLighting frameLighting;
 
-    if (sf::Keyboard::isKeyPressed(sf::Keyboard::Left)) {
-        yaw -= rotationSpeed;
-    }
-    if (sf::Keyboard::isKeyPressed(sf::Keyboard::Right)) {
-        yaw += rotationSpeed;
+const StaticLighting& currentStaticLighting(const glm::mat4& modelMatrix) {
+    frameLighting.lights = lights;
+    frameLighting.directional = directionalLights;
+    frameLighting.lightScale = flatShading ? 1.25f : 1.0f; // как lightScale в lighting.glsl
+    frameLighting.model = modelMatrix;
+    return frameLighting;
+}
+
+// Буфер цветов следует за числом вершин meshBuffer; при пересоздании старые цвета теряются
+void reserveBakedColors() {
+    size_t vertexCount = meshBufferVertexCount(meshBuffer);
+    if (bakedColorBuffer != 0 && bakedColorVertices == vertexCount)
+        return;
+
+    if (bakedColorBuffer == 0)
+        genTrackedBuffers(1, &bakedColorBuffer, GpuMemoryCategory::Lighting);
+    glBindVertexArray(meshBuffer.vao);
+    glBindBuffer(GL_ARRAY_BUFFER, bakedColorBuffer);
+    trackedBufferData(GL_ARRAY_BUFFER, bakedColorBuffer, vertexCount * 3 * sizeof(GLfloat), nullptr, GL_STATIC_DRAW);
+    glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(GLfloat), (void*)0);
+    glEnableVertexAttribArray(2);
+    glBindVertexArray(0);
+    bakedColorVertices = vertexCount;
+    cubeBake.valid = meshBake.valid = facetedBake.valid = false;
+}
+
+// Цвета пересчитываются, только если источники или преобразование модели изменились с прошлого
+// запекания. Плоское затенение точечными источниками при этом интерполируется по грани.
+void ensureBaked(BakedColors& bake, const MeshRange& range, const GLfloat* positions, const GLfloat* normals, size_t stride,
+                 const StaticLighting& lighting) {
+    reserveBakedColors();
+    if (bake.valid && bake.lighting == lighting)
+        return;
+
+    PROFILE_ZONE("Bake model");
+    size_t vertexCount = range.vertexCount;
+    size_t colorBytes = vertexCount * 3 * sizeof(GLfloat);
+    GLfloat* colors = arenaArray<GLfloat>(frameArena(), vertexCount * 3);
+    bakeDiffuseLighting(positions, stride, normals, stride, vertexCount, lighting, colors);
+
+    glBindBuffer(GL_ARRAY_BUFFER, bakedColorBuffer);
+    glBufferSubData(GL_ARRAY_BUFFER, (size_t)range.baseVertex * 3 * sizeof(GLfloat), colorBytes, colors);
+    addPerfCounter(PerfCounter::UploadedBytes, colorBytes);
+
+    bake.lighting = lighting;
+    bake.valid = true;
+}
+
+void bakeModel(const glm::mat4& modelMatrix) {
+    const StaticLighting& lighting = currentStaticLighting(modelMatrix);
+    if (meshLoaded && flatShading)
+        ensureBaked(facetedBake, meshBuffer.meshes[facetedMeshId], &facetedMesh.vertices[0], &facetedMesh.vertices[3],
+                    meshVertexFloats, lighting);
+    else if (meshLoaded)
+        ensureBaked(meshBake, meshBuffer.meshes[smoothMeshId], &modelMesh.vertices[0], &modelMesh.vertices[3],
+                    meshVertexFloats, lighting);
+    else
+        ensureBaked(cubeBake, meshBuffer.meshes[cubeMeshId], cubeVertices, cubeNormals, 3, lighting);
+}
+
+// Сетка уходит от камеры вдоль -Z. Клетка (0, 0) — одиночная модель: белый материал и текущее затенение.
+// Узлы клеток добавляются раньше узлов моделей, чтобы уровни графа шли подряд.
+void buildScene() {
+    clearSceneGraph(sceneGraph);
+    size_t cellCount = (size_t)gridSize * gridSize;
+    float offset = (gridSize - 1) * gridSpacing * 0.5f;
+    uint32_t root = addSceneNode(sceneGraph, noSceneParent, glm::vec3(0.0f));
+    for (size_t cell = 0; cell < cellCount; ++cell) {
+        int x = (int)(cell % gridSize);
+        int z = (int)(cell / gridSize);
+        addSceneNode(sceneGraph, root, glm::vec3(x * gridSpacing - offset, 0.0f, -z * gridSpacing));
     }
-    if (sf::Keyboard::isKeyPressed(sf::Keyboard::Up)) {
-        pitch += rotationSpeed;
+
+    // Сфера вокруг меша в его собственных координатах, вписывание переносит её к началу координат
+    glm::vec3 boundsMin = meshLoaded ? modelMesh.boundsMin : glm::vec3(-1.0f);
+    glm::vec3 boundsMax = meshLoaded ? modelMesh.boundsMax : glm::vec3(1.0f);
+    modelNodes.resize(cellCount);
+    for (size_t cell = 0; cell < cellCount; ++cell) {
+        modelNodes[cell] = addSceneNode(sceneGraph, root + 1 + (uint32_t)cell, glm::vec3(0.0f));
+        setNodeBounds(sceneGraph, modelNodes[cell], (boundsMin + boundsMax) * 0.5f, glm::length(boundsMax - boundsMin) * 0.5f);
     }
-    if (sf::Keyboard::isKeyPressed(sf::Keyboard::Down)) {
-        pitch -= rotationSpeed;
+    sceneScale = -1.0f;
+}
+
+void buildPickMesh() {
+    auto start = std::chrono::steady_clock::now();
+    std::vector<GLuint> indices;
+    if (meshLoaded) {
+        pickPositions = meshTopology.vertices.data();
+        pickStride = meshVertexFloats;
+        pickIndices = meshTopology.indices.data();
+        indices = meshTopology.indices;
+    } else {
+        pickPositions = cubeCorners;
+        pickStride = 3;
+        pickIndices = cubeCornerIndices;
+        indices.assign(cubeCornerIndices, cubeCornerIndices + 36);
     }
 
-    if (pitch > 89.0f)
-        pitch = 89.0f;
-    if (pitch < -89.0f)
-        pitch = -89.0f;
+    std::vector<Aabb> triangles;
+    triangleBounds(pickPositions, pickStride, indices, triangles);
+    buildBvh(meshBvh, triangles);
+    meshBounds = meshBvh.nodes.empty() ? Aabb() : meshBvh.nodes[0].bounds;
+    auto end = std::chrono::steady_clock::now();
+    std::cout << "Picking BVH: " << triangles.size() << " triangles, " << meshBvh.nodes.size() << " nodes in "
+              << std::chrono::duration<double, std::milli>(end - start).count() << " ms" << std::endl;
+}
 
-    glm::vec3 direction;
-    direction.x = cos(glm::radians(yaw)) * cos(glm::radians(pitch));
-    direction.y = sin(glm::radians(pitch));
-    direction.z = sin(glm::radians(yaw)) * cos(glm::radians(pitch));
-    cameraTarget = cameraPosition + glm::normalize(direction);
+struct PickResult {
+    int cell = -1;
+    uint32_t triangle = noHitPrimitive;
+    float distance = noHitDistance;
+};
 
-    viewMatrix = lookAt(cameraPosition, cameraTarget, cameraUp);
+glm::vec3 pickPosition(GLuint vertex) {
+    const GLfloat* p = pickPositions + vertex * pickStride;
+    return glm::vec3(p[0], p[1], p[2]);
+}
 
-    if (sf::Keyboard::isKeyPressed(sf::Keyboard::M) && !mKeyPressed) {
-        flatShading = !flatShading;
-        currentShaderProgram = flatShading ? flatShaderProgram : gouraudShaderProgram;
-        std::cout << "Shading mode: " << (flatShading ? "Flat" : "Gouraud") << std::endl;
-        mKeyPressed = true;
+// Первое построение для больших сеток долгое, поэтому окно делает его при запуске
+void updatePickHierarchy() {
+    if (!sceneBvhStale)
+        return;
+    modelBounds.resize(modelNodes.size());
+    for (size_t cell = 0; cell < modelNodes.size(); ++cell)
+        modelBounds[cell] = transformAabb(meshBounds, sceneGraph.world[modelNodes[cell]]);
+    if (sceneBvh.nodes.empty())
+        buildBvh(sceneBvh, modelBounds);
+    else
+        refitBvh(sceneBvh, modelBounds);
+    sceneBvhStale = false;
+}
+
+PickResult pickModel(int x, int y) {
+    updatePickHierarchy();
+
+    // t луча в координатах модели совпадает с мировым, поэтому расстояния сравнимы между клетками
+    Ray ray = screenRay(x + 0.5f, y + 0.5f, (float)viewportWidth, (float)viewportHeight, projectionMatrix, viewMatrix);
+    PickResult result;
+    RayHit hit = raycastBvh(sceneBvh, ray, [&](uint32_t cell, float maxDistance) {
+        Ray local = transformRay(ray, glm::inverse(sceneGraph.world[modelNodes[cell]]));
+        RayHit triangle = raycastBvh(meshBvh, local, [&](uint32_t t, float) {
+            const GLuint* corners = pickIndices + t * 3;
+            return intersectTriangle(local, pickPosition(corners[0]), pickPosition(corners[1]), pickPosition(corners[2]));
+        }, maxDistance);
+        if (triangle.primitive != noHitPrimitive)
+            result.triangle = triangle.primitive;
+        return triangle.distance;
+    });
+    if (hit.primitive != noHitPrimitive) {
+        result.cell = (int)hit.primitive;
+        result.distance = hit.distance;
     }
-    if (!sf::Keyboard::isKeyPressed(sf::Keyboard::M)) {
-        mKeyPressed = false;
+    return result;
+}
+
+// Наведение подсвечивает клетку, щелчок выбирает её или снимает выбор при промахе
+void pointerInput(int x, int y, bool click) {
+    auto start = std::chrono::steady_clock::now();
+    PickResult pick = pickModel(x, y);
+    auto end = std::chrono::steady_clock::now();
+    if (!click) {
+        hoveredCell = pick.cell;
+        return;
     }
+
+    selectedCell = pick.cell;
+    double ms = std::chrono::duration<double, std::milli>(end - start).count();
+    if (pick.cell < 0) {
+        std::cout << "Picked nothing in " << ms << " ms" << std::endl;
+        return;
+    }
+    std::cout << "Picked model (" << pick.cell % gridSize << ", " << pick.cell / gridSize << "), triangle "
+              << pick.triangle << " in " << ms << " ms" << std::endl;
 }
 
-void resizeCallback(sf::Window& window, int width, int height) {
-    glViewport(0, 0, width, height);
-    projectionMatrix = perspective(glm::radians(45.0f), (float)width / (float)height, 0.1f, 100.0f);
+// Узел модели повторяет scaleMatrix(scale) * meshFit: вписывание — равномерный масштаб и перенос
+void updateScene() {
+    if (scale != sceneScale) {
+        sceneScale = scale;
+        glm::vec3 translation = glm::vec3(meshFit[3]) * scale;
+        glm::vec3 modelScale = glm::vec3(meshFit[0][0] * scale);
+        for (uint32_t node : modelNodes) {
+            setNodeTranslation(sceneGraph, node, translation);
+            setNodeScale(sceneGraph, node, modelScale);
+        }
+    }
+    if (updateSceneGraph(sceneGraph) > 0)
+        sceneBvhStale = true;
 }
 
-int main() {
-    sf::ContextSettings settings;
-    settings.depthBits = 24;
-    settings.stencilBits = 8;
-    settings.majorVersion = 3;
-    settings.minorVersion = 3;
+enum class ModelPass {
+    Shading,
+    Geometry, // G-буфер отложенного освещения
+    Depth,    // предварительный проход глубины
+};
 
-    sf::Window window(sf::VideoMode(800, 600), "Lab 4", sf::Style::Default, settings);
-    window.setActive(true);
+// Клетки записывают рабочие потоки, GL вызывается только при отправке очереди.
+void queueModels(ModelPass pass) {
+    PROFILE_ZONE("Queue models");
+    size_t cellCount = modelNodes.size();
+    Frustum frustum = extractFrustum(projectionMatrix * viewMatrix);
+
+    // [0] — клетки с текущим затенением, [1] — с противоположным
+    MeshRange geometries[2] = { modelGeometry(flatShading), modelGeometry(!flatShading) };
+    GLuint programs[2] = { currentShaderProgram, alternateShaderProgram };
+    if (pass == ModelPass::Geometry) {
+        programs[0] = geometryShaderProgram;
+        programs[1] = alternateGeometryProgram;
+    } else if (pass == ModelPass::Depth) {
+        // Геометрия та же, что у прохода затенения: иначе глубина не совпадёт при GL_EQUAL
+        programs[0] = programs[1] = depthShaderProgram;
+    }
 
-    glewInit();
-    initOpenGL();
+    recordCommands(commandRecorder, cellCount, [&](size_t begin, size_t end, std::vector<DrawItem>& buffer) {
+        for (size_t cell = begin; cell < end; ++cell) {
+            int x = (int)(cell % gridSize);
+            int z = (int)(cell / gridSize);
+            uint32_t node = modelNodes[cell];
+            const glm::vec4& bounds = sceneGraph.worldBounds[node];
+            glm::vec3 center = glm::vec3(bounds);
+            if (!sphereInFrustum(frustum, center, bounds.w))
+                continue;
+
+            int alternate = (x + z) % 2;
+            DrawItem item;
+            item.program = programs[alternate];
+            item.vao = meshBuffer.vao;
+            item.indexCount = geometries[alternate].indexCount;
+            item.firstIndex = geometries[alternate].firstIndex;
+            item.baseVertex = geometries[alternate].baseVertex;
+            item.material = (uint32_t)((x + 2 * z) % gridMaterials.size());
+            item.albedo = gridMaterials[item.material];
+            if ((int)cell == selectedCell || (int)cell == hoveredCell) {
+                bool selected = (int)cell == selectedCell;
+                item.material = (uint32_t)gridMaterials.size() + (selected ? 1 : 0);
+                item.albedo = selected ? selectionAlbedo : hoverAlbedo;
+            }
+            item.model = sceneGraph.world[node];
+            float depth = -(viewMatrix * glm::vec4(center, 1.0f)).z / farPlane;
+            // Проходу глубины материал не важен, он идёт строго от ближних к дальним
+            uint32_t sortMaterial = pass == ModelPass::Depth ? 0 : item.material;
+            item.key = makeSortKey(0, item.program, item.vao, sortMaterial, depth);
+            buffer.push_back(item);
+        }
+    });
+
+    size_t queued = renderQueue.items.size();
+    mergeCommands(commandRecorder, renderQueue);
+    culledModels = cellCount - (renderQueue.items.size() - queued);
+    // Проход глубины отсекает те же модели, счётчик кадра считает их один раз
+    if (pass != ModelPass::Depth)
+        addPerfCounter(PerfCounter::CulledObjects, culledModels);
+}
 
-    glGenVertexArrays(1, &VAO);
-    glGenBuffers(1, &VBO);
-    glGenBuffers(1, &NBO);
-    glGenBuffers(1, &EBO);
+void reportRenderStats(const RenderStats& stats) {
+    if (gridSize == 1 || renderStatsReported)
+        return;
+    std::cout << "Render queue: " << stats.draws << " draws (" << culledModels << " culled), " << stats.programChanges << " program, "
+              << stats.vaoChanges << " VAO and " << stats.materialChanges << " material changes";
+    if (multiDraw)
+        std::cout << ", " << stats.multiDraws << " multi-draw calls";
+    std::cout << std::endl;
+    renderStatsReported = true;
+}
 
-    glBindVertexArray(VAO);
+RenderStats submitModels(const std::function<void(GLuint program)>& bindProgram) {
+    if (multiDraw)
+        return submitRenderQueueIndirect(renderQueue, indirectDrawBuffers, bindProgram);
+    return submitRenderQueue(renderQueue, bindProgram);
+}
 
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(cubeVertices), cubeVertices, GL_STATIC_DRAW);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(GLfloat), (void*)0);
-    glEnableVertexAttribArray(0);
+void renderDeferred() {
+    // Рисуем в тот буфер, что был привязан до нас (окно или FBO безголового режима)
+    GLint targetFramebuffer;
+    glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &targetFramebuffer);
+
+    {
+        PROFILE_GPU_ZONE("Geometry pass");
+        beginGeometryPass(gbuffer);
+        queueModels(ModelPass::Geometry);
+        reportRenderStats(submitModels(setCameraUniforms));
+        endGeometryPass(gbuffer, targetFramebuffer);
+    }
 
-    glBindBuffer(GL_ARRAY_BUFFER, NBO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(cubeNormals), cubeNormals, GL_STATIC_DRAW);
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(GLfloat), (void*)0);
-    glEnableVertexAttribArray(1);
+    glClear(GL_COLOR_BUFFER_BIT);
+    glUseProgram(currentShaderProgram);
+    addPerfCounter(PerfCounter::ShaderSwitches, 1);
+    setCameraUniforms(currentShaderProgram);
+    setLightUniforms(currentShaderProgram);
+    bindGBufferTextures(gbuffer, currentShaderProgram, 3);
+    drawFullscreenTriangle(gbuffer);
+}
 
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(cubeIndices), cubeIndices, GL_STATIC_DRAW);
+void beginShadedSamples() {
+    glBeginQuery(GL_SAMPLES_PASSED, shadedSampleQueries[shadedSampleFrame % 2]);
+}
 
-    glBindVertexArray(0);
+// Читает запрос прошлого кадра: к этому времени GPU обычно уже его посчитал
+void endShadedSamples() {
+    glEndQuery(GL_SAMPLES_PASSED);
+    GLuint previous = shadedSampleQueries[++shadedSampleFrame % 2];
+    GLint available = 0;
+    if (shadedSampleFrame > 1)
+        glGetQueryObjectiv(previous, GL_QUERY_RESULT_AVAILABLE, &available);
+    if (!available)
+        return;
+
+    GLuint64 samples = 0;
+    glGetQueryObjectui64v(previous, GL_QUERY_RESULT, &samples);
+    addPerfCounter(PerfCounter::ShadedSamples, samples);
+    if (overdrawView && !overdrawReported) {
+        GLint viewport[4];
+        glGetIntegerv(GL_VIEWPORT, viewport);
+        std::cout << "Overdraw: " << samples << " shaded samples, " << (double)samples / ((double)viewport[2] * viewport[3])
+                  << " per pixel" << std::endl;
+        overdrawReported = true;
+    }
+}
 
-    glm::vec3 lightPos = glm::vec3(1.5f, 2.0f, 3.0f);
-    glm::vec3 lightPos2 = glm::vec3(-1.5f, 2.0f, -3.0f);
+void renderScene() {
+    PROFILE_ZONE("Render scene");
+    PROFILE_GPU_ZONE("Scene");
+    glm::mat4 modelMatrix = scaleMatrix(scale, scale, scale) * meshFit;
+    updateLights();
+    updateScene();
+    // Карта перерисовки считает слои от чёрного фона
+    float background = overdrawView && useForwardShading() ? 0.0f : 0.1f;
+    glClearColor(background, background, background, 1.0f);
+
+    if (useBakedLighting()) {
+        bakeModel(modelMatrix);
+    } else if (deferredShading) {
+        renderDeferred();
+        return;
+    }
 
-    while (window.isOpen()) {
-        sf::Event event;
-        while (window.pollEvent(event)) {
-            if (event.type == sf::Event::Closed)
-                window.close();
-            if (event.type == sf::Event::Resized) {
-                resizeCallback(window, event.size.width, event.size.height);
-            }
-        }
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-        processInput(window);
+    if (depthPrepass) {
+        PROFILE_GPU_ZONE("Depth pre-pass");
+        glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+        queueModels(ModelPass::Depth);
+        submitModels(setCameraUniforms);
+        glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+        glDepthMask(GL_FALSE);
+        glDepthFunc(GL_EQUAL);
+    }
+    if (overdrawView) {
+        glEnable(GL_BLEND);
+        glBlendFunc(GL_ONE, GL_ONE);
+    }
 
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    {
+        PROFILE_GPU_ZONE("Shading pass");
+        beginShadedSamples();
+        queueModels(ModelPass::Shading);
+        reportRenderStats(submitModels([](GLuint program) {
+            setCameraUniforms(program);
+            if (!useBakedLighting())
+                setLightUniforms(program);
+        }));
+        endShadedSamples();
+    }
 
-        glm::mat4 modelMatrix = scaleMatrix(scale, scale, scale);
+    if (depthPrepass) {
+        glDepthMask(GL_TRUE);
+        glDepthFunc(GL_LESS);
+    }
+    if (overdrawView)
+        glDisable(GL_BLEND);
+}
 
-        glUseProgram(currentShaderProgram);
-        glUniformMatrix4fv(glGetUniformLocation(currentShaderProgram, "model"), 1, GL_FALSE, &modelMatrix[0][0]);
-        glUniformMatrix4fv(glGetUniformLocation(currentShaderProgram, "view"), 1, GL_FALSE, &viewMatrix[0][0]);
-        glUniformMatrix4fv(glGetUniformLocation(currentShaderProgram, "projection"), 1, GL_FALSE, &projectionMatrix[0][0]);
-        glUniform3fv(glGetUniformLocation(currentShaderProgram, "lightPos"), 1, &lightPos[0]);
-        glUniform3fv(glGetUniformLocation(currentShaderProgram, "lightPos2"), 1, &lightPos2[0]);
-        glUniform3fv(glGetUniformLocation(currentShaderProgram, "viewPos"), 1, &cameraPosition[0]);
-        glUniform3f(glGetUniformLocation(currentShaderProgram, "lightColor"), 1.0f, 1.0f, 1.0f);
+void applyCameraKey(const CameraKey& key) {
+    cameraPosition = key.position;
+    yaw = key.yaw;
+    pitch = key.pitch;
+    scale = key.scale;
+    sceneTime = key.time;
+    updateViewMatrix();
+}
 
-        drawCube();
+CameraKey currentCameraKey() {
+    CameraKey key;
+    key.position = cameraPosition;
+    key.yaw = yaw;
+    key.pitch = pitch;
+    key.scale = scale;
+    return key;
+}
+
+// Кадр ввода: клавиатура или запись (--replay), затем камера уходит в запись или сверяется с ней
+void stepInput(float wallTime, float wallDelta) {
+    sceneTime = beginInputFrame(wallTime);
+    processInput(inputDeltaTime(wallDelta));
+    endInputFrame(currentCameraKey());
+}
 
-        window.display();
+int main(int argc, char** argv) {
+    PROFILE_INIT(argc, argv);
+    initPerfCounters();
+    HeadlessOptions headless;
+    if (!parseHeadlessArgs(argc, argv, headless) || !initInput(argc, argv))
+        return 1;
+    setShaderHotReload(hasArg(argc, argv, "--hot-reload"));
+    dynamicResolution.targetMs = (float)std::atof(getArg(argc, argv, "--frame-budget", "0").c_str());
+    dynamicResolution.enabled = dynamicResolution.targetMs > 0.0f;
+    framePacer.targetFps = (float)std::atof(getArg(argc, argv, "--fps", "60").c_str());
+    clusteredLighting = hasArg(argc, argv, "--clustered");
+    deferredShading = hasArg(argc, argv, "--deferred");
+    provokingVertexShading = hasArg(argc, argv, "--provoking");
+    lightBaking = hasArg(argc, argv, "--bake");
+    gridSize = std::max(1, std::atoi(getArg(argc, argv, "--grid", "1").c_str()));
+    multiDraw = hasArg(argc, argv, "--multi-draw");
+    depthPrepass = hasArg(argc, argv, "--depth-prepass");
+    overdrawView = hasArg(argc, argv, "--overdraw");
+    creaseAngle = (float)std::atof(getArg(argc, argv, "--crease", "-1").c_str());
+    std::string meshPath = getArg(argc, argv, "--mesh", "");
+    if (!meshPath.empty() && !loadModelMesh(meshPath))
+        return 1;
+    if (meshPath.empty() && creaseAngle >= 0.0f)
+        loadCubeModel();
+    pointLightCount = std::max(1, std::atoi(getArg(argc, argv, "--lights", "1024").c_str()));
+    buildScene();
+    buildPickMesh();
+
+    if (headless.enabled) {
+        int result = runHeadless(headless,
+            [](int width, int height) {
+                initOpenGL();
+                initDynamicResolution(dynamicResolution, width, height);
+                initMeshes();
+                setViewport(width, height);
+            },
+            [](const CameraKey& key) {
+                if (isReplayingInput())
+                    stepInput(key.time, inputTimestep);
+                else
+                    applyCameraKey(key);
+                beginDynamicResolutionFrame(dynamicResolution);
+                renderScene();
+                endDynamicResolutionFrame(dynamicResolution);
+            });
+        finishInput();
+        PROFILE_SHUTDOWN();
+        destroyPerfCounters();
+        return result;
     }
 
-    glDeleteVertexArrays(1, &VAO);
-    glDeleteBuffers(1, &VBO);
-    glDeleteBuffers(1, &NBO);
-    glDeleteBuffers(1, &EBO);
+    sf::ContextSettings settings;
+    settings.depthBits = 24;
+    settings.stencilBits = 8;
+    settings.majorVersion = 3;
+    settings.minorVersion = 3;
+
+    sf::Window window(sf::VideoMode(800, 600), "Lab 4", sf::Style::Default, settings);
+    RenderLoop loop;
+    loop.init = []() {
+        initOpenGL();
+        initDynamicResolution(dynamicResolution, 800, 600);
+        initMeshes();
+        updateScene();
+        updatePickHierarchy();
+    };
+    loop.resize = setViewport;
+    loop.update = []() {
+        reloadChangedShaders();
+    };
+    loop.stepInput = stepInput;
+    loop.pointer = pointerInput;
+    loop.render = []() {
+        beginDynamicResolutionFrame(dynamicResolution);
+        renderScene();
+        endDynamicResolutionFrame(dynamicResolution);
+    };
+    loop.shutdown = []() {
+        destroyMeshBuffer(meshBuffer);
+        deleteTrackedBuffers(1, &bakedColorBuffer);
+        glDeleteQueries(2, shadedSampleQueries);
+        if (multiDraw)
+            destroyIndirectDrawBuffers(indirectDrawBuffers);
+        destroyClusterGrid(clusterGrid);
+        destroyGBuffer(gbuffer);
+        destroyDynamicResolution(dynamicResolution);
+        deleteShaderPrograms();
+    };
+
+    runRenderThread(window, framePacer, loop);
+    finishInput();
+    PROFILE_SHUTDOWN();
+    destroyPerfCounters();
 
     return 0;
 }
\ No newline at end of file
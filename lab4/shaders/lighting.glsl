@@ -0,0 +1,225 @@
+#version 330 core
+
+// Варианты задаются через #define:
+//   SHADING_GOURAUD   — освещение в вершинном шейдере, иначе плоское по нормали грани во фрагментном
+//   LIGHT_DIRECTIONAL — lights[] хранит направления на источник, иначе позиции точечных источников
+//   LIGHT_COUNT       — число источников, цикл разворачивается компилятором
+//   LIGHTING_CLUSTERED — точечные источники из текстурных буферов, только назначенные кластеру
+//   SHADING_PROVOKING — нормаль грани берётся из провоцирующей вершины без интерполяции (flat),
+//                       вершины не нужно дублировать по граням
+//   DEFERRED_GEOMETRY — геометрический проход: позиция, нормаль и альбедо пишутся в G-буфер
+//   DEFERRED_LIGHTING — проход освещения по G-буферу полноэкранным треугольником
+//   SHADING_UNLIT     — освещение запечено на CPU в цвет вершины (location 2), шейдер его только выводит
+//   MULTI_DRAW        — model и albedo берутся из буфера рисований по gl_DrawID (glMultiDrawElementsIndirect)
+//   DEPTH_ONLY        — предварительный проход глубины: только позиция, цвет не пишется
+//   DEPTH_PREPASS     — затенение после DEPTH_ONLY, глубина сравнивается через GL_EQUAL
+//   OVERDRAW          — вместо цвета постоянная доля на фрагмент; при аддитивном смешивании
+//                       яркость пикселя показывает, сколько раз он закрашивался
+#ifdef MULTI_DRAW
+#extension GL_ARB_shader_draw_parameters : require
+#extension GL_ARB_shader_storage_buffer_object : require
+#endif
+
+#ifndef LIGHT_COUNT
+#define LIGHT_COUNT 2
+#endif
+
+uniform mat4 view;
+uniform mat4 projection;
+#ifdef MULTI_DRAW
+// Пакет рисует команды drawBase..drawBase + n - 1, gl_DrawID считается от нуля в каждом пакете
+struct DrawData {
+    mat4 model;
+    vec4 albedo;
+};
+layout(std430) readonly buffer DrawBuffer {
+    DrawData draws[];
+};
+uniform int drawBase;
+#ifdef VERTEX_SHADER
+#define model draws[drawBase + gl_DrawIDARB].model
+#define albedo draws[drawBase + gl_DrawIDARB].albedo.rgb
+flat out vec3 DrawAlbedo;
+#else
+flat in vec3 DrawAlbedo;
+#define albedo DrawAlbedo
+#endif
+#else
+uniform mat4 model;
+uniform vec3 albedo; // цвет материала
+#endif
+#ifdef LIGHTING_CLUSTERED
+uniform samplerBuffer lightData;       // (позиция, радиус), (цвет, 0) на источник
+uniform usamplerBuffer clusterData;    // (смещение, количество) на кластер
+uniform usamplerBuffer lightIndexData;
+uniform ivec3 clusterGridSize;
+uniform vec2 clusterDepthParams;
+#else
+uniform vec3 lights[LIGHT_COUNT];
+uniform vec3 lightColor;
+#endif
+
+#if defined(SHADING_GOURAUD) || defined(SHADING_UNLIT)
+#define VERTEX_COLOR
+#endif
+
+#ifdef SHADING_PROVOKING
+#define FACE_NORMAL flat
+#else
+#define FACE_NORMAL
+#endif
+
+#ifdef SHADING_GOURAUD
+const float lightScale = 1.0;
+#else
+const float lightScale = 1.25;
+#endif
+
+#ifdef LIGHTING_CLUSTERED
+vec3 computeLighting(vec3 position, vec3 normal) {
+    // Кластер ищется по самой точке, поэтому одинаково работает и для вершин, и для фрагментов
+    vec4 viewPosition = view * vec4(position, 1.0);
+    vec4 clip = projection * viewPosition;
+    vec2 ndc = clip.xy / max(abs(clip.w), 1e-4);
+    ivec2 tile = clamp(ivec2((ndc * 0.5 + 0.5) * vec2(clusterGridSize.xy)), ivec2(0), clusterGridSize.xy - 1);
+    float depth = max(-viewPosition.z, 1e-4);
+    int slice = clamp(int(log(depth) * clusterDepthParams.x + clusterDepthParams.y), 0, clusterGridSize.z - 1);
+    uvec2 cluster = texelFetch(clusterData, (slice * clusterGridSize.y + tile.y) * clusterGridSize.x + tile.x).xy;
+
+    vec3 result = vec3(0.0);
+    for (uint i = 0u; i < cluster.y; ++i) {
+        int light = int(texelFetch(lightIndexData, int(cluster.x + i)).r);
+        vec4 positionRadius = texelFetch(lightData, light * 2);
+        vec3 color = texelFetch(lightData, light * 2 + 1).rgb;
+
+        vec3 toLight = positionRadius.xyz - position;
+        float distance = length(toLight);
+        float attenuation = clamp(1.0 - distance / positionRadius.w, 0.0, 1.0);
+        float diff = max(dot(normal, toLight / max(distance, 1e-4)), 0.0);
+        result += diff * attenuation * attenuation * color * lightScale;
+    }
+    return result;
+}
+#else
+vec3 computeLighting(vec3 position, vec3 normal) {
+    vec3 result = vec3(0.0);
+    for (int i = 0; i < LIGHT_COUNT; ++i) {
+#ifdef LIGHT_DIRECTIONAL
+        vec3 lightDir = normalize(lights[i]);
+#else
+        vec3 lightDir = normalize(lights[i] - position);
+#endif
+        float diff = max(dot(normal, lightDir), 0.0);
+        result += diff * lightColor * lightScale;
+    }
+    return result;
+}
+#endif
+
+#ifdef VERTEX_SHADER
+#ifdef DEFERRED_LIGHTING
+void main() {
+    // Треугольник (-1,-1), (3,-1), (-1,3) накрывает весь экран
+    vec2 corner = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2);
+    gl_Position = vec4(corner * 2.0 - 1.0, 0.0, 1.0);
+}
+#else
+layout(location = 0) in vec3 aPos;
+#ifndef DEPTH_ONLY
+layout(location = 1) in vec3 aNormal;
+#ifdef SHADING_UNLIT
+layout(location = 2) in vec3 aColor;
+#endif
+
+#ifdef VERTEX_COLOR
+out vec3 Color;
+#else
+out vec3 FragPos;
+FACE_NORMAL out vec3 Normal;
+#endif
+#endif
+
+#if defined(DEPTH_ONLY) || defined(DEPTH_PREPASS)
+// GL_EQUAL требует, чтобы позиция в обеих программах считалась одинаково до бита
+invariant gl_Position;
+#endif
+
+void main() {
+    vec3 position = vec3(model * vec4(aPos, 1.0));
+#ifndef DEPTH_ONLY
+    vec3 normal = mat3(transpose(inverse(model))) * aNormal;
+#ifdef MULTI_DRAW
+    DrawAlbedo = albedo;
+#endif
+#if defined(SHADING_UNLIT)
+    Color = aColor * albedo;
+#elif defined(SHADING_GOURAUD)
+    Color = computeLighting(position, normalize(normal)) * albedo;
+#else
+    FragPos = position;
+    Normal = normal;
+#endif
+#endif
+    gl_Position = projection * view * vec4(position, 1.0);
+}
+#endif
+#endif
+
+#ifdef FRAGMENT_SHADER
+#if defined(DEPTH_ONLY)
+void main() {
+}
+#elif defined(DEFERRED_GEOMETRY)
+in vec3 FragPos;
+FACE_NORMAL in vec3 Normal;
+
+layout(location = 0) out vec4 gPosition;
+layout(location = 1) out vec4 gNormal;
+layout(location = 2) out vec4 gAlbedo;
+
+void main() {
+    gPosition = vec4(FragPos, 1.0);
+    gNormal = vec4(normalize(Normal), 0.0);
+    gAlbedo = vec4(albedo, 1.0);
+}
+#elif defined(DEFERRED_LIGHTING)
+uniform sampler2D gPosition;
+uniform sampler2D gNormal;
+uniform sampler2D gAlbedo;
+
+out vec4 FragColor;
+
+void main() {
+    ivec2 coord = ivec2(gl_FragCoord.xy);
+    vec4 surface = texelFetch(gAlbedo, coord, 0);
+    if (surface.a == 0.0)
+        discard;
+    vec3 position = texelFetch(gPosition, coord, 0).xyz;
+    vec3 normal = normalize(texelFetch(gNormal, coord, 0).xyz);
+    FragColor = vec4(computeLighting(position, normal) * surface.rgb, 1.0);
+}
+#else
+#ifdef VERTEX_COLOR
+in vec3 Color;
+#else
+in vec3 FragPos;
+FACE_NORMAL in vec3 Normal;
+#endif
+
+out vec4 FragColor;
+
+#ifdef OVERDRAW
+const vec3 overdrawStep = vec3(0.25, 0.12, 0.05);
+#endif
+
+void main() {
+#if defined(OVERDRAW)
+    FragColor = vec4(overdrawStep, 1.0);
+#elif defined(VERTEX_COLOR)
+    FragColor = vec4(Color, 1.0);
+#else
+    FragColor = vec4(computeLighting(FragPos, normalize(Normal)) * albedo, 1.0);
+#endif
+}
+#endif
+#endif
@@ -0,0 +1,179 @@
+// meshpack — упаковка мешей в сжатый формат .cmesh (common/mesh_codec.hpp) и обратно.
+//
+//   ./meshpack.out pack модель.obj|ply модель.cmesh [--position-bits n] [--normal-bits n]
+//   ./meshpack.out unpack модель.cmesh модель.ply
+//
+// pack печатает степень сжатия и наибольшую ошибку позиций после квантования, unpack —
+// время разбора и пишет binary PLY, который снова читает loadMesh.
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "../../common/args.hpp"
+#include "../../common/mesh_codec.hpp"
+#include "../../common/mesh_loader.hpp"
+
+typedef std::chrono::steady_clock Clock;
+
+double millisecondsSince(Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+std::vector<std::string> positionalArgs(int argc, char** argv) {
+    std::vector<std::string> args;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strncmp(argv[i], "--", 2) == 0) {
+            ++i; // значение флага
+            continue;
+        }
+        args.push_back(argv[i]);
+    }
+    return args;
+}
+
+bool readFile(const std::string& path, std::vector<uint8_t>& data) {
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file)
+        return false;
+    data.resize((size_t)file.tellg());
+    file.seekg(0);
+    return (bool)file.read((char*)data.data(), data.size());
+}
+
+bool writeFile(const std::string& path, const std::vector<uint8_t>& data) {
+    std::ofstream file(path, std::ios::binary);
+    file.write((const char*)data.data(), data.size());
+    return (bool)file;
+}
+
+bool writePly(const std::string& path, const MeshData& mesh) {
+    std::ofstream file(path, std::ios::binary);
+    size_t vertexCount = mesh.vertices.size() / meshVertexFloats;
+    size_t triangleCount = mesh.indices.size() / 3;
+    file << "ply\nformat binary_little_endian 1.0\n"
+         << "element vertex " << vertexCount << "\n"
+         << "property float x\nproperty float y\nproperty float z\n"
+         << "property float nx\nproperty float ny\nproperty float nz\n"
+         << "element face " << triangleCount << "\n"
+         << "property list uchar uint vertex_indices\nend_header\n";
+    file.write((const char*)mesh.vertices.data(), mesh.vertices.size() * sizeof(GLfloat));
+
+    // Грань: счётчик байтом и три индекса
+    std::vector<uint8_t> faces(triangleCount * 13);
+    for (size_t t = 0; t < triangleCount; ++t) {
+        faces[t * 13] = 3;
+        std::memcpy(&faces[t * 13 + 1], &mesh.indices[t * 3], 3 * sizeof(GLuint));
+    }
+    file.write((const char*)faces.data(), faces.size());
+    return (bool)file;
+}
+
+size_t rawBytes(const MeshData& mesh) {
+    return mesh.vertices.size() * sizeof(GLfloat) + mesh.indices.size() * sizeof(GLuint);
+}
+
+glm::vec3 vertexPosition(const MeshData& mesh, GLuint index) {
+    const GLfloat* p = &mesh.vertices[index * meshVertexFloats];
+    return glm::vec3(p[0], p[1], p[2]);
+}
+
+// Распакованный треугольник — исходный с другой начальной вершиной; берётся лучший поворот
+float maxPositionError(const MeshData& source, const MeshData& decoded) {
+    float maxError = 0.0f;
+    for (size_t t = 0; t < source.indices.size() / 3; ++t) {
+        float best = 1e30f;
+        for (int rotation = 0; rotation < 3; ++rotation) {
+            float error = 0.0f;
+            for (int corner = 0; corner < 3; ++corner) {
+                glm::vec3 a = vertexPosition(source, source.indices[t * 3 + corner]);
+                glm::vec3 b = vertexPosition(decoded, decoded.indices[t * 3 + (corner + rotation) % 3]);
+                error = std::max(error, glm::length(a - b));
+            }
+            best = std::min(best, error);
+        }
+        maxError = std::max(maxError, best);
+    }
+    return maxError;
+}
+
+int pack(const std::string& input, const std::string& output, const MeshCodecOptions& options) {
+    MeshData mesh;
+    if (!loadMesh(input, mesh, false))
+        return 1;
+
+    Clock::time_point start = Clock::now();
+    std::vector<uint8_t> packed;
+    if (!encodeMesh(mesh, packed, options)) {
+        std::cerr << "Cannot encode " << input << ": invalid indices or bit counts" << std::endl;
+        return 1;
+    }
+    double encodeMs = millisecondsSince(start);
+    if (!writeFile(output, packed)) {
+        std::cerr << "Cannot write " << output << std::endl;
+        return 1;
+    }
+
+    MeshData decoded;
+    if (!decodeMesh(packed.data(), packed.size(), decoded) || decoded.indices.size() != mesh.indices.size()) {
+        std::cerr << "Packed mesh does not decode" << std::endl;
+        return 1;
+    }
+    float extent = glm::length(mesh.boundsMax - mesh.boundsMin);
+    float error = maxPositionError(mesh, decoded);
+    std::printf("%zu vertices, %zu triangles: %zu -> %zu bytes (%.2fx) in %.1f ms\n", mesh.vertices.size() / meshVertexFloats,
+                mesh.indices.size() / 3, rawBytes(mesh), packed.size(), (double)rawBytes(mesh) / packed.size(), encodeMs);
+    std::printf("max position error %g (%.4f%% of the bounding box diagonal)\n", error, extent > 0.0f ? 100.0f * error / extent : 0.0f);
+    return 0;
+}
+
+int unpack(const std::string& input, const std::string& output) {
+    Clock::time_point start = Clock::now();
+    std::vector<uint8_t> packed;
+    if (!readFile(input, packed)) {
+        std::cerr << "Cannot read " << input << std::endl;
+        return 1;
+    }
+    double readMs = millisecondsSince(start);
+
+    start = Clock::now();
+    MeshData mesh;
+    if (!decodeMesh(packed.data(), packed.size(), mesh)) {
+        std::cerr << "Malformed compressed mesh " << input << std::endl;
+        return 1;
+    }
+    double decodeMs = millisecondsSince(start);
+    if (!writePly(output, mesh)) {
+        std::cerr << "Cannot write " << output << std::endl;
+        return 1;
+    }
+
+    std::printf("%zu vertices, %zu triangles: read %zu bytes in %.2f ms, decoded in %.2f ms (%.0f MB/s of raw mesh data)\n",
+                mesh.vertices.size() / meshVertexFloats, mesh.indices.size() / 3, packed.size(), readMs, decodeMs,
+                decodeMs > 0.0 ? rawBytes(mesh) / (decodeMs * 1000.0) : 0.0);
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    std::vector<std::string> args = positionalArgs(argc, argv);
+    if (args.size() != 3 || (args[0] != "pack" && args[0] != "unpack")) {
+        std::cerr << "Usage: meshpack.out pack input.obj|ply output.cmesh [--position-bits n] [--normal-bits n]\n"
+                  << "       meshpack.out unpack input.cmesh output.ply" << std::endl;
+        return 1;
+    }
+
+    if (args[0] == "unpack")
+        return unpack(args[1], args[2]);
+
+    MeshCodecOptions options;
+    options.positionBits = std::atoi(getArg(argc, argv, "--position-bits", std::to_string(options.positionBits)).c_str());
+    options.normalBits = std::atoi(getArg(argc, argv, "--normal-bits", std::to_string(options.normalBits)).c_str());
+    return pack(args[1], args[2], options);
+}
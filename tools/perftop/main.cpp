@@ -0,0 +1,115 @@
+// perftop — счётчики запущенной лабораторной, как top: раз в интервал печатает значения
+// последнего кадра, скорость за интервал и суммы с запуска.
+//
+//   ./perftop.out [pid] [--interval мс]
+//
+// Без pid берёт первый живой процесс с сегментом /dev/shm/cglabs-perf-*.
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <signal.h>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../../common/args.hpp"
+#include "../../common/perf_counters.hpp"
+
+bool processAlive(int pid) {
+    return kill(pid, 0) == 0 || errno == EPERM;
+}
+
+std::vector<int> findLabProcesses() {
+    const std::string prefix = "cglabs-perf-";
+    std::vector<int> pids;
+    std::error_code error;
+    for (const auto& entry : std::filesystem::directory_iterator("/dev/shm", error)) {
+        std::string name = entry.path().filename().string();
+        if (name.compare(0, prefix.size(), prefix) != 0)
+            continue;
+        int pid = std::atoi(name.c_str() + prefix.size());
+        if (pid > 0 && processAlive(pid))
+            pids.push_back(pid);
+    }
+    return pids;
+}
+
+int positionalPid(int argc, char** argv) {
+    for (int i = 1; i < argc; ++i) {
+        if (std::strncmp(argv[i], "--", 2) == 0) {
+            ++i; // значение флага
+            continue;
+        }
+        return std::atoi(argv[i]);
+    }
+    return 0;
+}
+
+void printSample(const PerfCounterBlock& block, const PerfSnapshot& current, const PerfSnapshot& previous, double seconds) {
+    uint64_t frames = current.totals[(int)PerfCounter::Frames] - previous.totals[(int)PerfCounter::Frames];
+    uint64_t frameTime = current.totals[(int)PerfCounter::FrameTime] - previous.totals[(int)PerfCounter::FrameTime];
+
+    std::printf("\033[H\033[2J");
+    std::printf("pid %d: %.1f fps, frame %.2f ms\n\n", block.pid, frames / seconds,
+                frames > 0 ? frameTime / 1000.0 / frames : 0.0);
+    std::printf("%-18s %14s %16s %18s\n", "counter", "last frame", "per second", "total");
+    for (int i = 0; i < perfCounterCount; ++i) {
+        double rate = (current.totals[i] - previous.totals[i]) / seconds;
+        std::printf("%-18s %14llu %16.1f %18llu\n", block.names[i], (unsigned long long)current.lastFrame[i], rate,
+                    (unsigned long long)current.totals[i]);
+    }
+    std::fflush(stdout);
+}
+
+int main(int argc, char** argv) {
+    int pid = positionalPid(argc, argv);
+    int intervalMs = std::max(50, std::atoi(getArg(argc, argv, "--interval", "1000").c_str()));
+
+    if (pid == 0) {
+        std::vector<int> pids = findLabProcesses();
+        if (pids.empty()) {
+            std::cerr << "No running lab publishes performance counters" << std::endl;
+            return 1;
+        }
+        if (pids.size() > 1) {
+            std::cerr << "Several labs are running:";
+            for (int other : pids)
+                std::cerr << " " << other;
+            std::cerr << "; watching " << pids[0] << std::endl;
+        }
+        pid = pids[0];
+    }
+
+    const PerfCounterBlock* block = attachPerfCounters(pid);
+    if (!block) {
+        std::cerr << "No performance counters for process " << pid << std::endl;
+        return 1;
+    }
+
+    PerfSnapshot previous;
+    if (!readPerfCounters(*block, previous)) {
+        std::cerr << "Counters of process " << pid << " are not readable" << std::endl;
+        detachPerfCounters(block);
+        return 1;
+    }
+    auto previousTime = std::chrono::steady_clock::now();
+
+    while (processAlive(pid)) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(intervalMs));
+        PerfSnapshot current;
+        if (!readPerfCounters(*block, current))
+            continue;
+        auto now = std::chrono::steady_clock::now();
+        printSample(*block, current, previous, std::chrono::duration<double>(now - previousTime).count());
+        previous = current;
+        previousTime = now;
+    }
+
+    std::cout << "Process " << pid << " exited" << std::endl;
+    detachPerfCounters(block);
+    return 0;
+}